@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vdp {
+namespace bench {
+
+// Number of global operator new calls since program start (all threads)
+uint64_t allocationCount();
+
+} // namespace bench
+} // namespace vdp
@@ -0,0 +1,56 @@
+//
+// ChannelManager benchmarks: aggregate parse throughput against the number of shards
+//
+#include "channel_manager.h"
+
+#include <benchmark/benchmark.h>
+#include <thread>
+
+using namespace vdp;
+
+namespace {
+
+constexpr size_t CHANNELS = 64;
+constexpr size_t BYTES_PER_CHANNEL = 16 * 1024;
+
+// Every channel gets BYTES_PER_CHANNEL of 64-byte frames per pass
+static void BM_ChannelManagerThroughput(benchmark::State& state) {
+    ChannelManagerConfig config;
+    config.shards = static_cast<size_t>(state.range(0));
+    config.result_capacity = 4096;
+    ChannelManager manager(CHANNELS, config);
+
+    VdpParser codec;
+    std::vector<uint8_t> stream, frame;
+    size_t frames = 0;
+    while (stream.size() + 64 <= BYTES_PER_CHANNEL) {
+        codec.serializeFrame({0x81, 0x10, std::vector<uint8_t>(58, static_cast<uint8_t>(frames))}, frame);
+        stream.insert(stream.end(), frame.begin(), frame.end());
+        ++frames;
+    }
+
+    for (auto _ : state) {
+        std::vector<size_t> offset(CHANNELS, 0);
+        size_t fed = 0, received = 0;
+        while (received < frames * CHANNELS) {
+            for (uint32_t channel = 0; fed < CHANNELS && channel < CHANNELS; ++channel) {
+                size_t& at = offset[channel];
+                if (at < stream.size()) {
+                    at += manager.feed(channel, stream.data() + at, stream.size() - at);
+                    fed += at == stream.size() ? 1 : 0;
+                }
+            }
+            const size_t polled = manager.poll([](const ChannelResult& result) { benchmark::DoNotOptimize(&result); });
+            if (polled == 0) {
+                std::this_thread::yield();
+            }
+            received += polled;
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(stream.size() * CHANNELS * state.iterations()));
+    state.counters["frames/s"] = benchmark::Counter(static_cast<double>(frames * CHANNELS * state.iterations()),
+                                                    benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ChannelManagerThroughput)->ArgName("shards")->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+} // namespace
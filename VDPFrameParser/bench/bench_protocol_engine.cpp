@@ -0,0 +1,197 @@
+//
+// VDPEngine benchmarks: request round-trip latency against a mock transport
+//
+#include "alloc_counter.h"
+#include "protocol_engine.h"
+
+#include <benchmark/benchmark.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace vdp;
+
+namespace {
+
+// Answers every request inline from send(), so the measured latency is the
+// engine's own request/match/complete path with no I/O wait.
+class EchoTransport : public transport::ITransport {
+public:
+    bool initialize(const std::string&) override { return true; }
+    bool send(const uint8_t* data, size_t length) override {
+        VdpFrame response{static_cast<uint8_t>(data[2] | RESPONSE_ECU_ID_MASK), data[3], {0x00, 0x12, 0x34}};
+        codec_.serializeFrame(response, reply_);
+        (void)length;
+        callback_(reply_.data(), reply_.size());
+        return true;
+    }
+    void setDataCallback(DataCallback callback) override { callback_ = std::move(callback); }
+    void setErrorCallback(ErrorCallback) override {}
+    bool isConnected() const override { return true; }
+    void disconnect() override {}
+    std::string getLastError() const override { return ""; }
+
+private:
+    DataCallback callback_;
+    VdpParser codec_;
+    std::vector<uint8_t> reply_;
+};
+
+// Simulated ECUs answering after a fixed latency, from a separate thread
+class DelayedEchoTransport : public transport::ITransport {
+public:
+    explicit DelayedEchoTransport(std::chrono::milliseconds latency) : latency_(latency) {
+        worker_ = std::thread([this] { run(); });
+    }
+    ~DelayedEchoTransport() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        worker_.join();
+    }
+
+    bool initialize(const std::string&) override { return true; }
+    bool send(const uint8_t* data, size_t) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        replies_.push_back({std::chrono::steady_clock::now() + latency_, static_cast<uint8_t>(data[2]), data[3]});
+        cv_.notify_one();
+        return true;
+    }
+    void setDataCallback(DataCallback callback) override { callback_ = std::move(callback); }
+    void setErrorCallback(ErrorCallback) override {}
+    bool isConnected() const override { return true; }
+    void disconnect() override {}
+    std::string getLastError() const override { return ""; }
+
+private:
+    struct Reply {
+        std::chrono::steady_clock::time_point due;
+        uint8_t ecu_id;
+        uint8_t command;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::vector<uint8_t> bytes;
+        while (!stop_) {
+            if (replies_.empty()) {
+                cv_.wait(lock);
+                continue;
+            }
+            Reply reply = replies_.front();
+            if (cv_.wait_until(lock, reply.due, [&] { return stop_; })) {
+                break;
+            }
+            replies_.pop_front();
+            lock.unlock();
+            codec_.serializeFrame({static_cast<uint8_t>(reply.ecu_id | RESPONSE_ECU_ID_MASK), reply.command, {0x00}},
+                                  bytes);
+            callback_(bytes.data(), bytes.size());
+            lock.lock();
+        }
+    }
+
+    std::chrono::milliseconds latency_;
+    DataCallback callback_;
+    VdpParser codec_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Reply> replies_;
+    bool stop_ = false;
+    std::thread worker_;
+};
+
+} // namespace
+
+static void BM_SendAndWaitRoundTrip(benchmark::State& state) {
+    protocol::VDPEngine engine(std::make_unique<EchoTransport>());
+    engine.initialize("echo");
+    engine.setInterFrameDelay(std::chrono::microseconds(0)); // measure the engine, not the pacing
+    protocol::Frame request{0x01, 0x10, {0x00, 0x01}};
+
+    uint64_t allocations_before = bench::allocationCount();
+    for (auto _ : state) {
+        auto response = engine.sendFrame(request, 100);
+        benchmark::DoNotOptimize(response.status);
+    }
+    state.counters["allocs/request"] = static_cast<double>(bench::allocationCount() - allocations_before) /
+                                       static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_SendAndWaitRoundTrip);
+
+// Response correlation with many requests outstanding across ECUs
+static void BM_PendingRequestMatch(benchmark::State& state) {
+    const int outstanding = static_cast<int>(state.range(0));
+    PendingRequestTable<uint32_t> table;
+    for (int i = 0; i < outstanding; ++i) {
+        table.insert(static_cast<uint8_t>(i % 128), 0x10, static_cast<uint32_t>(i));
+    }
+
+    uint64_t allocations_before = bench::allocationCount();
+    uint32_t next = 0;
+    for (auto _ : state) {
+        // Complete the oldest request of one ECU and issue its replacement
+        uint8_t ecu = static_cast<uint8_t>(next++ % 128);
+        uint32_t value = 0;
+        benchmark::DoNotOptimize(table.takeOldest(ecu | RESPONSE_ECU_ID_MASK, 0x10, value));
+        table.insert(ecu, 0x10, value);
+    }
+    state.counters["allocs/match"] = static_cast<double>(bench::allocationCount() - allocations_before) /
+                                     static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_PendingRequestMatch)->ArgName("outstanding")->Arg(128)->Arg(1024)->Arg(8192);
+
+// Arm and cancel a request timeout with many other timers armed, as on every request/response
+static void BM_TimerArmCancel(benchmark::State& state) {
+    TimerWheel wheel;
+    const auto now = TimerWheel::Clock::now();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        wheel.arm(now + std::chrono::milliseconds(100 + i % 900), static_cast<uint64_t>(i));
+    }
+
+    uint64_t allocations_before = bench::allocationCount();
+    for (auto _ : state) {
+        auto id = wheel.arm(now + std::chrono::milliseconds(100), 0);
+        benchmark::DoNotOptimize(wheel.cancel(id));
+    }
+    state.counters["allocs/timer"] = static_cast<double>(bench::allocationCount() - allocations_before) /
+                                     static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_TimerArmCancel)->ArgName("armed")->Arg(0)->Arg(1000)->Arg(30000);
+
+// Read one value from each of 16 ECUs answering after 20ms: one blocking
+// sendFrame() at a time versus one submitBatch() paced at 5ms
+static void BM_FullScan(benchmark::State& state) {
+    const bool batched = state.range(0) != 0;
+    protocol::VDPEngine engine(std::make_unique<DelayedEchoTransport>(std::chrono::milliseconds(20)));
+    engine.initialize("delayed-echo");
+
+    std::vector<protocol::Frame> frames;
+    for (uint8_t ecu = 1; ecu <= 16; ++ecu) {
+        frames.push_back({ecu, 0x10, {0x00, 0x01}});
+    }
+
+    for (auto _ : state) {
+        if (batched) {
+            std::mutex mtx;
+            std::condition_variable cv;
+            bool done = false;
+            engine.submitBatch(frames, [&](const std::vector<protocol::Response>&) {
+                std::lock_guard<std::mutex> lock(mtx);
+                done = true;
+                cv.notify_one();
+            });
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&] { return done; });
+        } else {
+            for (const auto& frame : frames) {
+                benchmark::DoNotOptimize(engine.sendFrame(frame, 100).status);
+            }
+        }
+    }
+    state.SetLabel(batched ? "submitBatch" : "sequential");
+}
+BENCHMARK(BM_FullScan)->ArgName("batched")->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
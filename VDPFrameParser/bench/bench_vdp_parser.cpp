@@ -0,0 +1,393 @@
+//
+// VdpParser benchmarks: throughput, resync cost and allocations per frame
+//
+#include "alloc_counter.h"
+#include "frame_log.h"
+#include "parallel_parse.h"
+#include "vdp_parser.h"
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+using namespace vdp;
+
+namespace {
+
+constexpr size_t STREAM_BYTES = 64 * 1024;
+constexpr size_t FEED_CHUNK = 4096;
+
+std::vector<uint8_t> makeFrameBytes(size_t frame_size, uint8_t seed) {
+    VdpParser codec;
+    VdpFrame frame{static_cast<uint8_t>(0x80 | (seed & 0x7F)), 0x10,
+                   std::vector<uint8_t>(frame_size - 6, static_cast<uint8_t>(seed))};
+    std::vector<uint8_t> bytes;
+    codec.serializeFrame(frame, bytes);
+    return bytes;
+}
+
+// Back-to-back frames of one size, about STREAM_BYTES long
+std::vector<uint8_t> makeStream(size_t frame_size, size_t& frame_count) {
+    std::vector<uint8_t> stream;
+    frame_count = 0;
+    while (stream.size() + frame_size <= STREAM_BYTES) {
+        auto frame = makeFrameBytes(frame_size, static_cast<uint8_t>(frame_count));
+        stream.insert(stream.end(), frame.begin(), frame.end());
+        ++frame_count;
+    }
+    return stream;
+}
+
+// Frames separated by long runs of line noise, including false 0x7E starts
+std::vector<uint8_t> makeNoisyStream(size_t& frame_count) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> byte_dist(0, 255);
+    std::vector<uint8_t> stream;
+    frame_count = 0;
+    while (stream.size() < STREAM_BYTES) {
+        for (int i = 0; i < 512; ++i) {
+            uint8_t b = static_cast<uint8_t>(byte_dist(rng));
+            // Mostly plain garbage, occasionally a start byte with a bogus length
+            stream.push_back(b == 0x7E && (i % 8) != 0 ? 0x00 : b);
+        }
+        auto frame = makeFrameBytes(32, static_cast<uint8_t>(frame_count++));
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    return stream;
+}
+
+void reportCounters(benchmark::State& state, size_t stream_bytes, size_t frames_per_pass, uint64_t allocations) {
+    const double frames = static_cast<double>(frames_per_pass) * static_cast<double>(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(stream_bytes * state.iterations()));
+    state.counters["frames/s"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+    state.counters["allocs/frame"] = frames > 0 ? static_cast<double>(allocations) / frames : 0.0;
+}
+
+enum class Api { Vector, Views, Batch };
+
+// Feed the whole stream in FEED_CHUNK slices, extracting after each slice
+size_t runPass(VdpParser& parser, const std::vector<uint8_t>& stream, size_t chunk, Api api, ParseBatch& batch) {
+    size_t results = 0;
+    for (size_t offset = 0; offset < stream.size(); offset += chunk) {
+        size_t n = std::min(chunk, stream.size() - offset);
+        parser.feed(stream.data() + offset, n);
+        switch (api) {
+            case Api::Vector: {
+                auto out = parser.extractFrames();
+                results += out.size();
+                benchmark::DoNotOptimize(out.data());
+                break;
+            }
+            case Api::Views:
+                results += parser.extractFrameViews([](const ParseResultView& view) {
+                    benchmark::DoNotOptimize(view.frame.data.data);
+                });
+                break;
+            case Api::Batch:
+                results += parser.extractFrames(batch);
+                benchmark::DoNotOptimize(batch.size());
+                break;
+        }
+    }
+    return results;
+}
+
+void runThroughput(benchmark::State& state, const std::vector<uint8_t>& stream, size_t frames,
+                   size_t chunk, Api api, bool timestamps = true) {
+    VdpParser parser;
+    parser.setTimestampCapture(timestamps);
+    ParseBatch batch;
+    runPass(parser, stream, chunk, api, batch); // warm up buffers
+
+    uint64_t allocations_before = bench::allocationCount();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(runPass(parser, stream, chunk, api, batch));
+    }
+    reportCounters(state, stream.size(), frames, bench::allocationCount() - allocations_before);
+}
+
+} // namespace
+
+// feed + extract throughput across frame sizes, for each extraction API
+static void BM_FeedExtract(benchmark::State& state) {
+    size_t frames = 0;
+    auto stream = makeStream(static_cast<size_t>(state.range(0)), frames);
+    runThroughput(state, stream, frames, FEED_CHUNK, static_cast<Api>(state.range(1)));
+}
+BENCHMARK(BM_FeedExtract)
+    ->ArgNames({"frame_size", "api"})
+    ->ArgsProduct({{6, 16, 64, 128, 253}, {static_cast<int>(Api::Vector), static_cast<int>(Api::Views),
+                                           static_cast<int>(Api::Batch)}});
+
+// Mostly line noise: measures resynchronization cost
+static void BM_GarbageHeavy(benchmark::State& state) {
+    size_t frames = 0;
+    auto stream = makeNoisyStream(frames);
+    runThroughput(state, stream, frames, FEED_CHUNK, static_cast<Api>(state.range(0)));
+}
+BENCHMARK(BM_GarbageHeavy)->ArgName("api")->DenseRange(0, 2);
+
+// Corrupted max-size frames whose DATA is all false starts, each frame
+// yields over a hundred rejected candidates; with and without coalescing
+static void BM_CorruptFrames(benchmark::State& state) {
+    VdpParser codec;
+    VdpFrame frame{0x81, 0x10, {}};
+    for (size_t i = 0; i < 247; ++i) {
+        frame.data.push_back(i % 2 == 0 ? 0x7E : 0x01);
+    }
+    std::vector<uint8_t> bytes;
+    codec.serializeFrame(frame, bytes);
+    bytes[bytes.size() - 2] ^= 0xFF;
+    std::vector<uint8_t> stream;
+    while (stream.size() + bytes.size() <= STREAM_BYTES) {
+        stream.insert(stream.end(), bytes.begin(), bytes.end());
+    }
+
+    VdpParser parser;
+    parser.setInvalidCoalescing(state.range(0) != 0);
+    ParseBatch batch;
+    runPass(parser, stream, FEED_CHUNK, Api::Views, batch);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(runPass(parser, stream, FEED_CHUNK, Api::Views, batch));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(stream.size() * state.iterations()));
+}
+BENCHMARK(BM_CorruptFrames)->ArgName("coalesce")->Arg(0)->Arg(1);
+
+#if defined(__linux__)
+// Transport-style ingest: read() FEED_CHUNK slices from a pipe into a scratch
+// buffer then feed(), or straight into prepareWrite()
+static void BM_ReceiveInPlace(benchmark::State& state) {
+    size_t frames = 0;
+    const std::vector<uint8_t> stream = makeStream(253, frames);
+    const bool in_place = state.range(0) != 0;
+    int pipe_fds[2];
+    if (::pipe(pipe_fds) != 0) {
+        state.SkipWithError("pipe failed");
+        return;
+    }
+    VdpParser parser;
+    std::vector<uint8_t> scratch(FEED_CHUNK);
+
+    for (auto _ : state) {
+        for (size_t offset = 0; offset < stream.size(); offset += FEED_CHUNK) {
+            const size_t n = std::min(FEED_CHUNK, stream.size() - offset);
+            benchmark::DoNotOptimize(::write(pipe_fds[1], stream.data() + offset, n));
+            if (in_place) {
+                auto lease = parser.prepareWrite(FEED_CHUNK);
+                const ssize_t received = ::read(pipe_fds[0], lease.data(), FEED_CHUNK);
+                lease.commit(received > 0 ? static_cast<size_t>(received) : 0);
+            } else {
+                const ssize_t received = ::read(pipe_fds[0], scratch.data(), scratch.size());
+                parser.feed(scratch.data(), received > 0 ? static_cast<size_t>(received) : 0);
+            }
+            parser.extractFrameViews([](const ParseResultView& view) {
+                benchmark::DoNotOptimize(view.frame.data.data);
+            });
+        }
+    }
+    ::close(pipe_fds[0]);
+    ::close(pipe_fds[1]);
+    state.SetBytesProcessed(static_cast<int64_t>(stream.size() * state.iterations()));
+}
+BENCHMARK(BM_ReceiveInPlace)->ArgName("in_place")->Arg(0)->Arg(1);
+#endif
+
+// One byte per feed/extract call, the worst case for per-call overhead (and per-feed clock reads)
+static void BM_ByteAtATime(benchmark::State& state) {
+    size_t frames = 0;
+    auto stream = makeStream(static_cast<size_t>(state.range(0)), frames);
+    stream.resize(4096 - 4096 % static_cast<size_t>(state.range(0)));
+    frames = stream.size() / static_cast<size_t>(state.range(0));
+    runThroughput(state, stream, frames, 1, Api::Views, state.range(1) != 0);
+}
+BENCHMARK(BM_ByteAtATime)->ArgNames({"frame_size", "timestamps"})->ArgsProduct({{16, 253}, {0, 1}});
+
+// Back-to-back maximum-size frames delivered in one large read
+static void BM_BackToBackMaxFrames(benchmark::State& state) {
+    size_t frames = 0;
+    auto stream = makeStream(253, frames);
+    runThroughput(state, stream, frames, stream.size(), static_cast<Api>(state.range(0)));
+}
+BENCHMARK(BM_BackToBackMaxFrames)->ArgName("api")->DenseRange(0, 2);
+
+// Owning copies of every parsed frame: global heap vs PayloadPool-backed DATA
+static void BM_OwningFrames(benchmark::State& state) {
+    const bool pooled = state.range(1) != 0;
+    size_t frames = 0;
+    auto stream = makeStream(static_cast<size_t>(state.range(0)), frames);
+    VdpParser parser;
+    PoolAllocator<uint8_t> allocator;
+    std::vector<VdpFrame> owned;
+    std::vector<PooledVdpFrame> owned_pooled;
+    owned.reserve(frames);
+    owned_pooled.reserve(frames);
+
+    auto pass = [&] {
+        parser.feed(stream.data(), stream.size());
+        parser.extractFrameViews([&](const ParseResultView& view) {
+            if (pooled) {
+                owned_pooled.push_back(view.frame.toFrame(allocator));
+            } else {
+                owned.push_back(view.frame.toFrame());
+            }
+        });
+        benchmark::DoNotOptimize(owned.data());
+        benchmark::DoNotOptimize(owned_pooled.data());
+        owned.clear();
+        owned_pooled.clear();
+    };
+    pass(); // warm up buffers and the pool
+
+    uint64_t allocations_before = bench::allocationCount();
+    for (auto _ : state) {
+        pass();
+    }
+    state.SetLabel(pooled ? "pool" : "heap");
+    reportCounters(state, stream.size(), frames, bench::allocationCount() - allocations_before);
+}
+BENCHMARK(BM_OwningFrames)->ArgNames({"frame_size", "pooled"})->ArgsProduct({{16, 253}, {0, 1}});
+
+static void BM_InlineResults(benchmark::State& state) {
+    size_t frames = 0;
+    auto stream = makeStream(static_cast<size_t>(state.range(0)), frames);
+    VdpParser parser;
+    // Drained through a small reused array, which stays in cache
+    std::vector<InlineParseResult> results(64);
+
+    auto pass = [&] {
+        parser.feed(stream.data(), stream.size());
+        while (parser.extractFrames(results.data(), results.size()) != 0) {
+            benchmark::ClobberMemory();
+        }
+    };
+    pass(); // warm up buffers
+
+    uint64_t allocations_before = bench::allocationCount();
+    for (auto _ : state) {
+        pass();
+    }
+    reportCounters(state, stream.size(), frames, bench::allocationCount() - allocations_before);
+}
+BENCHMARK(BM_InlineResults)->ArgName("frame_size")->Arg(16)->Arg(253);
+
+static void BM_SerializeFrame(benchmark::State& state) {
+    VdpParser codec;
+    VdpFrame frame{0x01, 0x10, std::vector<uint8_t>(static_cast<size_t>(state.range(0)) - 6, 0x5A)};
+    std::vector<uint8_t> out;
+    codec.serializeFrame(frame, out);
+
+    uint64_t allocations_before = bench::allocationCount();
+    for (auto _ : state) {
+        codec.serializeFrame(frame, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    reportCounters(state, out.size(), 1, bench::allocationCount() - allocations_before);
+}
+BENCHMARK(BM_SerializeFrame)->ArgName("frame_size")->Arg(6)->Arg(64)->Arg(253);
+
+static void BM_SerializeInto(benchmark::State& state) {
+    VdpParser codec;
+    VdpFrame frame{0x01, 0x10, std::vector<uint8_t>(static_cast<size_t>(state.range(0)) - 6, 0x5A)};
+    uint8_t out[MAX_SERIALIZED_FRAME_SIZE];
+
+    uint64_t allocations_before = bench::allocationCount();
+    size_t size = 0;
+    for (auto _ : state) {
+        size = codec.serializeInto(frame, out, sizeof(out));
+        benchmark::DoNotOptimize(out);
+    }
+    reportCounters(state, size, 1, bench::allocationCount() - allocations_before);
+}
+BENCHMARK(BM_SerializeInto)->ArgName("frame_size")->Arg(6)->Arg(64)->Arg(253);
+
+// Producer thread feeds while the benchmark thread extracts: Locked vs Spsc mode
+static void BM_ConcurrentFeedExtract(benchmark::State& state) {
+    const auto mode = state.range(0) == 0 ? ConcurrencyMode::Locked : ConcurrencyMode::Spsc;
+    size_t frames_per_pass = 0;
+    auto stream = makeStream(32, frames_per_pass);
+
+    for (auto _ : state) {
+        VdpParser parser(std::chrono::seconds(1), mode);
+        std::thread producer([&] {
+            for (size_t offset = 0; offset < stream.size(); offset += 256) {
+                parser.feed(stream.data() + offset, std::min<size_t>(256, stream.size() - offset));
+            }
+        });
+        size_t parsed = 0;
+        while (parsed < frames_per_pass) {
+            parsed += parser.extractFrameViews([](const ParseResultView&) {});
+        }
+        producer.join();
+    }
+    state.SetLabel(mode == ConcurrencyMode::Locked ? "locked" : "spsc");
+    state.SetBytesProcessed(static_cast<int64_t>(stream.size() * state.iterations()));
+    state.counters["frames/s"] = benchmark::Counter(
+        static_cast<double>(frames_per_pass * state.iterations()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ConcurrentFeedExtract)->ArgName("spsc")->Arg(0)->Arg(1)->UseRealTime();
+
+// Offline parse of a 16 MB capture: sequential feed/extract vs parallelParseViews() on N threads
+static void BM_ParallelParse(benchmark::State& state) {
+    const size_t threads = static_cast<size_t>(state.range(0));
+    size_t frames_per_copy = 0;
+    const auto stream = makeNoisyStream(frames_per_copy);
+    std::vector<uint8_t> capture;
+    while (capture.size() < 16 * 1024 * 1024) {
+        capture.insert(capture.end(), stream.begin(), stream.end());
+    }
+
+    size_t results = 0;
+    for (auto _ : state) {
+        if (threads == 0) {
+            VdpParser parser;
+            parser.feed(capture.data(), capture.size());
+            results = parser.extractFrameViews([](const ParseResultView&) {});
+        } else {
+            results = parallelParseViews({capture.data(), capture.size()}, threads).size();
+        }
+        benchmark::DoNotOptimize(results);
+    }
+    state.SetLabel(threads == 0 ? "sequential" : "parallel");
+    state.SetBytesProcessed(static_cast<int64_t>(capture.size() * state.iterations()));
+    state.counters["results"] = static_cast<double>(results);
+}
+BENCHMARK(BM_ParallelParse)->ArgName("threads")->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Parsing a noisy stream with every result recorded to a frame log on /dev/null, vs not recording
+static void BM_FrameLogRecord(benchmark::State& state) {
+    const bool recording = state.range(0) != 0;
+    size_t frames_per_pass = 0;
+    const auto stream = makeNoisyStream(frames_per_pass);
+    VdpParser parser;
+    FrameLogWriter writer;
+    std::string error;
+    if (recording && !writer.open("/dev/null", {}, error)) {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+
+    uint64_t allocations_before = bench::allocationCount();
+    size_t results = 0;
+    for (auto _ : state) {
+        const auto timestamp = std::chrono::system_clock::now();
+        for (size_t offset = 0; offset < stream.size(); offset += FEED_CHUNK) {
+            parser.feed(stream.data() + offset, std::min(FEED_CHUNK, stream.size() - offset));
+            results += parser.extractFrameViews([&](const ParseResultView& result) {
+                writer.record(result, timestamp);
+            });
+        }
+    }
+    writer.close();
+    state.SetLabel(recording ? "recording" : "parse only");
+    reportCounters(state, stream.size(), frames_per_pass, bench::allocationCount() - allocations_before);
+    state.counters["results"] = static_cast<double>(results) / static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_FrameLogRecord)->ArgName("record")->Arg(0)->Arg(1);
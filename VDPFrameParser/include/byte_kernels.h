@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vdp {
+namespace kernels {
+
+/**
+ * @brief One implementation of the parser's byte-level hot loops
+ *
+ * Every set computes exactly the same results; they only differ in the
+ * instruction set used. The best set for the running CPU is picked once,
+ * on first use.
+ */
+struct KernelSet {
+    const char* name;
+
+    // Offset of the first byte equal to value in [data, data + len), or len if absent
+    size_t (*find_byte)(const uint8_t* data, size_t len, uint8_t value);
+
+    // XOR of all bytes in [data, data + len)
+    uint8_t (*xor_reduce)(const uint8_t* data, size_t len);
+
+    // Copy len bytes from src to dst and return their XOR, in a single pass
+    uint8_t (*copy_xor)(uint8_t* dst, const uint8_t* src, size_t len);
+};
+
+/**
+ * @brief Kernel set selected for this CPU (AVX2, SSE2, NEON or scalar)
+ */
+const KernelSet& activeKernels();
+
+/**
+ * @brief All kernel sets this CPU can run, scalar first
+ * @note Intended for tests and benchmarks comparing implementations
+ */
+std::vector<KernelSet> availableKernels();
+
+inline size_t findByte(const uint8_t* data, size_t len, uint8_t value) {
+    return activeKernels().find_byte(data, len, value);
+}
+
+inline uint8_t xorReduce(const uint8_t* data, size_t len) {
+    return activeKernels().xor_reduce(data, len);
+}
+
+inline uint8_t copyXor(uint8_t* dst, const uint8_t* src, size_t len) {
+    return activeKernels().copy_xor(dst, src, len);
+}
+
+} // namespace kernels
+} // namespace vdp
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "fd_transport.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace vdp {
+namespace transport {
+
+/**
+ * @brief Addressing and framing of VDP over CAN
+ *
+ * Each VDP ECU_ID byte gets its own CAN ID, base_id | ECU_ID: with the
+ * default base, requests to ECU 0x01 use 0x701 and its responses (ECU_ID
+ * 0x81) arrive on 0x781. A VDP frame is sent as consecutive CAN payloads on
+ * that ID, 8 bytes each (64 with CAN-FD); the last one is padded.
+ */
+struct CanConfig {
+    uint32_t base_id = 0x700;           // low 8 bits must be zero; above 0x7FF extended IDs are used
+    bool fd = false;                    // CAN-FD with 64-byte payloads
+    std::vector<uint8_t> ecu_filter;    // receive responses of these ECUs only (empty: all ECUs)
+};
+
+// Fills the last CAN-FD payload of a frame up to a valid length
+static constexpr uint8_t CAN_PADDING_BYTE = 0xCC;
+
+/**
+ * @brief Split a serialized frame into CAN payloads
+ *
+ * Calls emit(const uint8_t* data, size_t length) once per payload, in order.
+ * Payloads are at most max_payload bytes; the last one is padded with
+ * CAN_PADDING_BYTE up to a valid CAN-FD length when it exceeds 8 bytes.
+ */
+template <typename Emit>
+void segmentForCan(const IoSlice* slices, size_t count, size_t max_payload, Emit&& emit) {
+    // Serialized frames are at most 253 bytes, gather into one run
+    uint8_t frame[256];
+    size_t size = 0;
+    for (size_t i = 0; i < count && size < sizeof(frame); ++i) {
+        const size_t take = std::min(slices[i].length, sizeof(frame) - size);
+        if (take != 0) {
+            std::memcpy(frame + size, slices[i].data, take);
+            size += take;
+        }
+    }
+
+    uint8_t padded[64];
+    for (size_t offset = 0; offset < size; offset += max_payload) {
+        const size_t length = std::min(max_payload, size - offset);
+        if (length <= 8) {
+            emit(frame + offset, length);
+            continue;
+        }
+        // CAN-FD lengths above 8 go 12, 16, 20, 24, 32, 48, 64
+        static constexpr size_t FD_LENGTHS[] = {12, 16, 20, 24, 32, 48, 64};
+        size_t padded_length = 64;
+        for (size_t candidate : FD_LENGTHS) {
+            if (candidate >= length) {
+                padded_length = candidate;
+                break;
+            }
+        }
+        std::memcpy(padded, frame + offset, length);
+        std::memset(padded + length, CAN_PADDING_BYTE, padded_length - length);
+        emit(padded, padded_length);
+    }
+}
+
+/**
+ * @brief Reassembles VDP frames from CAN payloads, one channel per CAN ID
+ *
+ * Payloads of different ECUs may interleave on the bus, so bytes are
+ * collected per channel until the frame announced by its LEN byte is
+ * complete, and only whole frames are delivered. Bytes outside a frame
+ * (padding, or the rest of a frame whose start was lost) are delivered as
+ * they are, and the parser resynchronizes on them as on any byte stream.
+ * Fixed storage, no allocation.
+ */
+class CanReassembler {
+public:
+    static constexpr size_t CHANNELS = 256;  // indexed by the ECU_ID byte
+
+    /**
+     * @brief Add one CAN payload received on channel
+     * @param deliver Called as deliver(const uint8_t* data, size_t length)
+     */
+    template <typename Deliver>
+    void push(uint8_t channel, const uint8_t* data, size_t length, Deliver&& deliver) {
+        Partial& partial = partials_[channel];
+        while (length > 0) {
+            if (partial.size == 0 && data[0] != START_BYTE) {
+                // Not at a frame boundary, pass through up to the next START byte
+                const uint8_t* next = static_cast<const uint8_t*>(std::memchr(data, START_BYTE, length));
+                const size_t skip = next ? static_cast<size_t>(next - data) : length;
+                deliver(data, skip);
+                data += skip;
+                length -= skip;
+                continue;
+            }
+
+            // START and LEN first, then the rest of the frame LEN announces
+            const size_t needed = partial.size < 2 ? 2 : partial.bytes[1];
+            const size_t take = std::min(length, needed - partial.size);
+            std::memcpy(partial.bytes.data() + partial.size, data, take);
+            partial.size = static_cast<uint8_t>(partial.size + take);
+            data += take;
+            length -= take;
+            if (partial.size < 2) {
+                continue;
+            }
+
+            const size_t frame_length = partial.bytes[1];
+            if (frame_length < MIN_FRAME_LEN || frame_length > partial.bytes.size() ||
+                partial.size == frame_length) {
+                // Complete, or not a frame the parser would accept; either way it decides
+                deliver(partial.bytes.data(), partial.size);
+                partial.size = 0;
+            }
+        }
+    }
+
+    // Bytes held for an incomplete frame on channel
+    size_t pending(uint8_t channel) const { return partials_[channel].size; }
+
+    // Drop every incomplete frame
+    void reset() {
+        for (auto& partial : partials_) {
+            partial.size = 0;
+        }
+    }
+
+private:
+    static constexpr uint8_t START_BYTE = 0x7E;
+    static constexpr size_t MIN_FRAME_LEN = 6;
+
+    struct Partial {
+        std::array<uint8_t, 253> bytes;
+        uint8_t size = 0;
+    };
+    std::array<Partial, CHANNELS> partials_{};
+};
+
+/**
+ * @brief Linux SocketCAN adapter
+ *
+ * Connection string: the interface name, e.g. "can0". Only responses are
+ * received, through kernel filters on base_id | 0x80 | ECU (all ECUs or the
+ * configured ones). Received CAN frames are read up to RX_BATCH per
+ * recvmmsg() call; a VDP frame is sent with a single sendmmsg().
+ */
+class CanTransport : public FdTransport {
+public:
+    static constexpr size_t CLASSIC_PAYLOAD = 8;
+    static constexpr size_t FD_PAYLOAD = 64;
+    static constexpr size_t RX_BATCH = 32;
+
+    explicit CanTransport(CanConfig config = {}, EventLoop& loop = EventLoop::shared());
+    ~CanTransport() override;
+
+    bool sendv(const IoSlice* slices, size_t count) override;
+
+    const CanConfig& config() const { return config_; }
+
+protected:
+    int openDescriptor(const std::string& connection_string) override;
+    bool receive(int fd, std::string& error) override;
+
+private:
+    struct RxBatch;  // recvmmsg buffers, defined with the SocketCAN headers
+
+    CanConfig config_;
+    std::unique_ptr<CanReassembler> reassembler_;
+    std::unique_ptr<RxBatch> rx_;
+};
+
+} // namespace transport
+} // namespace vdp
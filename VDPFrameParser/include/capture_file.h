@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ring_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vdp {
+
+/**
+ * @brief Binary bus capture: a CaptureHeader followed by the raw received bytes
+ *
+ * Without flags, the payload is the byte stream exactly as it came off the
+ * bus, so a replay hands the mapped file to the parser without decoding it.
+ * With FRAME_LOG it is a frame log instead, see frame_log.h.
+ */
+struct CaptureHeader {
+    static constexpr char MAGIC[8] = {'V', 'D', 'P', 'C', 'A', 'P', '\r', '\n'};  // the CR LF catches text-mode copies
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t SIZE = 16;   // MAGIC, version, flags, reserved; little-endian
+
+    // Flags
+    static constexpr uint16_t FRAME_LOG = 0x0001;   // payload is timestamped frame records
+    static constexpr uint16_t LZ4 = 0x0002;         // frame records are in LZ4 blocks
+    static constexpr uint16_t KNOWN_FLAGS = FRAME_LOG | LZ4;
+};
+
+/**
+ * @brief Check for a capture header
+ * @param file Start of the file
+ * @param payload Set to the bytes after the header
+ * @param flags Set to the header flags; if null, only raw captures (no flags) are accepted
+ * @return false if file is not a capture of a supported version and flags
+ */
+bool parseCaptureHeader(ByteSpan file, ByteSpan& payload, uint16_t* flags = nullptr);
+
+// Header of a capture file of the current version
+std::vector<uint8_t> makeCaptureHeader(uint16_t flags = 0);
+
+/**
+ * @brief Decode a legacy .hex text capture
+ *
+ * Same rules as reading it line by line: '#' starts a comment, characters
+ * other than hex digits are ignored, and a line's stray last nibble is
+ * dropped. Table driven, one pass, no per-line allocation.
+ * @param out Decoded bytes are appended
+ * @return Number of bytes appended
+ */
+size_t decodeHex(ByteSpan text, std::vector<uint8_t>& out);
+
+/**
+ * @brief Read-only view of a whole file, memory-mapped where supported
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Map path, replacing any file mapped before
+     * @return false with error set if the file cannot be opened or mapped
+     */
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    ByteSpan bytes() const { return {data_, size_}; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<uint8_t> fallback_;   // contents read into memory where mmap is unavailable
+};
+
+} // namespace vdp
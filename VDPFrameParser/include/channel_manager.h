@@ -0,0 +1,209 @@
+#pragma once
+
+#include "pending_request_table.h"
+#include "spsc_ring.h"
+#include "vdp_parser.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vdp {
+
+/**
+ * @brief Sharding and sizing of a ChannelManager
+ */
+struct ChannelManagerConfig {
+    size_t shards = 0;                      // worker threads, 0: one per hardware thread
+    bool pin_threads = true;                // pin shard i to CPU i (Linux only)
+    size_t input_capacity = 64 * 1024;      // bytes buffered per channel by feed()
+    size_t expectation_capacity = 256;      // expect() records buffered per channel
+    size_t result_capacity = 1024;          // results buffered per shard until poll()
+    std::chrono::milliseconds frame_timeout = std::chrono::seconds(1);  // passed to each VdpParser
+    std::chrono::milliseconds expectation_timeout = std::chrono::seconds(1);  // unanswered expect() lifetime
+};
+
+// A result of one channel, as delivered by ChannelManager::poll()
+struct ChannelResult {
+    static constexpr uint64_t NO_TAG = UINT64_MAX;
+
+    uint32_t channel = 0;
+    uint64_t tag = NO_TAG;          // tag of the expect() this frame answers, NO_TAG if unsolicited
+    InlineParseResult result;
+};
+
+/**
+ * @brief Parses many diagnostic channels on a fixed set of worker threads
+ *
+ * Channels (one byte stream each, e.g. one vehicle) are spread round-robin
+ * over the shards. A shard's worker owns the VdpParser and the table of
+ * expected responses of each of its channels, so parsing takes no lock.
+ * Bytes reach a channel through its own lock-free ring, and results leave
+ * a shard through its own lock-free queue. Nothing is shared between shards
+ * besides channel ownership.
+ *
+ * A shard with several backlogged channels is rebalanced by work stealing:
+ * an idle shard takes over one of them. It starts parsing the channel once
+ * the results still queued by the previous owner have been polled, so the
+ * results of a channel stay in order.
+ *
+ * Threading: each channel has one producer thread at a time, which calls
+ * feed() and expect() for it. Each shard's results have one consumer
+ * thread at a time, poll(shard, ...) or poll(...) for all shards.
+ */
+class ChannelManager {
+public:
+    using ChannelId = uint32_t;
+
+    /**
+     * @param channel_count Channels, identified as 0 to channel_count - 1
+     */
+    explicit ChannelManager(size_t channel_count, ChannelManagerConfig config = {});
+    ~ChannelManager();
+
+    ChannelManager(const ChannelManager&) = delete;
+    ChannelManager& operator=(const ChannelManager&) = delete;
+
+    /**
+     * @brief Queue raw bytes received on a channel
+     * @return Bytes accepted, less than len while the channel's ring is full
+     */
+    size_t feed(ChannelId channel, const uint8_t* data, size_t len);
+
+    /**
+     * @brief Announce a response, call before sending the request that causes it
+     *
+     * The next frame from ecu_id (response bit ignored) with this command,
+     * or an ACK/NAK for it, is delivered with tag instead of NO_TAG. Without
+     * such a frame within expectation_timeout the expectation is dropped and
+     * counted by droppedExpectations().
+     * @return false when the channel's expectation ring is full
+     */
+    bool expect(ChannelId channel, uint8_t ecu_id, uint8_t command, uint64_t tag);
+
+    /**
+     * @brief Deliver the results of one shard to fn(const ChannelResult&)
+     * @return Number of results delivered
+     */
+    template <typename Fn>
+    size_t poll(size_t shard, Fn&& fn, size_t max = SIZE_MAX);
+
+    /**
+     * @brief Deliver the results of every shard to fn(const ChannelResult&)
+     * @return Number of results delivered
+     */
+    template <typename Fn>
+    size_t poll(Fn&& fn, size_t max_per_shard = SIZE_MAX);
+
+    size_t channelCount() const { return channels_.size(); }
+    size_t shardCount() const { return shards_.size(); }
+
+    // Shard currently owning a channel; changes when the channel is stolen
+    size_t shardOf(ChannelId channel) const { return channels_[channel]->shard.load(std::memory_order_relaxed); }
+
+    // Channels taken over by another shard so far
+    uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+    // Expectations dropped unanswered so far: timed out, or refused by a full table
+    uint64_t droppedExpectations() const { return dropped_expectations_.load(std::memory_order_relaxed); }
+
+private:
+    // Bytes parsed per channel before moving to the next one
+    static constexpr size_t QUANTUM = 16 * 1024;
+    // Idle passes before a worker sleeps
+    static constexpr int SPIN_PASSES = 64;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Expectation {
+        uint8_t ecu_id;
+        uint8_t command;
+        uint64_t tag;
+        Clock::time_point deadline;
+    };
+
+    struct PendingDeadline {
+        PendingRequestTable<uint64_t>::Handle handle;
+        Clock::time_point deadline;
+    };
+
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Channel {
+        Channel(const ChannelManagerConfig& config, uint32_t owner)
+            : input(config.input_capacity), expectations(config.expectation_capacity),
+              parser(config.frame_timeout), results_shard(owner), shard(owner) {}
+
+        SpscByteRing input;
+        SpscQueue<Expectation> expectations;
+        // Only touched by the worker holding busy
+        VdpParser parser;
+        PendingRequestTable<uint64_t> pending;
+        std::deque<PendingDeadline> deadlines;                   // pending entries in expect() order
+        bool backlog = false;
+        uint32_t results_shard;                                  // queue holding the undelivered results
+
+        alignas(CACHE_LINE) std::atomic<uint32_t> shard;         // owning shard
+        std::atomic<bool> busy{false};                           // claimed by a worker
+        std::atomic<uint32_t> undelivered{0};                    // results not yet polled
+    };
+
+    struct Shard {
+        explicit Shard(size_t result_capacity) : results(result_capacity) {}
+
+        SpscQueue<ChannelResult> results;
+        std::thread thread;
+
+        alignas(CACHE_LINE) std::atomic<uint32_t> backlogged{0};  // channels left with work after the last pass
+        std::atomic<bool> sleeping{false};
+        std::mutex sleep_mutex;                                   // only taken to sleep and wake
+        std::condition_variable wakeup;
+        bool signaled = false;                                    // set by wake(), guarded by sleep_mutex
+        std::vector<ChannelId> owned;                             // worker only: channels owned in its last pass
+    };
+
+    void run(uint32_t index);
+    // Parse one quantum of a claimed channel; true if any work was done
+    bool service(Channel& channel, ChannelId id, uint32_t shard_index);
+    // Drop the pending entries of a claimed channel whose deadline passed
+    void expireExpectations(Channel& channel);
+    // Take over a backlogged channel of a busier shard
+    bool steal(uint32_t thief);
+    // Wake the shard owning a channel after queuing work for it
+    void notifyOwner(Channel& channel);
+    void wake(Shard& shard);
+    // True if a channel the shard owned in its last pass has bytes or expectations queued
+    bool hasQueuedWork(const Shard& shard) const;
+
+    const ChannelManagerConfig config_;
+    std::vector<std::unique_ptr<Channel>> channels_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> steals_{0};
+    std::atomic<uint64_t> dropped_expectations_{0};
+};
+
+template <typename Fn>
+size_t ChannelManager::poll(size_t shard, Fn&& fn, size_t max) {
+    return shards_[shard]->results.consume([&](const ChannelResult& result) {
+        fn(result);
+        channels_[result.channel]->undelivered.fetch_sub(1, std::memory_order_release);
+    }, max);
+}
+
+template <typename Fn>
+size_t ChannelManager::poll(Fn&& fn, size_t max_per_shard) {
+    size_t count = 0;
+    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+        count += poll(shard, fn, max_per_shard);
+    }
+    return count;
+}
+
+} // namespace vdp
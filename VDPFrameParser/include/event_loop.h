@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace vdp {
+namespace transport {
+
+/**
+ * @brief Readiness loop shared by file-descriptor based transports
+ *
+ * One thread waits on epoll for every registered descriptor and runs the
+ * handler of each ready one, so a single thread services any number of
+ * adapters. Handlers run on the loop thread and must not block; they may
+ * add or remove descriptors, including their own.
+ *
+ * Linux only: on other platforms add() fails and the loop does nothing.
+ */
+class EventLoop {
+public:
+    // Readiness flags passed to add()/modify() and to handlers
+    static constexpr uint32_t READABLE = 1u << 0;
+    static constexpr uint32_t WRITABLE = 1u << 1;
+    static constexpr uint32_t HANGUP   = 1u << 2;   // peer closed or descriptor error, handlers only
+
+    using Handler = std::function<void(uint32_t events)>;
+
+    // Starts the loop thread
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * @brief Process-wide loop used by transports that are not given one
+     */
+    static EventLoop& shared();
+
+    /**
+     * @brief Watch a non-blocking descriptor (level-triggered)
+     * @param events READABLE and/or WRITABLE
+     * @return false if the descriptor could not be registered
+     */
+    bool add(int fd, uint32_t events, Handler handler);
+
+    // Change the events watched for a registered descriptor
+    bool modify(int fd, uint32_t events);
+
+    /**
+     * @brief Stop watching a descriptor
+     *
+     * Once this returns the handler is not running and will not be called
+     * again, so the caller may close the descriptor and free the handler's state.
+     * @note Does not close the descriptor
+     */
+    void remove(int fd);
+
+    bool inLoopThread() const { return std::this_thread::get_id() == thread_id_; }
+
+    // Number of registered descriptors
+    size_t size() const;
+
+private:
+    struct Registration {
+        int fd;
+        Handler handler;
+    };
+
+    void run();
+    void wake();
+
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;          // eventfd, interrupts epoll_wait on shutdown
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+    std::thread::id thread_id_;
+
+    // Registrations, looked up by descriptor for every event so removed ones are skipped
+    mutable std::mutex mutex_;
+    std::unordered_map<int, std::shared_ptr<Registration>> registrations_;
+
+    // Held by the loop thread while it runs handlers, remove() from other threads waits on it
+    std::mutex dispatch_mutex_;
+};
+
+} // namespace transport
+} // namespace vdp
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "event_loop.h"
+#include "transport_interface.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace vdp {
+namespace transport {
+
+/**
+ * @brief Base for transports backed by a non-blocking file descriptor
+ *
+ * The descriptor is registered with an EventLoop: received bytes are read
+ * on the loop thread into a fixed per-transport buffer and handed to the
+ * data callback straight from it, with no per-read allocation. With a
+ * receive buffer set, reads go straight into the consumer's memory instead. Sends write
+ * directly from the caller's buffers (writev for sendv()) and may be called
+ * from any thread; a send waits for the descriptor to drain at most
+ * SEND_TIMEOUT_MS.
+ *
+ * Set the callbacks before initialize(). They run on the loop thread, and
+ * must not block or call disconnect() on another loop-registered transport
+ * while holding a lock that a thread calling EventLoop::remove() may need.
+ */
+class FdTransport : public ITransport {
+public:
+    static constexpr size_t READ_BUFFER_SIZE = 4096;
+    static constexpr int SEND_TIMEOUT_MS = 1000;
+
+    explicit FdTransport(EventLoop& loop = EventLoop::shared());
+    ~FdTransport() override;
+
+    FdTransport(const FdTransport&) = delete;
+    FdTransport& operator=(const FdTransport&) = delete;
+
+    bool initialize(const std::string& connection_string) override;
+    bool send(const uint8_t* data, size_t length) override;
+    bool sendv(const IoSlice* slices, size_t count) override;
+    void setDataCallback(DataCallback callback) override;
+    bool setReceiveBuffer(ReceiveBuffer buffer) override;
+    void setErrorCallback(ErrorCallback callback) override;
+    bool isConnected() const override;
+    void disconnect() override;
+    std::string getLastError() const override;
+
+protected:
+    /**
+     * @brief Open and configure the descriptor described by connection_string
+     * @return A descriptor owned by this transport, or -1 after setLastError()
+     */
+    virtual int openDescriptor(const std::string& connection_string) = 0;
+
+    /**
+     * @brief Loop thread: read what is available and deliver() it
+     *
+     * The default reads once, into the receive buffer if one is set and
+     * the fixed buffer otherwise. Overrides must not block.
+     * @param error Receives the reason when returning false
+     * @return false if the descriptor failed or was closed by the peer
+     */
+    virtual bool receive(int fd, std::string& error);
+
+    // Pass received bytes to the data callback, or copy them into the receive buffer
+    void deliver(const uint8_t* data, size_t length);
+
+    // Serializes writes to the descriptor, held by sendv()
+    std::mutex& sendMutex() { return send_mutex_; }
+    // Open descriptor or -1, only stable while sendMutex() is held
+    int descriptor() const { return fd_; }
+
+    void setLastError(const std::string& error);
+
+    // Describe errno for error messages
+    static std::string systemError(const std::string& what);
+
+private:
+    // Loop thread: the descriptor is readable or hung up
+    void onEvents(int fd, uint32_t events);
+    // Tear down after a read error or hangup and report it
+    void fail(const std::string& error);
+    // Unregister and close the descriptor, returns false if it was already closed
+    bool closeDescriptor();
+
+    EventLoop& loop_;
+    DataCallback data_callback_;
+    ReceiveBuffer receive_buffer_;
+    ErrorCallback error_callback_;
+
+    // Guards fd_ and serializes writes so frames from different threads do not interleave
+    std::mutex send_mutex_;
+    int fd_ = -1;
+    std::atomic<bool> connected_{false};
+
+    mutable std::mutex error_mutex_;
+    std::string last_error_;
+
+    // Receive buffer, only touched by the loop thread
+    std::array<uint8_t, READ_BUFFER_SIZE> read_buffer_{};
+};
+
+/**
+ * @brief Serial/USB adapter through termios
+ *
+ * Connection string: "<device>[:<baud>]", e.g. "/dev/ttyUSB0:115200".
+ * The line is set to raw 8N1 without flow control; the baud rate defaults
+ * to 115200.
+ */
+class SerialTransport : public FdTransport {
+public:
+    static constexpr unsigned DEFAULT_BAUD_RATE = 115200;
+
+    using FdTransport::FdTransport;
+
+protected:
+    int openDescriptor(const std::string& connection_string) override;
+};
+
+/**
+ * @brief TCP stream carrying the plain VDP byte stream
+ *
+ * Connection string: "<host>[:<port>]", the port defaults to 13400. There
+ * is no DoIP message framing or routing activation, so the peer must
+ * accept raw VDP frames; TransportFactory creates it for Type::TCP, not
+ * DOIP. Nagle is disabled so requests leave immediately.
+ */
+class TcpTransport : public FdTransport {
+public:
+    static constexpr uint16_t DEFAULT_PORT = 13400;
+    static constexpr int CONNECT_TIMEOUT_MS = 3000;
+
+    using FdTransport::FdTransport;
+
+protected:
+    int openDescriptor(const std::string& connection_string) override;
+};
+
+} // namespace transport
+} // namespace vdp
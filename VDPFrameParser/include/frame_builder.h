@@ -0,0 +1,58 @@
+#pragma once
+
+#include "vdp_parser.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace vdp {
+
+/**
+ * @brief Serialize a frame whose fields are all known at compile time
+ *
+ * LEN and the XOR checksum are computed by the compiler; the result is the
+ * exact byte sequence serializeFrame() would produce, ready to be sent as is:
+ *
+ *     static constexpr auto KEEP_ALIVE = make_frame<0x01, CommandType::KeepAlive>();
+ *     transport.send(KEEP_ALIVE.data(), KEEP_ALIVE.size());
+ *
+ * @tparam EcuId Target ECU address
+ * @tparam Command Command byte
+ * @tparam Data Payload bytes, at most MAX_SERIALIZED_FRAME_SIZE - 6 of them
+ */
+template <uint8_t EcuId, CommandType Command, uint8_t... Data>
+constexpr std::array<uint8_t, sizeof...(Data) + 6> make_frame() {
+    constexpr size_t FRAME_LENGTH = sizeof...(Data) + 6; // [7E][LEN][ECU][CMD][DATA...][CHK][7F]
+    static_assert(FRAME_LENGTH <= MAX_SERIALIZED_FRAME_SIZE, "Frame data too large");
+
+    constexpr uint8_t length = static_cast<uint8_t>(FRAME_LENGTH);
+    constexpr uint8_t command = static_cast<uint8_t>(Command);
+    // XOR of all bytes after START
+    constexpr uint8_t checksum = static_cast<uint8_t>(((length ^ EcuId ^ command) ^ ... ^ Data));
+    return {0x7E, length, EcuId, command, Data..., checksum, 0x7F};
+}
+
+/**
+ * @brief Compile-time equivalent of VdpParser::createAckFrame() followed by serializeFrame()
+ * @tparam EcuId ECU the acknowledged frame came from
+ * @tparam Acked Command being acknowledged
+ */
+template <uint8_t EcuId, CommandType Acked>
+constexpr std::array<uint8_t, 7> make_ack_frame() {
+    return make_frame<EcuId, CommandType::Acknowledge, static_cast<uint8_t>(Acked)>();
+}
+
+/**
+ * @brief Compile-time equivalent of VdpParser::createNakFrame() followed by serializeFrame()
+ * @tparam EcuId ECU the rejected frame came from
+ * @tparam Rejected Command being rejected
+ * @tparam ErrorCode Status reported back, same default as createNakFrame()
+ */
+template <uint8_t EcuId, CommandType Rejected, ResponseStatus ErrorCode = ResponseStatus::InvalidCommand>
+constexpr std::array<uint8_t, 8> make_nak_frame() {
+    return make_frame<EcuId, CommandType::NegativeAck, static_cast<uint8_t>(Rejected),
+                      static_cast<uint8_t>(ErrorCode)>();
+}
+
+} // namespace vdp
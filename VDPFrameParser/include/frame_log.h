@@ -0,0 +1,172 @@
+#pragma once
+
+#include "capture_file.h"
+#include "vdp_parser.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vdp {
+
+/**
+ * Frame log: a capture (see capture_file.h) with the FRAME_LOG flag whose
+ * payload is a sequence of records, one per parse result:
+ *
+ *   varint  microseconds since the previous record, zigzag encoded
+ *           (the first record: since the epoch)
+ *   u8      LEN, number of raw bytes
+ *   u8      ParseError the result was rejected with, None for a frame;
+ *           bit 7 set: a varint count of coalesced candidates follows
+ *   LEN     the result's raw bytes, START byte first
+ *
+ * The raw bytes of a Stale result are a partial frame and those of a
+ * coalesced run only its first candidate, so the code and count are
+ * stored rather than recovered by parsing the bytes again.
+ *
+ * With the LZ4 flag the records are packed into blocks instead, each
+ * u32 record bytes, u32 compressed bytes and an LZ4 block (little-endian).
+ * Blocks hold whole records.
+ */
+struct FrameLogConfig {
+    size_t buffer_size = 256 * 1024;    // bytes per buffer, the writer has two
+    bool compress = false;              // LZ4 blocks, see frameLogCompressionAvailable()
+};
+
+// Whether the library was built with LZ4 (VDP_WITH_LZ4 and liblz4 found)
+bool frameLogCompressionAvailable();
+
+/**
+ * @brief Streams parse results into a frame log
+ *
+ * record() appends to one buffer while a background thread writes out the
+ * other, so the recording thread only waits for the disk when it fills a
+ * buffer before the previous one has been written.
+ *
+ * Threading: record() and flush() from one thread at a time.
+ */
+class FrameLogWriter {
+public:
+    FrameLogWriter() = default;
+    ~FrameLogWriter();
+
+    FrameLogWriter(const FrameLogWriter&) = delete;
+    FrameLogWriter& operator=(const FrameLogWriter&) = delete;
+
+    /**
+     * @brief Create path (truncating it) and start the flush thread
+     * @return false with error set if the file cannot be created or
+     *         compression is requested but not available
+     */
+    bool open(const std::string& path, FrameLogConfig config, std::string& error);
+
+    // Write out everything recorded and close the file
+    void close();
+
+    bool isOpen() const { return file_ != nullptr; }
+
+    /**
+     * @brief Append a result, results without raw bytes are skipped
+     *
+     * Without a timestamp, the result's own RxTimestamp is recorded.
+     */
+    void record(const ParseResultView& result, std::chrono::system_clock::time_point timestamp) {
+        record(result.raw_bytes, resultError(result.status, result.error), timestamp);
+    }
+    void record(const ParseResultView& result) {
+        record(result.raw_bytes, resultError(result.status, result.error), result.timestamp.toSystem());
+    }
+    void record(const ParseResult& result) {
+        record({result.raw_bytes.data(), result.raw_bytes.size()}, resultError(result.status, result.error_detail),
+               result.timestamp.toSystem());
+    }
+    // Raw bytes without a result, e.g. from another recorder: stored with ParseError::None
+    void record(ByteSpan raw_bytes, std::chrono::system_clock::time_point timestamp) {
+        record(raw_bytes, ParseErrorDetail{}, timestamp);
+    }
+    void record(ByteSpan raw_bytes, const ParseErrorDetail& error, std::chrono::system_clock::time_point timestamp);
+
+    // Hand the current buffer to the flush thread and wait until it is written
+    void flush();
+
+    uint64_t recordCount() const { return records_; }
+
+    // Empty unless writing the file failed
+    std::string getLastError() const;
+
+private:
+    // varint delta + LEN + error + varint coalesced + a frame of MAX_FRAME_LEN
+    static constexpr size_t MAX_RECORD_SIZE = 10 + 1 + 1 + 3 + 255;
+
+    static ParseErrorDetail resultError(ParseStatus status, const ParseErrorDetail& error) {
+        return status == ParseStatus::Invalid ? error : ParseErrorDetail{};
+    }
+
+    struct Buffer {
+        std::vector<uint8_t> bytes;
+        size_t used = 0;
+    };
+
+    void handOff();
+    void run();
+    void writeBlock(const Buffer& buffer);
+
+    std::FILE* file_ = nullptr;
+    FrameLogConfig config_;
+    int64_t last_timestamp_us_ = 0;
+    uint64_t records_ = 0;
+
+    Buffer active_;                        // filled by record()
+    // Guarded by mutex_
+    Buffer pending_;                       // being written while used != 0
+    bool stop_ = false;
+    std::string last_error_;
+
+    std::vector<uint8_t> compressed_;      // flush thread only
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::thread flusher_;
+};
+
+struct FrameLogRecord {
+    std::chrono::system_clock::time_point timestamp;
+    ByteSpan raw_bytes;                    // valid until the next call to next()
+    ParseError error = ParseError::None;   // None for a frame or bytes recorded without a result
+    uint16_t coalesced = 0;                // as ParseErrorDetail::coalesced
+};
+
+/**
+ * @brief Reads the records of a frame log
+ */
+class FrameLogReader {
+public:
+    /**
+     * @param payload Bytes after the header, must outlive the reader
+     * @param flags Header flags, as returned by parseCaptureHeader()
+     */
+    FrameLogReader(ByteSpan payload, uint16_t flags);
+
+    // false at the end of the log, or if it is corrupt (error() is set then)
+    bool next(FrameLogRecord& out);
+
+    const std::string& error() const { return error_; }
+
+private:
+    bool loadBlock();
+
+    ByteSpan input_;
+    size_t input_position_ = 0;            // of the next block
+    bool compressed_;
+    std::vector<uint8_t> decompressed_;
+    ByteSpan block_;
+    size_t position_ = 0;                  // in block_
+    int64_t timestamp_us_ = 0;
+    std::string error_;
+};
+
+} // namespace vdp
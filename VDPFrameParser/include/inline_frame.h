@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ring_buffer.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace vdp {
+
+/**
+ * @brief Frame with its DATA stored inline, up to the 247-byte protocol maximum
+ *
+ * Trivially copyable: copying one is a memcpy and arrays of them are
+ * contiguous with no indirection. Converts to and from any frame type with
+ * ecu_id, command and a vector-like data member (VdpFrame,
+ * protocol::Frame, carly::protocol::Frame).
+ */
+struct InlineFrame {
+    static constexpr size_t CAPACITY = 247;
+
+    uint8_t ecu_id = 0;
+    uint8_t command = 0;
+    uint8_t length = 0;                         // bytes of payload in use
+    std::array<uint8_t, CAPACITY> payload;      // only the first length bytes are meaningful
+
+    ByteSpan data() const { return {payload.data(), length}; }
+
+    /**
+     * @brief Replace the DATA bytes
+     * @return false, leaving the frame unchanged, if data exceeds CAPACITY
+     */
+    bool assign(ByteSpan data) {
+        if (data.size > CAPACITY) {
+            return false;
+        }
+        // A plain loop: the compiler vectorizes it, and it beats a memcpy call at these sizes
+        for (size_t i = 0; i < data.size; ++i) {
+            payload[i] = data.data[i];
+        }
+        length = static_cast<uint8_t>(data.size);
+        return true;
+    }
+
+    /**
+     * @brief Copy a vector-based frame
+     * @return false if its data exceeds CAPACITY
+     */
+    template <typename Frame>
+    static bool from(const Frame& frame, InlineFrame& out) {
+        out.ecu_id = frame.ecu_id;
+        out.command = frame.command;
+        return out.assign(ByteSpan{frame.data.data(), frame.data.size()});
+    }
+
+    // Copy into a vector-based frame type
+    template <typename Frame>
+    Frame to() const {
+        Frame frame;
+        frame.ecu_id = ecu_id;
+        frame.command = command;
+        frame.data.assign(payload.begin(), payload.begin() + length);
+        return frame;
+    }
+};
+
+static_assert(std::is_trivially_copyable<InlineFrame>::value, "InlineFrame must stay trivially copyable");
+
+} // namespace vdp
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "log_linear_buckets.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace vdp {
+namespace protocol {
+
+/**
+ * @brief Response-time statistics for one ECU
+ *
+ * Keeps a smoothed mean and mean deviation (the RFC 6298 RTT estimator,
+ * gains 1/8 and 1/4) and a log-linear histogram for percentiles: 8 linear
+ * sub-buckets per power of two, about 12% resolution up to 16s. The
+ * histogram is halved every DECAY_INTERVAL samples, so percentiles follow
+ * the ECU's recent behaviour. Fixed size, no allocation.
+ */
+class LatencyTracker {
+public:
+    using Micros = std::chrono::microseconds;
+    static constexpr uint32_t DECAY_INTERVAL = 1024;
+
+    void record(Micros sample) {
+        const int64_t us = std::max<int64_t>(sample.count(), 0);
+        if (responses_ == 0) {
+            srtt_us_ = us;
+            rttvar_us_ = us / 2;
+        } else {
+            const int64_t error = us - srtt_us_;
+            rttvar_us_ += ((error < 0 ? -error : error) - rttvar_us_) / 4;
+            srtt_us_ += error / 8;
+        }
+        ++responses_;
+
+        ++buckets_[Buckets::bucketOf(static_cast<uint64_t>(us))];
+        if (++histogram_count_ >= DECAY_INTERVAL) {
+            histogram_count_ = 0;
+            for (auto& count : buckets_) {
+                count /= 2;
+                histogram_count_ += count;
+            }
+        }
+    }
+
+    void recordTimeout() { ++timeouts_; }
+    void recordRetry() { ++retries_; }
+
+    uint64_t responses() const { return responses_; }
+    uint64_t timeouts() const { return timeouts_; }
+    uint64_t retries() const { return retries_; }
+
+    // Smoothed response time
+    Micros ewma() const { return Micros(srtt_us_); }
+    // Smoothed mean deviation of the response time
+    Micros deviation() const { return Micros(rttvar_us_); }
+
+    /**
+     * @brief Upper bound of the histogram bucket holding quantile q (0..1)
+     * @return Zero before the first sample
+     */
+    Micros percentile(double q) const {
+        if (histogram_count_ == 0) {
+            return Micros(0);
+        }
+        const uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(histogram_count_) + 0.5);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets_[i];
+            if (seen >= rank && seen > 0) {
+                return Micros(static_cast<int64_t>(Buckets::upperBound(i)));
+            }
+        }
+        return Micros(static_cast<int64_t>(Buckets::upperBound(BUCKETS - 1)));
+    }
+
+    Micros p99() const { return percentile(0.99); }
+
+private:
+    using Buckets = LogLinearBuckets<24>;   // 2^24us, about 16.8s
+    static constexpr size_t BUCKETS = Buckets::COUNT;
+
+    int64_t srtt_us_ = 0;
+    int64_t rttvar_us_ = 0;
+    uint64_t responses_ = 0;
+    uint64_t timeouts_ = 0;
+    uint64_t retries_ = 0;
+    std::array<uint32_t, BUCKETS> buckets_{};
+    uint32_t histogram_count_ = 0;
+};
+
+/**
+ * @brief Snapshot of one ECU's statistics, see VDPEngine::ecuStats()
+ */
+struct EcuStats {
+    uint8_t ecu_id = 0;
+    uint64_t responses = 0;
+    uint64_t timeouts = 0;
+    uint64_t retries = 0;
+    std::chrono::microseconds ewma{0};
+    std::chrono::microseconds deviation{0};
+    std::chrono::microseconds p99{0};
+    std::chrono::milliseconds adaptive_timeout{0}; // attempt timeout with adaptive_timeout and default bounds
+};
+
+/**
+ * @brief Timeout and retry behaviour for one command, see VDPEngine::setRetryPolicy()
+ *
+ * The default keeps the caller's timeout and never retries. With
+ * adaptive_timeout, once an ECU has MIN_SAMPLES responses each attempt waits
+ * max(ewma + 4 * deviation, p99), clamped to [min_timeout, max_timeout],
+ * instead of the caller's timeout. Retries happen after a timeout or an
+ * ECU Busy reply and wait max(base_backoff, ewma), doubled per attempt.
+ */
+struct RetryPolicy {
+    static constexpr uint64_t MIN_SAMPLES = 8;
+
+    uint8_t max_retries = 0;
+    bool retry_on_busy = true;
+    bool adaptive_timeout = false;
+    std::chrono::milliseconds min_timeout{10};
+    std::chrono::milliseconds max_timeout{1000};
+    std::chrono::milliseconds base_backoff{5};
+
+    std::chrono::milliseconds attemptTimeout(const LatencyTracker& stats, std::chrono::milliseconds requested) const {
+        if (!adaptive_timeout || stats.responses() < MIN_SAMPLES) {
+            return requested;
+        }
+        const auto rto = std::max(stats.ewma() + 4 * stats.deviation(), stats.p99());
+        // Round up, a response right at the estimate must still count
+        const auto timeout = std::chrono::ceil<std::chrono::milliseconds>(rto);
+        return std::clamp(timeout, min_timeout, max_timeout);
+    }
+
+    // @param attempt Number of the retry about to be made, starting at 1
+    std::chrono::milliseconds backoff(const LatencyTracker& stats, uint8_t attempt) const {
+        auto delay = std::max(base_backoff, std::chrono::ceil<std::chrono::milliseconds>(stats.ewma()));
+        for (uint8_t i = 1; i < attempt && delay < max_timeout; ++i) {
+            delay *= 2;
+        }
+        return std::min(delay, max_timeout);
+    }
+};
+
+} // namespace protocol
+} // namespace vdp
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace vdp {
+
+/**
+ * @brief Bucket layout of a log-linear histogram
+ *
+ * Values below 2^SubBits get one bucket each, larger ones 2^SubBits linear
+ * sub-buckets per power of two (about 12% resolution with the default 3),
+ * up to 2^MaxExponent. Larger values land in the last bucket.
+ */
+template <unsigned MaxExponent, unsigned SubBits = 3>
+struct LogLinearBuckets {
+    static_assert(SubBits < MaxExponent && MaxExponent < 64, "invalid bucket layout");
+
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SubBits;
+    static constexpr size_t COUNT = (MaxExponent - SubBits + 1) * SUB_BUCKETS;
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        const unsigned exponent = static_cast<unsigned>(index);
+#else
+        const unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+        if (exponent >= MaxExponent) {
+            return COUNT - 1;
+        }
+        const size_t sub = static_cast<size_t>(value >> (exponent - SubBits)) & (SUB_BUCKETS - 1);
+        return (exponent - SubBits + 1) * SUB_BUCKETS + sub;
+    }
+
+    // Largest value that falls into bucket
+    static uint64_t upperBound(size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        const unsigned exponent = static_cast<unsigned>(bucket / SUB_BUCKETS) + SubBits - 1;
+        const uint64_t sub = bucket % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << (exponent - SubBits)) - 1;
+    }
+};
+
+} // namespace vdp
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "log_linear_buckets.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Build with VDP_METRICS=0 (CMake option VDP_METRICS=OFF) to compile the
+// instrumentation out: counters and histograms become empty no-ops and
+// every snapshot reads zero.
+#ifndef VDP_METRICS
+#define VDP_METRICS 1
+#endif
+
+namespace vdp {
+namespace metrics {
+
+constexpr bool ENABLED = VDP_METRICS != 0;
+
+/**
+ * @brief Monotonic counter with a single writer
+ *
+ * add() is a relaxed load and store rather than a read-modify-write, so it
+ * costs a plain increment; value() may be read from any thread. A counter
+ * written from several threads must be guarded by a lock.
+ */
+class Counter {
+public:
+#if VDP_METRICS
+    void add(uint64_t n = 1) { value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+#else
+    void add(uint64_t = 1) {}
+    uint64_t value() const { return 0; }
+#endif
+};
+
+// Log-linear layout of Histogram, in nanoseconds up to 2^40 (about 18 minutes)
+using HistogramBuckets = LogLinearBuckets<40>;
+
+/**
+ * @brief Copy of a Histogram's state
+ */
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    std::array<uint64_t, HistogramBuckets::COUNT> buckets{};
+
+    /**
+     * @brief Upper bound of the bucket holding quantile q (0..1), capped at max
+     * @return Zero before the first sample
+     */
+    uint64_t percentile(double q) const {
+        const uint64_t total = bucketTotal();
+        if (total == 0) {
+            return 0;
+        }
+        const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(q * static_cast<double>(total) + 0.5), 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return std::min(HistogramBuckets::upperBound(i), max);
+            }
+        }
+        return max;
+    }
+
+    double mean() const { return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count); }
+
+private:
+    // The buckets are read one by one, so they may disagree with count by a few samples
+    uint64_t bucketTotal() const {
+        uint64_t total = 0;
+        for (uint64_t bucket : buckets) {
+            total += bucket;
+        }
+        return total;
+    }
+};
+
+/**
+ * @brief HDR-style latency histogram with a single writer
+ *
+ * Fixed-size log-linear buckets (about 12% resolution), updated with relaxed
+ * loads and stores like Counter. snapshot() may run on any thread while
+ * samples are recorded; it then sees each field at a slightly different time.
+ */
+class Histogram {
+public:
+#if VDP_METRICS
+    // Record n samples of value
+    void record(uint64_t value, uint64_t n = 1) {
+        bump(buckets_[HistogramBuckets::bucketOf(value)], n);
+        bump(count_, n);
+        bump(sum_, value * n);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot out;
+        out.count = count_.load(std::memory_order_relaxed);
+        out.sum = sum_.load(std::memory_order_relaxed);
+        out.max = max_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < out.buckets.size(); ++i) {
+            out.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        }
+        return out;
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, HistogramBuckets::COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+#else
+    void record(uint64_t, uint64_t = 1) {}
+    HistogramSnapshot snapshot() const { return {}; }
+#endif
+};
+
+} // namespace metrics
+} // namespace vdp
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "protocol_engine.h"
+#include "vdp_parser.h"
+
+#include <string>
+
+namespace vdp {
+
+/**
+ * @brief Append metrics in the Prometheus text exposition format
+ *
+ * Counters become `_total` counters, histograms summaries in seconds with
+ * the 0.5, 0.9, 0.99 and 0.999 quantiles. Several parsers or engines can
+ * share one scrape: emit the first with metadata and give each its own labels.
+ * @param labels Added to every sample, without braces, e.g. `channel="can0"`
+ * @param with_metadata Emit the # HELP and # TYPE lines of each metric
+ */
+void appendPrometheus(std::string& out, const ParserMetricsSnapshot& metrics,
+                      const std::string& labels = {}, bool with_metadata = true);
+void appendPrometheus(std::string& out, const protocol::EngineMetricsSnapshot& metrics,
+                      const std::string& labels = {}, bool with_metadata = true);
+
+} // namespace vdp
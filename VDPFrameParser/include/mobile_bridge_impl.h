@@ -3,6 +3,7 @@
 #include "../../mobile_bridge.h"
 #include "protocol_engine.h"
 #include "transport_interface.h"
+#include <atomic>
 #include <memory>
 #include <mutex>
 
@@ -17,6 +18,9 @@ namespace protocol {
  * - Thread-safe operations for mobile platforms
  * - Error handling and status mapping
  * - Resource management
+ *
+ * Frames are converted by moving their DATA vector: a response is copied
+ * once, out of the parser's buffer, on its way to the mobile callback.
  */
 class MobileBridgeImpl : public IProtocolEngine {
 public:
@@ -26,6 +30,12 @@ public:
      */
     explicit MobileBridgeImpl(vdp::transport::TransportFactory::Type transport_type = 
                              vdp::transport::TransportFactory::Type::SERIAL);
+
+    /**
+     * @brief Constructor with a caller-provided transport
+     * @param transport Transport to use, e.g. a MockTransport in tests
+     */
+    explicit MobileBridgeImpl(std::unique_ptr<vdp::transport::ITransport> transport);
     
     ~MobileBridgeImpl() override;
     
@@ -41,16 +51,30 @@ public:
     void disconnect() override;
     std::string getLastError() const override;
 
+    // Batched interface, see attachCompletionRing() and submitFrameBatch() in mobile_bridge.h
+    bool attachCompletionRing(CompletionRing* ring);
+    int32_t submitFrameBatch(const uint8_t* requests, size_t length, uint32_t* first_request_id);
+
 private:
     std::unique_ptr<vdp::protocol::VDPEngine> engine_;
     mutable std::mutex mutex_;
     std::string last_error_;
+
+    // Completion ring of the batched interface, guards the producer side
+    std::mutex ring_mutex_;
+    CompletionRing* ring_ = nullptr;
+    uint32_t ring_in_flight_ = 0;   // accepted requests whose record is not written yet
+    uint32_t next_request_id_ = 0;
+
+    // Publish the record of a batch request into the ring
+    void completeBatchRequest(uint32_t request_id, vdp::protocol::Response&& response);
     
     // Utility methods
     void setLastError(const std::string& error);
-    Status mapVdpStatusToMobile(vdp::ParseStatus vdp_status);
-    vdp::VdpFrame convertToVdpFrame(const Frame& mobile_frame);
-    Frame convertFromVdpFrame(const vdp::VdpFrame& vdp_frame);
+    static Status mapVdpStatusToMobile(const vdp::protocol::Response& response);
+    static vdp::protocol::Frame convertToVdpFrame(const Frame& mobile_frame);
+    static Frame convertFromVdpFrame(vdp::protocol::Frame&& vdp_frame);
+    static Response convertFromVdpResponse(vdp::protocol::Response&& vdp_response);
 };
 
 /**
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vdp {
+
+/**
+ * @brief Fixed-capacity pool of objects addressed by index
+ *
+ * Every object is constructed up front, so acquire() and release() are O(1)
+ * and never allocate. Each object carries a next link: free objects are
+ * chained through it, and acquired ones may be chained by the owner into
+ * its own FIFO (see IndexFifo). The pool is not synchronized.
+ */
+template <typename T>
+class ObjectPool {
+public:
+    using Index = uint32_t;
+    static constexpr Index NONE = 0xFFFFFFFF;
+
+    explicit ObjectPool(size_t capacity) : nodes_(capacity) {
+        for (size_t i = capacity; i-- > 0;) {
+            nodes_[i].next = free_head_;
+            free_head_ = static_cast<Index>(i);
+        }
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    /**
+     * @brief Take a free object, left as it was released
+     * @return Its index, NONE when all objects are in use
+     */
+    Index acquire() {
+        if (free_head_ == NONE) {
+            return NONE;
+        }
+        const Index index = free_head_;
+        free_head_ = nodes_[index].next;
+        nodes_[index].next = NONE;
+        ++size_;
+        return index;
+    }
+
+    // Return an object, its value is reset so it holds no resources while free
+    void release(Index index) {
+        nodes_[index].value = T{};
+        nodes_[index].next = free_head_;
+        free_head_ = index;
+        --size_;
+    }
+
+    T& operator[](Index index) { return nodes_[index].value; }
+    const T& operator[](Index index) const { return nodes_[index].value; }
+
+    // Link of an acquired object, free for the owner to use
+    Index& next(Index index) { return nodes_[index].next; }
+    Index next(Index index) const { return nodes_[index].next; }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return nodes_.size(); }
+    bool full() const { return free_head_ == NONE; }
+
+private:
+    struct Node {
+        T value{};
+        Index next = NONE;
+    };
+
+    std::vector<Node> nodes_;
+    Index free_head_ = NONE;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief FIFO of objects from an ObjectPool, linked through their next links
+ */
+struct IndexFifo {
+    uint32_t head = 0xFFFFFFFF;
+    uint32_t tail = 0xFFFFFFFF;
+
+    bool empty() const { return head == 0xFFFFFFFF; }
+
+    template <typename Pool>
+    void pushBack(Pool& pool, uint32_t index) {
+        pool.next(index) = Pool::NONE;
+        if (empty()) {
+            head = index;
+        } else {
+            pool.next(tail) = index;
+        }
+        tail = index;
+    }
+
+    template <typename Pool>
+    void pushFront(Pool& pool, uint32_t index) {
+        pool.next(index) = head;
+        head = index;
+        if (tail == Pool::NONE) {
+            tail = index;
+        }
+    }
+
+    // Unlink the first element, the FIFO must not be empty
+    template <typename Pool>
+    uint32_t popFront(Pool& pool) {
+        const uint32_t index = head;
+        head = pool.next(index);
+        if (head == Pool::NONE) {
+            tail = Pool::NONE;
+        }
+        return index;
+    }
+};
+
+} // namespace vdp
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "vdp_parser.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace vdp {
+
+/**
+ * @brief Parse a complete in-memory capture on several threads
+ *
+ * Returns the results of feeding all of input to a new VdpParser and calling
+ * extractFrames() once, in the same order (timestamps aside). A frame cut
+ * off by the end of input yields no result, as it would stay buffered.
+ *
+ * input is split into one chunk per thread. Each chunk is parsed from its
+ * first START byte, which is where the sequential scan enters it unless a
+ * frame straddles the chunk boundary. Straddling frames are then stitched
+ * in order: the scan is replayed from where the previous chunk left off
+ * until it meets a START byte the chunk's own parse visited, from which on
+ * both agree.
+ * @param threads Worker threads including the caller, 0: one per hardware thread
+ * @param min_chunk Inputs are not split into chunks smaller than this
+ */
+std::vector<ParseResult> parallelParse(ByteSpan input, size_t threads = 0, size_t min_chunk = 64 * 1024);
+
+/**
+ * @brief Zero-copy variant of parallelParse()
+ *
+ * The views borrow from input. Error offsets are offsets into input.
+ */
+std::vector<ParseResultView> parallelParseViews(ByteSpan input, size_t threads = 0,
+                                                size_t min_chunk = 64 * 1024);
+
+} // namespace vdp
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace vdp {
+
+/**
+ * @brief Size-class pool for frame payloads
+ *
+ * Requests up to MAX_POOLED_SIZE bytes are rounded up to one of five
+ * classes (16 to 256 bytes, enough for the 247-byte DATA maximum) and
+ * served from per-class free lists carved out of BLOCK_SIZE blocks. Freed
+ * chunks go back to their list, so a steady workload stops touching the
+ * global heap and does not fragment it. Blocks are only released when the
+ * pool is destroyed. Larger requests go to operator new.
+ *
+ * Thread-safe; frames may be freed on a different thread than the one
+ * that allocated them.
+ */
+class PayloadPool {
+public:
+    static constexpr size_t MIN_CLASS_SIZE = 16;
+    static constexpr size_t CLASS_COUNT = 5;
+    static constexpr size_t MAX_POOLED_SIZE = MIN_CLASS_SIZE << (CLASS_COUNT - 1);   // 256
+    static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+    PayloadPool() = default;
+    ~PayloadPool() {
+        for (void* block : blocks_) {
+            ::operator delete(block);
+        }
+    }
+
+    PayloadPool(const PayloadPool&) = delete;
+    PayloadPool& operator=(const PayloadPool&) = delete;
+
+    /**
+     * @brief Pool used by default-constructed PoolAllocators
+     * @note Never destroyed, frames freed during static destruction stay valid
+     */
+    static PayloadPool& shared() {
+        static PayloadPool* pool = new PayloadPool();
+        return *pool;
+    }
+
+    void* allocate(size_t bytes) {
+        if (bytes > MAX_POOLED_SIZE) {
+            return ::operator new(bytes);
+        }
+
+        const size_t size_class = classOf(bytes);
+        std::lock_guard<std::mutex> lock(mutex_);
+        Chunk* chunk = free_lists_[size_class];
+        if (chunk == nullptr) {
+            refillNoLock(size_class);
+            chunk = free_lists_[size_class];
+        }
+        free_lists_[size_class] = chunk->next;
+        ++in_use_;
+        return chunk;
+    }
+
+    void deallocate(void* pointer, size_t bytes) {
+        if (pointer == nullptr) {
+            return;
+        }
+        if (bytes > MAX_POOLED_SIZE) {
+            ::operator delete(pointer);
+            return;
+        }
+
+        const size_t size_class = classOf(bytes);
+        std::lock_guard<std::mutex> lock(mutex_);
+        Chunk* chunk = static_cast<Chunk*>(pointer);
+        chunk->next = free_lists_[size_class];
+        free_lists_[size_class] = chunk;
+        --in_use_;
+    }
+
+    // Pooled chunks currently handed out
+    size_t inUse() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return in_use_;
+    }
+
+    // Blocks taken from the global heap so far
+    size_t blockCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return blocks_.size();
+    }
+
+    // Chunk size of the class serving a request of bytes (bytes <= MAX_POOLED_SIZE)
+    static constexpr size_t classSize(size_t bytes) { return MIN_CLASS_SIZE << classOf(bytes); }
+
+private:
+    struct Chunk {
+        Chunk* next;
+    };
+
+    static constexpr size_t classOf(size_t bytes) {
+        size_t size_class = 0;
+        while ((MIN_CLASS_SIZE << size_class) < bytes) {
+            ++size_class;
+        }
+        return size_class;
+    }
+
+    void refillNoLock(size_t size_class) {
+        const size_t chunk_size = MIN_CLASS_SIZE << size_class;
+        auto* block = static_cast<uint8_t*>(::operator new(BLOCK_SIZE));
+        blocks_.push_back(block);
+        // Thread the block's chunks onto the free list, lowest address first
+        for (size_t offset = BLOCK_SIZE; offset >= chunk_size; offset -= chunk_size) {
+            Chunk* chunk = reinterpret_cast<Chunk*>(block + offset - chunk_size);
+            chunk->next = free_lists_[size_class];
+            free_lists_[size_class] = chunk;
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::array<Chunk*, CLASS_COUNT> free_lists_{};
+    std::vector<void*> blocks_;
+    size_t in_use_ = 0;
+};
+
+/**
+ * @brief Standard allocator drawing from a PayloadPool
+ *
+ * Default-constructed allocators use PayloadPool::shared(). Allocators
+ * compare equal when they share a pool, so containers can swap and move
+ * storage between them.
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    PoolAllocator() noexcept : pool_(&PayloadPool::shared()) {}
+    explicit PoolAllocator(PayloadPool& pool) noexcept : pool_(&pool) {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : pool_(other.pool()) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(pool_->allocate(count * sizeof(T))); }
+    void deallocate(T* pointer, size_t count) noexcept { pool_->deallocate(pointer, count * sizeof(T)); }
+
+    PayloadPool* pool() const noexcept { return pool_; }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept { return pool_ == other.pool(); }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept { return pool_ != other.pool(); }
+
+private:
+    PayloadPool* pool_;
+};
+
+} // namespace vdp
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "vdp_parser.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace vdp {
+
+/**
+ * @brief Flat table of outstanding requests keyed by (ECU, command)
+ *
+ * Entries live in one preallocated slot array; free slots form an intrusive
+ * free list and entries with the same key form an intrusive FIFO, so insert,
+ * lookup of the oldest entry for a key and removal by handle are all O(1)
+ * with no per-entry allocation. Responses and ACK/NAKs are correlated by the
+ * same key: the response's own command, or the command echoed in DATA[0].
+ *
+ * Handles carry a generation count, so a handle to a slot that has since
+ * been reused is rejected. The table is not synchronized.
+ */
+template <typename T>
+class PendingRequestTable {
+public:
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = 0;
+    static constexpr size_t MAX_CAPACITY = 0xFFFF; // slot index must fit the low half of a handle
+
+    // @param capacity Slots allocated up front, the table doubles when they run out
+    explicit PendingRequestTable(size_t capacity = 64) {
+        buckets_.fill({NONE, NONE});
+        grow(capacity < 1 ? 1 : capacity);
+    }
+
+    /**
+     * @brief Add an entry behind any older entries for the same key
+     * @param ecu_id Target ECU, the response bit is ignored
+     * @return Handle of the entry, INVALID_HANDLE if MAX_CAPACITY entries are outstanding
+     */
+    Handle insert(uint8_t ecu_id, uint8_t command, T value) {
+        if (free_head_ == NONE && !grow(slots_.size() * 2)) {
+            return INVALID_HANDLE;
+        }
+
+        const uint32_t index = free_head_;
+        Slot& slot = slots_[index];
+        free_head_ = slot.next;
+
+        slot.value = std::move(value);
+        slot.ecu_id = static_cast<uint8_t>(ecu_id & ECU_MASK);
+        slot.command = command;
+        slot.used = true;
+
+        // Append to the key's FIFO
+        Bucket& b = bucket(slot.ecu_id, command);
+        slot.prev = b.tail;
+        slot.next = NONE;
+        if (b.tail != NONE) {
+            slots_[b.tail].next = index;
+        } else {
+            b.head = index;
+        }
+        b.tail = index;
+
+        ++size_;
+        return makeHandle(index, slot.generation);
+    }
+
+    /**
+     * @brief Remove the oldest entry for (ecu_id, command)
+     * @return false if no entry matches
+     */
+    bool takeOldest(uint8_t ecu_id, uint8_t command, T& out) {
+        ecu_id = static_cast<uint8_t>(ecu_id & ECU_MASK);
+        // Known commands have a bucket of their own, so the first entry matches;
+        // the shared bucket for other commands is scanned
+        for (uint32_t i = bucket(ecu_id, command).head; i != NONE; i = slots_[i].next) {
+            if (slots_[i].command == command) {
+                remove(i, out);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Remove the entry behind a handle returned by insert()
+     * @return false if the handle is stale or invalid
+     */
+    bool take(Handle handle, T& out) {
+        if (find(handle) == nullptr) {
+            return false;
+        }
+        remove((handle & 0xFFFF) - 1, out);
+        return true;
+    }
+
+    /**
+     * @brief Entry behind a handle, nullptr if the handle is stale or invalid
+     */
+    T* find(Handle handle) {
+        const uint32_t index = (handle & 0xFFFF) - 1;
+        if (handle == INVALID_HANDLE || index >= slots_.size() || !slots_[index].used ||
+            slots_[index].generation != (handle >> 16)) {
+            return nullptr;
+        }
+        return &slots_[index].value;
+    }
+
+    /**
+     * @brief Visit every entry as fn(handle, value)
+     * @note fn must not insert or remove entries
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (uint32_t i = 0; i < slots_.size(); ++i) {
+            if (slots_[i].used) {
+                fn(makeHandle(i, slots_[i].generation), slots_[i].value);
+            }
+        }
+    }
+
+    /**
+     * @brief Remove every entry, appending them to out oldest slot first
+     */
+    void drain(std::vector<T>& out) {
+        for (uint32_t i = 0; i < slots_.size(); ++i) {
+            if (slots_[i].used) {
+                out.emplace_back();
+                remove(i, out.back());
+            }
+        }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return slots_.size(); }
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+    static constexpr uint8_t ECU_MASK = 0x7F;
+    static constexpr size_t COMMAND_CLASSES = 8;
+
+    struct Slot {
+        T value{};
+        uint32_t prev = NONE;
+        uint32_t next = NONE;     // next in the key FIFO, or in the free list
+        uint16_t generation = 0;
+        uint8_t ecu_id = 0;
+        uint8_t command = 0;
+        bool used = false;
+    };
+
+    struct Bucket {
+        uint32_t head;
+        uint32_t tail;
+    };
+
+    // Each protocol command gets its own class; anything else shares the last one
+    static size_t commandClass(uint8_t command) {
+        switch (static_cast<CommandType>(command)) {
+            case CommandType::ReadData:    return 0;
+            case CommandType::WriteData:   return 1;
+            case CommandType::ClearCodes:  return 2;
+            case CommandType::EcuReset:    return 3;
+            case CommandType::KeepAlive:   return 4;
+            case CommandType::Acknowledge: return 5;
+            case CommandType::NegativeAck: return 6;
+            default:                       return 7;
+        }
+    }
+
+    Bucket& bucket(uint8_t ecu_id, uint8_t command) {
+        return buckets_[ecu_id * COMMAND_CLASSES + commandClass(command)];
+    }
+
+    static Handle makeHandle(uint32_t index, uint16_t generation) {
+        return (static_cast<Handle>(generation) << 16) | (index + 1);
+    }
+
+    bool grow(size_t new_capacity) {
+        const size_t old_capacity = slots_.size();
+        if (new_capacity > MAX_CAPACITY) {
+            new_capacity = MAX_CAPACITY;
+        }
+        if (new_capacity <= old_capacity) {
+            return false;
+        }
+
+        // Slots are addressed by index, so moving them does not break the links
+        slots_.resize(new_capacity);
+        for (size_t i = new_capacity; i-- > old_capacity;) {
+            slots_[i].next = free_head_;
+            free_head_ = static_cast<uint32_t>(i);
+        }
+        return true;
+    }
+
+    void remove(uint32_t index, T& out) {
+        Slot& slot = slots_[index];
+        Bucket& b = bucket(slot.ecu_id, slot.command);
+        if (slot.prev != NONE) {
+            slots_[slot.prev].next = slot.next;
+        } else {
+            b.head = slot.next;
+        }
+        if (slot.next != NONE) {
+            slots_[slot.next].prev = slot.prev;
+        } else {
+            b.tail = slot.prev;
+        }
+
+        out = std::move(slot.value);
+        slot.value = T{};
+        slot.used = false;
+        ++slot.generation;
+        slot.next = free_head_;
+        free_head_ = index;
+        --size_;
+    }
+
+    std::vector<Slot> slots_;
+    std::array<Bucket, (ECU_MASK + 1) * COMMAND_CLASSES> buckets_;
+    uint32_t free_head_ = NONE;
+    size_t size_ = 0;
+};
+
+} // namespace vdp
@@ -1,17 +1,33 @@
 #pragma once
 
 #include "vdp_parser.h"
+#include "latency_stats.h"
+#include "object_pool.h"
+#include "pending_request_table.h"
+#include "timer_wheel.h"
 #include "transport_interface.h"
 #include "types.h"
 #include <memory>
 #include <atomic>
 #include <thread>
-#include <queue>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <chrono>
 #include <condition_variable>
 
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define VDP_HAS_COROUTINES 1
+#endif
+
 namespace vdp {
 namespace protocol {
 
+#if defined(VDP_HAS_COROUTINES)
+class RequestAwaitable;
+#endif
+
 /**
  * @brief Abstract base class for protocol engines
  *
@@ -54,16 +70,34 @@ public:
      */
     std::string getLastError() const;
 
+    /**
+     * @brief Process bytes received outside the transport, as if the transport had delivered them
+     */
+    void processIncomingData(const uint8_t* data, size_t length);
+    // As above, with the reception time the transport measured
+    void processIncomingData(const uint8_t* data, size_t length, RxTimestamp received);
+
+    /**
+     * @brief Counters of the engine's parser, see VdpParser::metrics()
+     */
+    ParserMetricsSnapshot parserMetrics() const { return parser_->metrics(); }
+
 protected:
-    // Template method pattern - subclasses implement protocol-specific logic
-    virtual void onFrameReceived(const VdpFrame& frame) = 0;
+    // Template method pattern - subclasses implement protocol-specific logic.
+    // Received frames are handed over so their DATA can be moved on instead of copied.
+    virtual void onFrameReceived(VdpFrame&& frame) = 0;
     virtual void onParseError(const std::string& error) = 0;
     virtual void onTransportError(const std::string& error) = 0;
 
     // Protected methods for subclasses
     bool sendRawData(const uint8_t* data, size_t length);
+    // Send a frame serialized as slices, the payload is passed to the transport in place
+    bool sendRawData(const FrameSlices& slices);
     void setLastError(const std::string& error);
 
+    // Frame codec shared with subclasses for serialization
+    VdpParser& parser() { return *parser_; }
+
 private:
     std::unique_ptr<transport::ITransport> transport_;
     std::unique_ptr<VdpParser> parser_;
@@ -75,8 +109,28 @@ private:
 
     // Data processing
     void onTransportDataReceived(const uint8_t* data, size_t length);
+    // length bytes were received into lease, see ITransport::setReceiveBuffer()
+    void onTransportDataCommitted(VdpParser::WriteLease lease, size_t length);
     void onTransportErrorReceived(const std::string& error);
-    void processParserResults(const std::vector<ParseResult>& results);
+    void processParserResults(std::vector<ParseResult>&& results);
+};
+
+/**
+ * @brief Request counters of a VDPEngine since construction, see VDPEngine::metrics()
+ *
+ * All zero when built with VDP_METRICS=0, except queue_depth.
+ */
+struct EngineMetricsSnapshot {
+    uint64_t requests = 0;          // accepted by submit
+    uint64_t rejected = 0;          // refused, too many pending requests
+    uint64_t responses = 0;         // replies matched to a request (ACK, NAK or response frame)
+    uint64_t timeouts = 0;          // attempts that timed out
+    uint64_t retries = 0;
+    uint64_t naks = 0;              // NAK frames received, matched or not
+    std::array<uint64_t, 256> naks_by_status{};  // indexed by the NAK's ResponseStatus byte, if it has one
+    size_t queue_depth = 0;         // requests queued or in flight right now
+    size_t max_queue_depth = 0;
+    metrics::HistogramSnapshot round_trip_ns;    // transmission to matched reply
 };
 
 /**
@@ -86,11 +140,27 @@ private:
  * - Frame validation and processing
  * - Response matching
  * - Timeout handling
+ * - Per-ECU latency statistics and per-command retry policies
+ *
+ * All request state lives here; VdpParser only converts bytes to frames,
+ * so parsing cost does not depend on the number of outstanding requests.
  */
 class VDPEngine : public ProtocolEngineBase {
 public:
-    explicit VDPEngine(std::unique_ptr<transport::ITransport> transport);
-    ~VDPEngine() override = default;
+    // Requests that may be queued or in flight at once, beyond it requests fail immediately
+    static constexpr size_t DEFAULT_REQUEST_CAPACITY = 1024;
+
+    // Receives every outcome of a request; the response is handed over, so its
+    // frame DATA can be moved into the caller's own types without a copy
+    using CompletionCallback = std::function<void(protocol::Response&& response)>;
+
+    /**
+     * @param request_capacity Request records allocated up front; the engine
+     *        does not allocate them per request
+     */
+    explicit VDPEngine(std::unique_ptr<transport::ITransport> transport,
+                       size_t request_capacity = DEFAULT_REQUEST_CAPACITY);
+    ~VDPEngine() override;
 
     /**
      * @brief Send a VDP frame and wait for response (blocking)
@@ -111,6 +181,42 @@ public:
                        protocol::ResponseCallback on_response,
                        protocol::ErrorCallback on_error);
 
+    /**
+     * @brief Send a VDP frame asynchronously, with the default timeout
+     * @param frame Frame to send, moved into the request
+     * @param on_complete Receives the response on success and failure, see Response::status
+     */
+    void sendFrameAsync(protocol::Frame frame, CompletionCallback on_complete);
+
+    /**
+     * @brief Submit several requests and get every response in one callback
+     *
+     * All requests, including those from sendFrame()/sendFrameAsync(), are
+     * queued per ECU: each ECU has at most one request in flight, different
+     * ECUs are served round-robin in parallel, and transmissions are spaced
+     * by the inter-frame delay. Each request uses the default timeout,
+     * counted from its transmission.
+     * @param frames Requests to send
+     * @param on_complete Called once after all requests resolved, with the
+     *        responses in the order of frames. If any frame's data is too
+     *        large, none is sent and every response is an error.
+     */
+    void submitBatch(std::vector<protocol::Frame> frames, protocol::BatchCallback on_complete);
+
+#if defined(VDP_HAS_COROUTINES)
+    /**
+     * @brief Send a VDP frame from a coroutine: `Response r = co_await engine.request(frame);`
+     *
+     * The request is queued like sendFrameAsync() when awaited. The coroutine
+     * resumes on the thread that completes it (receive, timeout or sending
+     * thread), or without suspending if it completed while being submitted.
+     * Nothing is allocated besides the queued request itself.
+     * @note Only available when compiled as C++20 with coroutine support
+     */
+    RequestAwaitable request(const protocol::Frame& frame,
+                             std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+#endif
+
     /**
      * @brief Send raw data for debugging/testing
      * @param data Raw bytes to send
@@ -118,41 +224,226 @@ public:
      */
     std::vector<uint8_t> sendRawData(const std::vector<uint8_t>& data);
 
+    /**
+     * @brief Set the timeout used by sendFrameAsync (default: 1000ms)
+     */
+    void setDefaultTimeout(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Set the minimum gap between two transmitted requests (default: 5ms, per the spec)
+     * @note NAKs and sendRawData() are not paced
+     */
+    void setInterFrameDelay(std::chrono::microseconds delay);
+
+    /**
+     * @brief Number of requests queued or waiting for a response
+     */
+    size_t pendingRequestCount() const;
+
+    /**
+     * @brief Set how requests with this command are timed out and retried
+     *
+     * A retried request goes back to the front of its ECU's queue after the
+     * policy's backoff and completes only after its last attempt, so with
+     * retries the total time can exceed the caller's timeout.
+     * @note Applies to requests dispatched after the call
+     */
+    void setRetryPolicy(CommandType command, const RetryPolicy& policy);
+    RetryPolicy retryPolicy(CommandType command) const;
+
+    /**
+     * @brief Response time, timeout and retry statistics of one ECU
+     * @param ecu_id ECU address, the response bit is ignored
+     */
+    EcuStats ecuStats(uint8_t ecu_id) const;
+
+    /**
+     * @brief Statistics of every ECU that has answered or timed out so far
+     */
+    std::vector<EcuStats> ecuStatsSnapshot() const;
+
+    /**
+     * @brief Request, reply and queue counters, see parserMetrics() for the parser's
+     */
+    EngineMetricsSnapshot metrics() const;
+
 protected:
+#if defined(VDP_HAS_COROUTINES)
+    friend class RequestAwaitable;
+#endif
+
     // ProtocolEngineBase overrides
-    void onFrameReceived(const VdpFrame& frame) override;
+    void onFrameReceived(VdpFrame&& frame) override;
     void onParseError(const std::string& error) override;
     void onTransportError(const std::string& error) override;
 
 private:
     // Request tracking for async operations
     struct PendingRequest {
-        uint32_t request_id;
-        protocol::ResponseCallback response_callback;
-        protocol::ErrorCallback error_callback;
-        std::chrono::steady_clock::time_point timeout_time;
+        CompletionCallback on_complete;     // Receives every outcome, see Response::status
+        TimerWheel::TimerId timer = TimerWheel::INVALID_TIMER;
         protocol::Frame original_frame;
+        std::chrono::steady_clock::time_point sent_time{};
+        std::chrono::milliseconds timeout{0};  // as requested, the policy may shorten an attempt
+        uint8_t attempt = 0;                   // retries made so far
     };
 
-    std::atomic<uint32_t> next_request_id_{1};
-    std::map<uint32_t, PendingRequest> pending_requests_;
-    std::mutex requests_mutex_;
+    // Indexed by (ECU, command), responses are matched in O(1). At most one
+    // request per ECU is in flight, so the table never grows past its initial size.
+    using RequestTable = PendingRequestTable<PendingRequest>;
+    RequestTable pending_requests_;
+    mutable std::mutex requests_mutex_;
+    std::chrono::milliseconds default_timeout_{1000};
+
+    // Request scheduling, guarded by requests_mutex_
+    struct QueuedRequest {
+        protocol::Frame frame;
+        std::chrono::milliseconds timeout;
+        CompletionCallback on_complete;
+        uint8_t attempt = 0;
+        std::chrono::steady_clock::time_point not_before{};  // retry backoff
+    };
+    using QueuePool = ObjectPool<QueuedRequest>;
+    struct EcuQueue {
+        IndexFifo waiting;   // requests in queue_pool_
+        bool busy = false;   // a request to this ECU is in flight
+        bool ready = false;  // listed in ready_ecus_
+    };
+    // A request moved into flight, transmitted outside the lock. The payload
+    // is copied inline, the request itself may complete before it is sent.
+    struct Dispatch {
+        RequestTable::Handle handle = RequestTable::INVALID_HANDLE;
+        uint8_t ecu_id = 0;
+        uint8_t command = 0;
+        uint8_t length = 0;
+        std::array<uint8_t, MAX_SERIALIZED_FRAME_SIZE> payload;
+    };
+
+    // Request records for queued requests, fixed capacity
+    const size_t request_capacity_;
+    QueuePool queue_pool_;
+    std::array<EcuQueue, 128> ecu_queues_;   // indexed by ECU id without the response bit
+    std::deque<uint8_t> ready_ecus_;          // idle ECUs with waiting requests
+    size_t queued_count_ = 0;
+    std::chrono::microseconds inter_frame_delay_{5000};
+    std::chrono::steady_clock::time_point next_send_time_{};
+
+    // Latency statistics and retry policies, guarded by requests_mutex_
+    std::array<LatencyTracker, 128> ecu_stats_;   // indexed by ECU id without the response bit
+    std::array<RetryPolicy, 256> policies_;       // indexed by command byte
+
+    // Instrumentation, written under requests_mutex_
+    struct Metrics {
+        metrics::Counter requests;
+        metrics::Counter rejected;
+        metrics::Counter responses;
+        metrics::Counter timeouts;
+        metrics::Counter retries;
+        metrics::Counter naks;
+        std::array<metrics::Counter, 256> naks_by_status;
+        size_t max_queue_depth = 0;
+        metrics::Histogram round_trip_ns;
+    };
+    Metrics metrics_;
 
-    // Timeout management
+    // Timeout management: one timer per pending request, guarded by requests_mutex_.
+    // The worker sleeps until the next timer or paced transmission and is only
+    // woken early when something is scheduled before the time it waits for.
+    TimerWheel timers_;
+    std::chrono::steady_clock::time_point worker_deadline_ = std::chrono::steady_clock::time_point::max();
     std::thread timeout_thread_;
     std::atomic<bool> stop_timeout_thread_{false};
     std::condition_variable timeout_cv_;
 
     void timeoutWorker();
-    void checkTimeouts();
-    uint32_t generateRequestId();
-
-    // Frame conversion utilities
-    VdpFrame convertToVdpFrame(const protocol::Frame& frame);
-    protocol::Frame convertFromVdpFrame(const VdpFrame& frame);
-    protocol::Response createResponse(protocol::Status status,
-                                           const VdpFrame& frame);
+    std::chrono::steady_clock::time_point nextWakeupNoLock() const;
+
+    // Remove requests whose timer has fired, appending them to expired
+    void collectExpiredNoLock(std::chrono::steady_clock::time_point now, std::vector<PendingRequest>& expired);
+
+    // Queue a request for its ECU and transmit it when the scheduler allows,
+    // a frame with too much data completes at once with an error
+    void submitRequest(protocol::Frame frame,
+                       std::chrono::milliseconds timeout,
+                       CompletionCallback on_complete);
+
+    // Move the next ready request into flight if pacing allows
+    bool dispatchNextNoLock(std::chrono::steady_clock::time_point now, Dispatch& out);
+    void transmit(const Dispatch& dispatch);
+    // Dispatch and transmit requests until pacing or the queues stop it
+    void pumpQueue();
+    // Mark the ECU idle and make its next queued request ready
+    void releaseEcuNoLock(uint8_t ecu_id);
+    // Next queued request of an ECU, its queue must not be empty
+    QueuedRequest& frontNoLock(const EcuQueue& queue) { return queue_pool_[queue.waiting.head]; }
+    // Remove every in-flight and queued request
+    void drainAllNoLock(std::vector<PendingRequest>& out);
+
+    // Remove and return the oldest pending request addressed to ecu_id with this command, O(1).
+    // Records the response time; the ECU stays busy until completeRequest().
+    bool takeMatchingRequest(uint8_t ecu_id, uint8_t command, PendingRequest& out);
+    // Release the request's ECU and deliver the response, or requeue the
+    // request if the ECU was busy and its policy allows another attempt
+    void completeRequest(PendingRequest& request, protocol::Response&& response, bool ecu_busy);
+    // Put a request back at the front of its ECU's queue if its policy allows
+    bool retryNoLock(PendingRequest& request, std::chrono::steady_clock::time_point now);
+    EcuStats ecuStatsNoLock(uint8_t ecu_id) const;
+
+    // Response frame handling
+    void handleAckNak(VdpFrame&& frame, bool is_ack);
+    void sendNak(uint8_t ecu_id, uint8_t command, ResponseStatus status);
+
+    // Frame conversion utilities, both frame types share the DATA vector type so it is moved
+    protocol::Frame convertFromVdpFrame(VdpFrame&& frame);
+    protocol::Response createResponse(protocol::Status status, VdpFrame&& frame, std::string error = {});
 };
 
+#if defined(VDP_HAS_COROUTINES)
+/**
+ * @brief Awaitable returned by VDPEngine::request()
+ *
+ * Lives in the awaiting coroutine's frame. The completion callback only
+ * holds a pointer to it, which fits std::function's inline storage, so
+ * awaiting does not allocate. Must be awaited exactly once.
+ */
+class RequestAwaitable {
+public:
+    RequestAwaitable(VDPEngine& engine, protocol::Frame frame, std::chrono::milliseconds timeout)
+        : engine_(engine), frame_(std::move(frame)), timeout_(timeout) {}
+
+    RequestAwaitable(const RequestAwaitable&) = delete;
+    RequestAwaitable& operator=(const RequestAwaitable&) = delete;
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        handle_ = handle;
+        engine_.submitRequest(std::move(frame_), timeout_, [this](protocol::Response&& response) {
+            response_ = std::move(response);
+            // Whoever comes second resumes: this callback, or await_suspend below
+            if (completed_.exchange(true, std::memory_order_acq_rel)) {
+                handle_.resume();
+            }
+        });
+        // Completed during submission (send failure, table full, data too large): do not suspend
+        return !completed_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    protocol::Response await_resume() { return std::move(response_); }
+
+private:
+    VDPEngine& engine_;
+    protocol::Frame frame_;
+    std::chrono::milliseconds timeout_;
+    std::coroutine_handle<> handle_;
+    std::atomic<bool> completed_{false};
+    protocol::Response response_{};
+};
+
+inline RequestAwaitable VDPEngine::request(const protocol::Frame& frame, std::chrono::milliseconds timeout) {
+    return RequestAwaitable(*this, frame, timeout);
+}
+#endif
+
 } // namespace protocol
 } // namespace vdp
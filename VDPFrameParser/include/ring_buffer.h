@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+namespace vdp {
+
+/**
+ * @brief Non-owning view over a contiguous run of bytes
+ *
+ * Minimal stand-in for std::span<const uint8_t> while the project builds as C++17.
+ */
+struct ByteSpan {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    const uint8_t* begin() const { return data; }
+    const uint8_t* end() const { return data + size; }
+    uint8_t operator[](size_t index) const { return data[index]; }
+    bool empty() const { return size == 0; }
+
+    ByteSpan subspan(size_t offset, size_t count) const { return {data + offset, count}; }
+    ByteSpan subspan(size_t offset) const { return {data + offset, size - offset}; }
+};
+
+/**
+ * @brief Contiguous byte ring used as the parser's receive buffer
+ *
+ * Unread bytes always form a single contiguous span, so frame scanning never
+ * has to deal with a wrap point. Consuming bytes only advances the read index;
+ * the unread tail is slid back to the front lazily, when a write would not
+ * otherwise fit. Since the parser consumes everything except a partial frame,
+ * that slide moves at most a few hundred bytes.
+ *
+ * The capacity is fixed at construction and only grows when a single burst
+ * does not fit even after compaction.
+ */
+class RingBuffer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+    explicit RingBuffer(size_t capacity = DEFAULT_CAPACITY)
+        : storage_(new uint8_t[capacity ? capacity : 1]), capacity_(capacity ? capacity : 1) {}
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    /**
+     * @brief Append bytes to the end of the readable region
+     */
+    void write(const uint8_t* data, size_t len) {
+        if (len == 0) {
+            return;
+        }
+        makeRoom(len);
+        std::memcpy(storage_.get() + write_pos_, data, len);
+        write_pos_ += len;
+    }
+
+    /**
+     * @brief Borrow n writable bytes at the end of the readable region
+     *
+     * Lets a reader fill the buffer in place instead of calling write();
+     * the bytes become readable with commitWrite(). Until then consume()
+     * and clear() leave the region where it is, so it may be filled
+     * without holding the lock that guards the buffer.
+     * @note Invalidated by the next write() or prepareWrite()
+     */
+    uint8_t* prepareWrite(size_t n) {
+        makeRoom(n);
+        lent_ = true;
+        return storage_.get() + write_pos_;
+    }
+
+    /**
+     * @brief Append the first n bytes of the region from prepareWrite()
+     */
+    void commitWrite(size_t n) {
+        write_pos_ += n;
+        lent_ = false;
+    }
+
+    // Give back the region from prepareWrite() without appending anything
+    void cancelWrite() { lent_ = false; }
+
+    /**
+     * @brief Contiguous view of all unread bytes
+     * @note Invalidated by the next write(), prepareWrite() or clear()
+     */
+    ByteSpan readable() const { return {storage_.get() + read_pos_, write_pos_ - read_pos_}; }
+
+    /**
+     * @brief Drop the first n unread bytes
+     */
+    void consume(size_t n) {
+        read_pos_ += n;
+        consumed_ += n;
+        if (read_pos_ >= write_pos_ && !lent_) {
+            // Fully drained, rewind for free instead of compacting later
+            read_pos_ = 0;
+            write_pos_ = 0;
+        }
+    }
+
+    void clear() {
+        // A lent region stays put, everything before it is dropped
+        write_pos_ = lent_ ? write_pos_ : 0;
+        read_pos_ = write_pos_;
+        consumed_ = 0;
+    }
+
+    // Stream offset of the first unread byte: total bytes consumed since construction or clear()
+    uint64_t consumedTotal() const { return consumed_; }
+
+    size_t size() const { return write_pos_ - read_pos_; }
+    bool empty() const { return write_pos_ == read_pos_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    void makeRoom(size_t len) {
+        if (write_pos_ + len <= capacity_) {
+            return;
+        }
+
+        const size_t unread = size();
+        if (unread + len <= capacity_) {
+            // Enough space overall, slide the unread tail to the front
+            std::memmove(storage_.get(), storage_.get() + read_pos_, unread);
+        } else {
+            size_t new_capacity = capacity_;
+            while (new_capacity < unread + len) {
+                new_capacity *= 2;
+            }
+            std::unique_ptr<uint8_t[]> grown(new uint8_t[new_capacity]);
+            std::memcpy(grown.get(), storage_.get() + read_pos_, unread);
+            storage_ = std::move(grown);
+            capacity_ = new_capacity;
+        }
+        read_pos_ = 0;
+        write_pos_ = unread;
+    }
+
+    std::unique_ptr<uint8_t[]> storage_;
+    size_t capacity_;
+    size_t read_pos_ = 0;
+    size_t write_pos_ = 0;
+    uint64_t consumed_ = 0;
+    bool lent_ = false;         // between prepareWrite() and commitWrite()/cancelWrite()
+};
+
+} // namespace vdp
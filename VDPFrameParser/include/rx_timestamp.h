@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace vdp {
+
+/**
+ * @brief Monotonic reception time of a parse result
+ *
+ * steady_clock nanoseconds in one int64_t, so copying one around costs
+ * nothing and reading it never touches the wall clock. A transport with
+ * hardware RX timestamps builds them with fromSteady().
+ */
+struct RxTimestamp {
+    int64_t ticks = 0;      // steady_clock nanoseconds, 0: not taken
+
+    static RxTimestamp now() { return fromSteady(std::chrono::steady_clock::now()); }
+
+    static RxTimestamp fromSteady(std::chrono::steady_clock::time_point time) {
+        return {std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count()};
+    }
+
+    bool valid() const { return ticks != 0; }
+
+    std::chrono::steady_clock::time_point toSteady() const {
+        return std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(ticks)));
+    }
+
+    /**
+     * @brief Wall-clock time, converted on demand
+     *
+     * Uses the offset between the two clocks sampled on first use, so wall
+     * clock adjustments made later are not reflected.
+     */
+    std::chrono::system_clock::time_point toSystem() const {
+        static const std::chrono::nanoseconds offset =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()) -
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch());
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ticks) + offset));
+    }
+
+    friend bool operator==(RxTimestamp a, RxTimestamp b) { return a.ticks == b.ticks; }
+    friend bool operator!=(RxTimestamp a, RxTimestamp b) { return a.ticks != b.ticks; }
+};
+
+} // namespace vdp
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "ring_buffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace vdp {
+
+/**
+ * @brief Lock-free single-producer/single-consumer byte ring
+ *
+ * One thread calls write() or prepareWrite()/commitWrite(), one other
+ * thread calls readable()/release(). Indices increase monotonically and are
+ * published with release stores and observed with acquire loads, so bytes
+ * are visible to the consumer before the index that covers them. Each side
+ * caches the other side's index and only re-reads it when the cached value
+ * says the ring is full or empty.
+ */
+class SpscByteRing {
+public:
+    // @param capacity Requested capacity, rounded up to a power of two
+    explicit SpscByteRing(size_t capacity) : capacity_(roundUp(capacity)), mask_(capacity_ - 1),
+                                             storage_(new uint8_t[capacity_]) {}
+
+    SpscByteRing(const SpscByteRing&) = delete;
+    SpscByteRing& operator=(const SpscByteRing&) = delete;
+
+    /**
+     * @brief Producer: append as many bytes as fit
+     * @return Number of bytes accepted (less than len when the ring is full)
+     */
+    size_t write(const uint8_t* data, size_t len) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        size_t free_space = capacity_ - (head - producer_cached_tail_);
+        if (free_space < len) {
+            producer_cached_tail_ = tail_.load(std::memory_order_acquire);
+            free_space = capacity_ - (head - producer_cached_tail_);
+        }
+
+        const size_t n = len < free_space ? len : free_space;
+        if (n == 0) {
+            return 0;
+        }
+        const size_t offset = head & mask_;
+        const size_t first = n < capacity_ - offset ? n : capacity_ - offset;
+        std::memcpy(storage_.get() + offset, data, first);
+        std::memcpy(storage_.get(), data + first, n - first);
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * @brief Producer: borrow n contiguous free bytes to write into in place
+     * @return nullptr when n bytes are not free before the wrap point
+     * @note Publish the bytes with commitWrite(); no other producer call in between
+     */
+    uint8_t* prepareWrite(size_t n) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (capacity_ - (head - producer_cached_tail_) < n) {
+            producer_cached_tail_ = tail_.load(std::memory_order_acquire);
+        }
+        const size_t offset = head & mask_;
+        if (capacity_ - (head - producer_cached_tail_) < n || capacity_ - offset < n) {
+            return nullptr;
+        }
+        return storage_.get() + offset;
+    }
+
+    /**
+     * @brief Producer: publish the first n bytes of the region from prepareWrite()
+     */
+    void commitWrite(size_t n) {
+        head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    /**
+     * @brief Consumer: view all readable bytes as at most two contiguous spans
+     * @return Total number of readable bytes
+     */
+    size_t readable(ByteSpan& first, ByteSpan& second) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (consumer_cached_head_ == tail) {
+            consumer_cached_head_ = head_.load(std::memory_order_acquire);
+        }
+
+        const size_t available = consumer_cached_head_ - tail;
+        const size_t offset = tail & mask_;
+        const size_t first_len = available < capacity_ - offset ? available : capacity_ - offset;
+        first = {storage_.get() + offset, first_len};
+        second = {storage_.get(), available - first_len};
+        return available;
+    }
+
+    /**
+     * @brief Consumer: hand n bytes (previously returned by readable()) back to the producer
+     */
+    void release(size_t n) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // Any thread: true if no bytes are readable right now
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    static size_t roundUp(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+    static constexpr size_t CACHE_LINE = 64;
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<uint8_t[]> storage_;
+
+    // Producer-owned line
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0};
+    size_t producer_cached_tail_ = 0;
+
+    // Consumer-owned line
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0};
+    size_t consumer_cached_head_ = 0;
+};
+
+/**
+ * @brief Lock-free single-producer/single-consumer queue of fixed-size records
+ *
+ * Same protocol as SpscByteRing, with whole records instead of bytes. The
+ * consumer reads records in place, so T must be trivially copyable.
+ */
+template <typename T>
+class SpscQueue {
+    static_assert(std::is_trivially_copyable<T>::value, "SpscQueue records are copied as bytes");
+
+public:
+    // @param capacity Requested capacity, rounded up to a power of two
+    explicit SpscQueue(size_t capacity) : capacity_(roundUp(capacity)), mask_(capacity_ - 1),
+                                          storage_(new T[capacity_]) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * @brief Producer: records that can be pushed without failing
+     */
+    size_t freeSlots() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - producer_cached_tail_ == capacity_) {
+            producer_cached_tail_ = tail_.load(std::memory_order_acquire);
+        }
+        return capacity_ - (head - producer_cached_tail_);
+    }
+
+    /**
+     * @brief Producer: append one record
+     * @return false when the queue is full
+     */
+    bool push(const T& record) {
+        if (freeSlots() == 0) {
+            return false;
+        }
+        const size_t head = head_.load(std::memory_order_relaxed);
+        storage_[head & mask_] = record;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer: call fn(const T&) for up to max records, oldest first
+     *
+     * The records are released to the producer after fn has seen all of them.
+     * @return Number of records consumed
+     */
+    template <typename Fn>
+    size_t consume(Fn&& fn, size_t max = SIZE_MAX) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (consumer_cached_head_ == tail) {
+            consumer_cached_head_ = head_.load(std::memory_order_acquire);
+        }
+        size_t count = consumer_cached_head_ - tail;
+        count = count < max ? count : max;
+        for (size_t i = 0; i < count; ++i) {
+            fn(static_cast<const T&>(storage_[(tail + i) & mask_]));
+        }
+        if (count != 0) {
+            tail_.store(tail + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // Any thread: true if no records are queued right now
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    static size_t roundUp(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+    static constexpr size_t CACHE_LINE = 64;
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> storage_;
+
+    // Producer-owned line
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0};
+    size_t producer_cached_tail_ = 0;
+
+    // Consumer-owned line
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0};
+    size_t consumer_cached_head_ = 0;
+};
+
+} // namespace vdp
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace vdp {
+
+/**
+ * @brief Hierarchical timer wheel on steady_clock with 1ms resolution
+ *
+ * Four levels of 64 slots cover about 4.6 hours; later deadlines are parked
+ * in the top level slot visited last and re-inserted when it comes up. A timer lives in
+ * the lowest level whose parent block also contains the current tick, and
+ * moves down one level each time the wheel enters its block.
+ *
+ * Timer nodes live in a preallocated array (intrusive slot lists and a free
+ * list), so arm() and cancel() are O(1) with no per-timer allocation.
+ * Per-level occupancy bitmaps let nextDeadline() and idle stretches in
+ * advance() skip empty slots without visiting them. Timers never fire early.
+ * The wheel is not synchronized.
+ */
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = uint32_t;
+    static constexpr TimerId INVALID_TIMER = 0;
+    static constexpr size_t MAX_TIMERS = 0xFFFF; // node index must fit the low half of an id
+
+    // @param origin Tick zero; deadlines before it fire on the next advance()
+    // @param capacity Nodes allocated up front, the pool doubles when they run out
+    explicit TimerWheel(Clock::time_point origin = Clock::now(), size_t capacity = 64) : origin_(origin) {
+        for (auto& level : slots_) {
+            level.fill(NONE);
+        }
+        grow(capacity < 1 ? 1 : capacity);
+    }
+
+    /**
+     * @brief Arm a timer
+     * @param payload Returned to the advance() callback when the timer fires
+     * @return Timer id for cancel(), INVALID_TIMER if MAX_TIMERS are armed
+     */
+    TimerId arm(Clock::time_point deadline, uint64_t payload) {
+        if (free_head_ == NONE && !grow(nodes_.size() * 2)) {
+            return INVALID_TIMER;
+        }
+
+        const uint32_t index = free_head_;
+        Node& node = nodes_[index];
+        free_head_ = node.next;
+
+        // Round up so the timer cannot fire before its deadline
+        uint64_t tick = 0;
+        if (deadline > origin_) {
+            tick = static_cast<uint64_t>((deadline - origin_ + TICK - Clock::duration(1)) / TICK);
+        }
+        node.expires = tick > current_tick_ ? tick : current_tick_ + 1;
+        node.payload = payload;
+        node.armed = true;
+        place(index);
+
+        ++size_;
+        return (static_cast<TimerId>(node.generation) << 16) | (index + 1);
+    }
+
+    /**
+     * @brief Disarm a timer that has not fired yet
+     * @return false if the timer already fired, was cancelled or the id is invalid
+     */
+    bool cancel(TimerId id) {
+        const uint32_t index = (id & 0xFFFF) - 1;
+        if (id == INVALID_TIMER || index >= nodes_.size() || !nodes_[index].armed ||
+            nodes_[index].generation != (id >> 16)) {
+            return false;
+        }
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    /**
+     * @brief Fire every timer whose deadline is at or before now
+     * @param on_expired Called as on_expired(payload); it must not arm or cancel timers
+     * @return Number of timers fired
+     */
+    template <typename Fn>
+    size_t advance(Clock::time_point now, Fn&& on_expired) {
+        if (now < origin_) {
+            return 0;
+        }
+        const uint64_t target = static_cast<uint64_t>((now - origin_) / TICK);
+        size_t fired = 0;
+
+        while (current_tick_ < target) {
+            if (size_ == 0) {
+                current_tick_ = target;
+                break;
+            }
+
+            // Skip ticks where no slot can need attention: with levels below L
+            // empty, nothing happens until the next block boundary of level L
+            uint64_t step_to = current_tick_ + 1;
+            for (size_t level = 0; level < LEVELS && occupied_[level] == 0; ++level) {
+                const uint64_t block = uint64_t(1) << (SLOT_BITS * (level + 1));
+                step_to = (current_tick_ | (block - 1)) + 1;
+            }
+            current_tick_ = step_to < target ? step_to : target;
+
+            cascade();
+
+            const size_t slot = current_tick_ & SLOT_MASK;
+            uint32_t index = slots_[0][slot];
+            slots_[0][slot] = NONE;
+            occupied_[0] &= ~(uint64_t(1) << slot);
+            while (index != NONE) {
+                const uint32_t next = nodes_[index].next;
+                if (nodes_[index].expires <= current_tick_) {
+                    const uint64_t payload = nodes_[index].payload;
+                    release(index);
+                    on_expired(payload);
+                    ++fired;
+                } else {
+                    place(index); // no longer in this block after a skip
+                }
+                index = next;
+            }
+        }
+        return fired;
+    }
+
+    /**
+     * @brief Time of the next advance() that can fire or move timers
+     *
+     * Exact for timers due within the current 64ms block; later ones report
+     * the start of their slot, where they are moved one level down.
+     * @return time_point::max() if no timer is armed
+     */
+    Clock::time_point nextDeadline() const {
+        for (size_t level = 0; level < LEVELS; ++level) {
+            if (occupied_[level] == 0) {
+                continue;
+            }
+            const unsigned shift = static_cast<unsigned>(SLOT_BITS * level);
+            const uint64_t current_slot = (current_tick_ >> shift) & SLOT_MASK;
+            // Occupied slots always lie ahead of the current one; only the top
+            // level wraps around, lower levels stay inside their parent block
+            const uint64_t rotated = (occupied_[level] >> current_slot) |
+                                     (current_slot != 0 ? occupied_[level] << (SLOTS - current_slot) : 0);
+            const uint64_t distance = lowestBit(rotated);
+            return origin_ + TICK * static_cast<int64_t>(((current_tick_ >> shift) + distance) << shift);
+        }
+        return Clock::time_point::max();
+    }
+
+    /**
+     * @brief Disarm all timers
+     */
+    void clear() {
+        for (size_t level = 0; level < LEVELS; ++level) {
+            for (size_t slot = 0; slot < SLOTS; ++slot) {
+                uint32_t index = slots_[level][slot];
+                while (index != NONE) {
+                    const uint32_t next = nodes_[index].next;
+                    release(index);
+                    index = next;
+                }
+                slots_[level][slot] = NONE;
+            }
+            occupied_[level] = 0;
+        }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    static constexpr Clock::duration TICK = std::chrono::milliseconds(1);
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    struct Node {
+        uint64_t expires = 0;      // tick
+        uint64_t payload = 0;
+        uint32_t prev = NONE;
+        uint32_t next = NONE;      // next in the slot list, or in the free list
+        uint16_t generation = 0;
+        uint8_t level = 0;
+        uint8_t slot = 0;
+        bool armed = false;
+    };
+
+    // Index of the lowest set bit, mask must be non-zero
+    static unsigned lowestBit(uint64_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+    }
+
+    // Link a node into the slot matching its expiry relative to current_tick_
+    void place(uint32_t index) {
+        Node& node = nodes_[index];
+        size_t level = 0;
+        while (level + 1 < LEVELS &&
+               (node.expires >> (SLOT_BITS * (level + 1))) != (current_tick_ >> (SLOT_BITS * (level + 1)))) {
+            ++level;
+        }
+
+        const unsigned shift = static_cast<unsigned>(SLOT_BITS * level);
+        size_t slot = (node.expires >> shift) & SLOT_MASK;
+        if (level == LEVELS - 1 && (node.expires >> shift) - (current_tick_ >> shift) > SLOT_MASK) {
+            // Beyond one rotation of the top level: park in the slot visited last
+            slot = ((current_tick_ >> shift) - 1) & SLOT_MASK;
+        }
+
+        node.level = static_cast<uint8_t>(level);
+        node.slot = static_cast<uint8_t>(slot);
+        node.prev = NONE;
+        node.next = slots_[level][slot];
+        if (node.next != NONE) {
+            nodes_[node.next].prev = index;
+        }
+        slots_[level][slot] = index;
+        occupied_[level] |= uint64_t(1) << slot;
+    }
+
+    void unlink(uint32_t index) {
+        Node& node = nodes_[index];
+        if (node.prev != NONE) {
+            nodes_[node.prev].next = node.next;
+        } else {
+            slots_[node.level][node.slot] = node.next;
+            if (node.next == NONE) {
+                occupied_[node.level] &= ~(uint64_t(1) << node.slot);
+            }
+        }
+        if (node.next != NONE) {
+            nodes_[node.next].prev = node.prev;
+        }
+    }
+
+    void release(uint32_t index) {
+        Node& node = nodes_[index];
+        node.armed = false;
+        ++node.generation;
+        node.next = free_head_;
+        free_head_ = index;
+        --size_;
+    }
+
+    // On entering a new block of a level, redistribute that block's slot one level down
+    void cascade() {
+        for (size_t level = 1; level < LEVELS; ++level) {
+            const unsigned shift = static_cast<unsigned>(SLOT_BITS * level);
+            if ((current_tick_ & ((uint64_t(1) << shift) - 1)) != 0) {
+                break;
+            }
+            const size_t slot = (current_tick_ >> shift) & SLOT_MASK;
+            uint32_t index = slots_[level][slot];
+            slots_[level][slot] = NONE;
+            occupied_[level] &= ~(uint64_t(1) << slot);
+            while (index != NONE) {
+                const uint32_t next = nodes_[index].next;
+                place(index);
+                index = next;
+            }
+        }
+    }
+
+    bool grow(size_t new_capacity) {
+        const size_t old_capacity = nodes_.size();
+        if (new_capacity > MAX_TIMERS) {
+            new_capacity = MAX_TIMERS;
+        }
+        if (new_capacity <= old_capacity) {
+            return false;
+        }
+        nodes_.resize(new_capacity);
+        for (size_t i = new_capacity; i-- > old_capacity;) {
+            nodes_[i].next = free_head_;
+            free_head_ = static_cast<uint32_t>(i);
+        }
+        return true;
+    }
+
+    Clock::time_point origin_;
+    uint64_t current_tick_ = 0;
+    std::vector<Node> nodes_;
+    std::array<std::array<uint32_t, SLOTS>, LEVELS> slots_;
+    std::array<uint64_t, LEVELS> occupied_{};
+    uint32_t free_head_ = NONE;
+    size_t size_ = 0;
+};
+
+} // namespace vdp
@@ -1,13 +1,25 @@
 #pragma once
 
+#include "vdp_parser.h"
+
 #include <functional>
 #include <memory>
 #include <string>
 #include <cstdint>
+#include <cstring>
+#include <vector>
 
 namespace vdp {
 namespace transport {
 
+/**
+ * @brief One contiguous piece of an outgoing message, see ITransport::sendv()
+ */
+struct IoSlice {
+    const uint8_t* data;
+    size_t length;
+};
+
 /**
  * @brief Transport layer interface for different communication channels
  * 
@@ -21,6 +33,19 @@ public:
     // Callback type for received data
     using DataCallback = std::function<void(const uint8_t* data, size_t length)>;
     using ErrorCallback = std::function<void(const std::string& error)>;
+
+    /**
+     * @brief Consumer-owned memory to receive into, see setReceiveBuffer()
+     *
+     * prepare(capacity) lends a region of at least capacity bytes; the
+     * transport reads into it and hands the lease back with commit(lease,
+     * length) once length bytes arrived. A read that fails just drops the
+     * lease, which gives the region back untouched.
+     */
+    struct ReceiveBuffer {
+        std::function<VdpParser::WriteLease(size_t capacity)> prepare;
+        std::function<void(VdpParser::WriteLease lease, size_t length)> commit;
+    };
     
     /**
      * @brief Initialize the transport with connection parameters
@@ -36,6 +61,45 @@ public:
      * @return true if send successful, false otherwise
      */
     virtual bool send(const uint8_t* data, size_t length) = 0;
+
+    /**
+     * @brief Send several slices as one message (scatter-gather)
+     *
+     * The default gathers the slices into one buffer and calls send().
+     * Transports with a native vectored write (writev, sendmsg) should
+     * override this to transmit the slices without copying them.
+     * @param slices Array of slices, sent in order
+     * @param count Number of slices
+     * @return true if send successful, false otherwise
+     */
+    virtual bool sendv(const IoSlice* slices, size_t count) {
+        if (count == 1) {
+            return send(slices[0].data, slices[0].length);
+        }
+
+        size_t total = 0;
+        for (size_t i = 0; i < count; ++i) {
+            total += slices[i].length;
+        }
+
+        // Frames always fit on the stack, larger messages fall back to the heap
+        uint8_t stack_buffer[256];
+        std::vector<uint8_t> heap_buffer;
+        uint8_t* buffer = stack_buffer;
+        if (total > sizeof(stack_buffer)) {
+            heap_buffer.resize(total);
+            buffer = heap_buffer.data();
+        }
+
+        size_t offset = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (slices[i].length != 0) {
+                std::memcpy(buffer + offset, slices[i].data, slices[i].length);
+                offset += slices[i].length;
+            }
+        }
+        return send(buffer, total);
+    }
     
     /**
      * @brief Set callback for received data
@@ -43,6 +107,19 @@ public:
      */
     virtual void setDataCallback(DataCallback callback) = 0;
     
+    /**
+     * @brief Receive directly into consumer memory instead of calling the data callback
+     *
+     * Transports that read a byte stream with read()/recv() can pass the
+     * consumer's buffer to the system call and skip their own copy. The
+     * default does not support it and keeps using the data callback.
+     * @return true if the transport will use buffer for received data
+     */
+    virtual bool setReceiveBuffer(ReceiveBuffer buffer) {
+        (void)buffer;
+        return false;
+    }
+
     /**
      * @brief Set callback for transport errors
      * @param callback Function to call when transport error occurs
@@ -77,9 +154,17 @@ public:
         SERIAL,    // Serial/USB
         CAN,       // CAN bus
         DOIP,      // Diagnostic over IP
-        BLUETOOTH  // Bluetooth
+        BLUETOOTH, // Bluetooth
+        TCP        // Plain VDP byte stream over TCP, without DoIP framing
     };
     
+    /**
+     * @brief Create a transport of the given type
+     *
+     * SERIAL, CAN and TCP transports share EventLoop::shared(), see
+     * fd_transport.h and can_transport.h.
+     * @return nullptr for types without an implementation
+     */
     static std::unique_ptr<ITransport> create(Type type);
 };
 
@@ -39,6 +39,7 @@ namespace vdp {
         // Callbacks for asynchronous operations.
         using ResponseCallback = std::function<void(const Response&)>;
         using ErrorCallback = std::function<void(const std::string&)>;
+        using BatchCallback = std::function<void(const std::vector<Response>&)>;
 
     } // namespace protocol
 } // namespace vdp
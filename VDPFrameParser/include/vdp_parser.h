@@ -5,28 +5,41 @@
 #ifndef VDP_PARSER_H
 #define VDP_PARSER_H
 
+#include "inline_frame.h"
+#include "metrics.h"
+#include "payload_pool.h"
+#include "ring_buffer.h"
+#include "rx_timestamp.h"
+#include "spsc_ring.h"
+
+#include <array>
 #include <cstdint>
-#include <deque>
 #include <utility>
 #include <vector>
 #include <optional>
 #include <string>
-#include <chrono>
-#include <map>
-#include <functional>
 #include <atomic>
+#include <chrono>
+#include <memory>
 #include <mutex>
 
 namespace vdp {
     // Frame format: [0x7E][LEN][ECU_ID][CMD][DATA...][CHECKSUM][0x7F]
     // - LEN includes all bytes (min: 6, max: 255)
     // - CHECKSUM is XOR of all bytes between START and CHECKSUM (exclusive)
-    struct VdpFrame {
-        uint8_t ecu_id;             // Target ECU identifier (0x01-0x7F)
-        uint8_t command;            // Command type
-        std::vector<uint8_t> data;  // Command-specific data (0-247 bytes)
+    // The allocator of the DATA storage is a template parameter, see PooledVdpFrame.
+    template <typename Allocator = std::allocator<uint8_t>>
+    struct BasicVdpFrame {
+        uint8_t ecu_id;                         // Target ECU identifier (0x01-0x7F)
+        uint8_t command;                        // Command type
+        std::vector<uint8_t, Allocator> data;   // Command-specific data (0-247 bytes)
     };
 
+    using VdpFrame = BasicVdpFrame<>;
+
+    // Frame whose DATA comes from a PayloadPool instead of the global heap
+    using PooledVdpFrame = BasicVdpFrame<PoolAllocator<uint8_t>>;
+
     // Status of parse
     enum class ParseStatus {
         Success,    // complete valid frame
@@ -37,6 +50,35 @@ namespace vdp {
         Error       // general error
     };
 
+    // Reason an Invalid result was produced
+    enum class ParseError : uint8_t {
+        None,           // no parse error
+        BadLength,      // LEN outside [MIN_FRAME_LEN, MAX_FRAME_LEN]
+        BadEndMarker,   // byte at LEN-1 is not the end marker
+        BadChecksum,    // XOR of LEN..DATA does not match CHECKSUM
+        Truncated,      // frame too short to carry a checksum
+        Stale           // partial frame older than twice the frame timeout
+    };
+
+    static constexpr size_t PARSE_ERROR_COUNT = static_cast<size_t>(ParseError::Stale) + 1;
+
+    // Fixed-size error details, captured without allocating.
+    // Only the code is filled in when error-detail capture is disabled.
+    struct ParseErrorDetail {
+        ParseError code = ParseError::None;
+        uint8_t length = 0;         // LEN byte (Truncated, Stale: number of bytes available)
+        uint8_t position = 0;       // Index inside the frame where validation failed
+        uint8_t calculated = 0;     // Calculated checksum (BadChecksum)
+        uint8_t expected = 0;       // Checksum carried by the frame (BadChecksum)
+        bool captured = true;       // false with setErrorDetailCapture(false): only code and coalesced are set
+        uint16_t coalesced = 0;     // Further rejected candidates folded into this result, see setInvalidCoalescing()
+        uint32_t run_length = 0;    // Bytes of a coalesced run, from the rejected START byte (0 if not coalesced)
+        uint64_t offset = 0;        // Stream offset of the rejected START byte since last reset
+    };
+
+    // Format a human-readable description of a parse error
+    std::string describeParseError(const ParseErrorDetail& detail);
+
     // Response status codes
     enum class ResponseStatus : uint8_t {
         Success = 0x00,      // Operation successful
@@ -52,6 +94,11 @@ namespace vdp {
     static constexpr uint8_t MIN_STATUS_CODE = 0x00;
     static constexpr uint8_t MAX_STATUS_CODE = 0xFF;
 
+    // Size of the largest frame on the wire, enough for any serializeInto() buffer
+    static constexpr size_t MAX_SERIALIZED_FRAME_SIZE = 253;
+    // Largest DATA field that fits such a frame
+    static constexpr size_t MAX_DATA_SIZE = MAX_SERIALIZED_FRAME_SIZE - 6;
+
     // Command types
     enum class CommandType : uint8_t {
         // Standard VDP commands
@@ -90,98 +137,351 @@ namespace vdp {
     struct ParseResult {
         ParseStatus status;
         std::optional<VdpFrame> frame;
-        std::string error;
+        std::string error;              // Free-form message (request handling), empty for parse errors
+        ParseErrorDetail error_detail;  // Why the parser rejected the frame
         std::vector<uint8_t> raw_bytes;
-        std::chrono::system_clock::time_point timestamp;
+        RxTimestamp timestamp;          // Time of the feed() that completed the result, see setTimestampCapture()
         
-        // Default constructor with current timestamp
-        ParseResult() : status(ParseStatus::Invalid), timestamp(std::chrono::system_clock::now()) {}
+        ParseResult() : status(ParseStatus::Invalid) {}
         
-        // Constructor with parameters
-        ParseResult(ParseStatus s, const std::optional<VdpFrame>& f, std::string  e, const std::vector<uint8_t>& rb)
-            : status(s), frame(f), error(std::move(e)), raw_bytes(rb), timestamp(std::chrono::system_clock::now()) {}
+        // Constructor with parameters, takes ownership of frame and raw bytes
+        ParseResult(ParseStatus s, std::optional<VdpFrame> f, std::string e, std::vector<uint8_t> rb,
+                    RxTimestamp t = {})
+            : status(s), frame(std::move(f)), error(std::move(e)), raw_bytes(std::move(rb)), timestamp(t) {}
+
+        // Human-readable error, formatted on demand from error_detail unless error is set
+        std::string message() const { return error.empty() ? describeParseError(error_detail) : error; }
     };
-    
-    // Response handler function type
-    using ResponseHandler = std::function<void(const ParseResult&)>;
-    
-    // Send callback type
-    using SendCallback = std::function<void(const uint8_t* data, size_t len)>;
-    
-    // Pending request information
-    struct PendingRequest {
-        VdpFrame request_frame;
-        ResponseHandler handler;
-        std::chrono::system_clock::time_point timeout_time;
-        std::atomic<bool> completed{false};
-        
-        // Default constructor
-        PendingRequest() = default;
-        
-        // Move constructor
-        PendingRequest(PendingRequest&& other) noexcept
-            : request_frame(std::move(other.request_frame))
-            , handler(std::move(other.handler))
-            , timeout_time(other.timeout_time)
-            , completed(other.completed.load()) {
+
+    // Borrowed view of a parsed frame, pointing into the parser's buffer
+    struct VdpFrameView {
+        uint8_t ecu_id = 0;
+        uint8_t command = 0;
+        ByteSpan data;              // Command-specific data (0-247 bytes)
+
+        // Copy the view into an owning frame
+        VdpFrame toFrame() const { return {ecu_id, command, std::vector<uint8_t>(data.begin(), data.end())}; }
+
+        // Copy the view into a frame whose DATA is allocated by allocator
+        template <typename Allocator>
+        BasicVdpFrame<Allocator> toFrame(const Allocator& allocator) const {
+            return {ecu_id, command, std::vector<uint8_t, Allocator>(data.begin(), data.end(), allocator)};
         }
-        
-        // Move assignment
-        PendingRequest& operator=(PendingRequest&& other) noexcept {
-            if (this != &other) {
-                request_frame = std::move(other.request_frame);
-                handler = std::move(other.handler);
-                timeout_time = other.timeout_time;
-                completed.store(other.completed.load());
+
+        // Copy the view into an inline frame (DATA never exceeds InlineFrame::CAPACITY)
+        InlineFrame toInlineFrame() const {
+            InlineFrame frame;
+            frame.ecu_id = ecu_id;
+            frame.command = command;
+            frame.assign(data);
+            return frame;
+        }
+    };
+
+    // Borrowed counterpart of ParseResult, produced without heap allocation.
+    // Valid until the next feed() or reset() on the parser that produced it.
+    struct ParseResultView {
+        ParseStatus status = ParseStatus::Invalid;
+        VdpFrameView frame;         // Only meaningful when status == Success
+        ParseErrorDetail error;     // Only meaningful when status == Invalid
+        ByteSpan raw_bytes;         // Empty for errors when detail capture is disabled
+        RxTimestamp timestamp;      // As ParseResult::timestamp
+
+        // Copy the view into an owning result
+        ParseResult toResult() const {
+            std::vector<uint8_t> raw(raw_bytes.begin(), raw_bytes.end());
+            if (status == ParseStatus::Success) {
+                return {ParseStatus::Success, frame.toFrame(), std::string(), std::move(raw), timestamp};
             }
-            return *this;
+            ParseResult result(status, std::nullopt, std::string(), std::move(raw), timestamp);
+            result.error_detail = error;
+            return result;
+        }
+    };
+
+    // Self-contained, trivially copyable result for flat arrays of results.
+    // Raw bytes are not kept; they can be rebuilt with serializeInto() for Success.
+    struct InlineParseResult {
+        ParseStatus status = ParseStatus::Invalid;
+        ParseErrorDetail error;     // Only meaningful when status == Invalid
+        RxTimestamp timestamp;      // As ParseResult::timestamp
+        InlineFrame frame;          // Only meaningful when status == Success
+    };
+
+    static_assert(std::is_trivially_copyable<InlineParseResult>::value, "InlineParseResult must stay trivially copyable");
+
+    // Compact record of one result held in a ParseBatch
+    struct FrameDescriptor {
+        ParseStatus status = ParseStatus::Invalid;
+        uint8_t ecu_id = 0;
+        uint8_t command = 0;
+        ParseErrorDetail error;
+        RxTimestamp timestamp;
+        uint32_t raw_offset = 0;    // Offset of the raw bytes in the batch arena
+        uint16_t raw_length = 0;
+        uint32_t data_offset = 0;   // Offset of DATA in the batch arena
+        uint16_t data_length = 0;
+    };
+
+    /**
+     * @brief Reusable output storage for VdpParser::extractFrames(ParseBatch&)
+     *
+     * Raw bytes of all results are packed into one flat arena next to a
+     * compact descriptor array. clear() keeps both allocations, so once the
+     * batch has grown to the working set, extraction does not allocate.
+     */
+    class ParseBatch {
+    public:
+        explicit ParseBatch(size_t frame_capacity = 64, size_t byte_capacity = 64 * 256) {
+            frames_.reserve(frame_capacity);
+            arena_.reserve(byte_capacity);
+        }
+
+        size_t size() const { return frames_.size(); }
+        bool empty() const { return frames_.empty(); }
+
+        // Drop all results but keep the storage
+        void clear() {
+            frames_.clear();
+            arena_.clear();
+        }
+
+        const FrameDescriptor& descriptor(size_t index) const { return frames_[index]; }
+
+        // View of the index-th result; valid until the batch is cleared or refilled
+        ParseResultView operator[](size_t index) const {
+            const FrameDescriptor& d = frames_[index];
+            ParseResultView view;
+            view.status = d.status;
+            view.frame.ecu_id = d.ecu_id;
+            view.frame.command = d.command;
+            view.frame.data = {arena_.data() + d.data_offset, d.data_length};
+            view.error = d.error;
+            view.timestamp = d.timestamp;
+            view.raw_bytes = {arena_.data() + d.raw_offset, d.raw_length};
+            return view;
+        }
+
+    private:
+        friend class VdpParser;
+
+        void append(const ParseResultView& view) {
+            FrameDescriptor d;
+            d.status = view.status;
+            d.ecu_id = view.frame.ecu_id;
+            d.command = view.frame.command;
+            d.error = view.error;
+            d.timestamp = view.timestamp;
+            d.raw_offset = static_cast<uint32_t>(arena_.size());
+            d.raw_length = static_cast<uint16_t>(view.raw_bytes.size);
+            d.data_offset = d.raw_offset;
+            if (!view.frame.data.empty()) {
+                d.data_offset += static_cast<uint32_t>(view.frame.data.data - view.raw_bytes.data);
+            }
+            d.data_length = static_cast<uint16_t>(view.frame.data.size);
+            arena_.insert(arena_.end(), view.raw_bytes.begin(), view.raw_bytes.end());
+            frames_.push_back(d);
+        }
+
+        std::vector<FrameDescriptor> frames_;
+        std::vector<uint8_t> arena_;
+    };
+    
+    /**
+     * @brief A serialized frame split into header, payload and footer
+     *
+     * Header and footer bytes are stored inline; the payload is borrowed from
+     * the caller and must stay alive until the frame has been sent.
+     */
+    struct FrameSlices {
+        uint8_t header[4];  // [7E][LEN][ECU][CMD]
+        ByteSpan payload;   // [DATA...]
+        uint8_t footer[2];  // [CHK][7F]
+
+        size_t size() const { return sizeof(header) + payload.size + sizeof(footer); }
+    };
+
+    /**
+     * @brief Counters of one parser since construction, see VdpParser::metrics()
+     *
+     * reset() does not clear them. All zero when built with VDP_METRICS=0.
+     */
+    struct ParserMetricsSnapshot {
+        uint64_t bytes_fed = 0;
+        uint64_t bytes_discarded = 0;   // skipped while resynchronizing: garbage and rejected START bytes
+        uint64_t frames = 0;            // Success results
+        std::array<uint64_t, PARSE_ERROR_COUNT> invalid{};  // Invalid results, indexed by ParseError
+        // Time from the last feed() before an extract call to the end of that
+        // call, one sample per frame; empty while timestamps are disabled
+        metrics::HistogramSnapshot feed_to_frame_ns;
+
+        uint64_t invalidTotal() const {
+            uint64_t total = 0;
+            for (uint64_t count : invalid) {
+                total += count;
+            }
+            return total;
         }
-        
-        // Delete copy constructor and assignment
-        PendingRequest(const PendingRequest&) = delete;
-        PendingRequest& operator=(const PendingRequest&) = delete;
+    };
+
+    // How feed() and the extract calls synchronize
+    enum class ConcurrencyMode {
+        Locked,         // any thread may call any method, guarded by a mutex
+        Spsc            // one producer thread feeds, one consumer thread extracts, lock-free
     };
 
     class VdpParser {
     public:
-        // Default constructor with default timeout of 1 second
-        explicit VdpParser(std::chrono::milliseconds default_timeout = std::chrono::seconds(1));
+        // Pure bytes-to-frames / frames-to-bytes codec. Request tracking and
+        // timeouts live in the protocol engine (see protocol_engine.h).
+        // @param frame_timeout A partial frame is dropped as Stale once a feed() arrives
+        //        more than twice this after the feed that started it (needs timestamps)
+        // @param mode Spsc: feed() writes into a lock-free ring and everything else
+        //        (extract*, reset, setters) must be called from a single consumer thread
+        explicit VdpParser(std::chrono::milliseconds frame_timeout = std::chrono::seconds(1),
+                           ConcurrencyMode mode = ConcurrencyMode::Locked);
         
         // Feed raw incoming bytes (maybe partial or batched)
+        // In Spsc mode this waits for the consumer while the feed ring is full.
+        // Results extracted afterwards are stamped with the time of the call.
         void feed(const uint8_t* data, size_t len);
 
+        // As feed(), with a reception time the caller measured (e.g. a hardware RX timestamp)
+        void feed(const uint8_t* data, size_t len, RxTimestamp received);
+
+        /**
+         * @brief Parser memory lent by prepareWrite(), move-only
+         *
+         * Fill some prefix of data() and hand it over with commit(), which
+         * acts as feed() without the copy. A lease that is dropped without a
+         * commit feeds nothing. In Locked mode a lease holds the producer
+         * side of the parser: feed() and prepareWrite() on other threads
+         * wait for it, the extract calls and reset() do not.
+         */
+        class WriteLease {
+        public:
+            WriteLease() = default;
+            WriteLease(WriteLease&& other) noexcept;
+            WriteLease& operator=(WriteLease&& other) noexcept;
+            ~WriteLease() { release(); }
+
+            uint8_t* data() const { return data_; }
+            size_t size() const { return size_; }
+            explicit operator bool() const { return parser_ != nullptr; }
+
+            // Feed the first len bytes of data() (len may be 0) and end the lease.
+            // Does nothing on an empty lease.
+            void commit(size_t len);
+
+            // As commit(), with a reception time the caller measured
+            void commit(size_t len, RxTimestamp received);
+
+            // End the lease without feeding anything
+            void release();
+
+        private:
+            friend class VdpParser;
+
+            VdpParser* parser_ = nullptr;
+            std::unique_lock<std::mutex> lock_;     // Locked mode: the parser's write_mutex_
+            uint8_t* data_ = nullptr;
+            size_t size_ = 0;
+            bool staged_ = false;                   // Spsc mode: data_ is the staging buffer
+        };
+
+        /**
+         * @brief Lend n writable bytes to receive into, e.g. straight from read()
+         *
+         * Locked mode lends the receive buffer itself; Spsc mode lends the
+         * feed ring, or a staging buffer when n bytes do not fit before its
+         * wrap point, and leases must come from the producer thread. A
+         * thread holding a lease ends it before it calls feed() or
+         * prepareWrite() again.
+         * @return Lease of at least n bytes
+         */
+        [[nodiscard]] WriteLease prepareWrite(size_t n);
+
         // Attempt to parse as many frames as possible
         std::vector<ParseResult> extractFrames();
 
+        /**
+         * @brief Parse as many frames as possible into reusable storage
+         * @param out Batch to fill; cleared first, its storage is reused
+         * @return Number of results written to out
+         */
+        size_t extractFrames(ParseBatch& out);
+
+        /**
+         * @brief Parse up to capacity results into a caller-provided array
+         *
+         * Results that do not fit stay buffered for the next call.
+         * @return Number of results written to out
+         */
+        size_t extractFrames(InlineParseResult* out, size_t capacity);
+
+        /**
+         * @brief Zero-copy variant of extractFrames()
+         *
+         * Invokes callback(const ParseResultView&) for every result. The views
+         * borrow from the internal buffer and stay valid until the next feed()
+         * (Spsc mode: the next extract call) or reset(). The callback runs with
+         * the parser locked, so it must not call back into this parser.
+         * @return Number of results delivered
+         */
+        template <typename Callback>
+        size_t extractFrameViews(Callback&& callback);
+
         // Clear internal buffer (e.g. on reset)
         void reset();
-        
-        // Send a frame and set up response handling
-        // @param frame The frame to send
-        // @param handler Callback function to handle the response
-        // @param timeout_ms Optional timeout in milliseconds (0 for default)
-        // TODO: Move to ProtocolEngine layer
-        void sendFrame(const VdpFrame& frame, ResponseHandler handler,
-                      std::chrono::milliseconds timeout_ms = std::chrono::milliseconds(0));
-
-        // Send a frame and wait for response (blocking)
-        // @param frame The frame to send
-        // @param timeout_ms Maximum time to wait for response
-        // @return ParseResult with the response or error
-        // TODO: Move to ProtocolEngine layer
-        ParseResult sendAndWait(const VdpFrame& frame,
-                               std::chrono::milliseconds timeout_ms = std::chrono::milliseconds(1000));
-
-        // Set default timeout for all requests
-        // TODO: Move to ProtocolEngine layer
-        void setDefaultTimeout(std::chrono::milliseconds timeout);
-
-        // Process any pending timeouts
-        // TODO: Move to ProtocolEngine layer
-        void checkTimeouts();
-        // TODO: Move to ProtocolEngine layer
-        void checkTimeoutsNoLock();
 
+        /**
+         * @brief Enable or disable capture of error details (default: enabled)
+         *
+         * When disabled, Invalid results only carry their ParseError code:
+         * raw bytes, checksums and offsets are not captured, and messages
+         * name the error without them.
+         */
+        void setErrorDetailCapture(bool enabled);
+
+        /**
+         * @brief Enable or disable result timestamps (default: enabled)
+         *
+         * The clock is read once per feed() call, not per result. Results
+         * are stamped with the time of the last feed() before they were
+         * extracted. When disabled, the clock is never read, results carry
+         * an invalid RxTimestamp and partial frames never become Stale.
+         */
+        void setTimestampCapture(bool enabled);
+
+        /**
+         * @brief Report a run of rejected candidates as one result (default: disabled)
+         *
+         * When enabled, an Invalid result also swallows the rejected
+         * candidates and garbage that follow it, up to the next frame or
+         * partial candidate. Its error detail is the first rejection's,
+         * with error.coalesced set to the number of further candidates and
+         * error.run_length to the bytes the run covered. raw_bytes stays the
+         * first candidate's (at most MAX_FRAME_LEN). metrics() still counts each one.
+         */
+        void setInvalidCoalescing(bool enabled);
+
+        /**
+         * @brief Report at most max_per_call Invalid results per extract call (default: no limit)
+         *
+         * Candidates rejected beyond the limit are skipped without a result,
+         * so a corrupted burst cannot flood the caller; metrics() still
+         * counts them. A coalesced run counts as one result.
+         */
+        void setInvalidResultLimit(size_t max_per_call);
+
+        /**
+         * @brief Read the parser's counters, from any thread without locking
+         *
+         * Counts are published once per extract call, so results of a call
+         * still running are not included yet.
+         */
+        ParserMetricsSnapshot metrics() const;
+        
         // Generate an ACK frame for the given frame
         VdpFrame createAckFrame(const VdpFrame& frame);
         
@@ -203,49 +503,102 @@ namespace vdp {
          * @param out Output vector for the serialized data
          */
         void serializeFrame(const VdpFrame& frame, std::vector<uint8_t>& out) const;
-        
+
+        /**
+         * @brief Serialize a frame into a caller-provided buffer
+         *
+         * Payload copy and checksum are computed in a single pass.
+         * @param out Destination, MAX_SERIALIZED_FRAME_SIZE bytes always suffice
+         * @param capacity Size of out in bytes
+         * @return Number of bytes written, 0 if the frame does not fit in out
+         *         or its data exceeds the protocol maximum
+         */
+        size_t serializeInto(const VdpFrame& frame, uint8_t* out, size_t capacity) const;
+        size_t serializeInto(uint8_t ecu_id, uint8_t command, ByteSpan data,
+                             uint8_t* out, size_t capacity) const;
+
         /**
-         * @brief Set the send callback for sending responses
-         * @param callback The callback function to use for sending data
+         * @brief Serialize a frame as header/payload/footer slices without copying the payload
+         * @param out Receives the slices, out.payload borrows from data
+         * @return false if the data exceeds the protocol maximum
          */
-        // TODO: Move to ProtocolEngine layer
-        void setSendCallback(SendCallback callback) { send_callback_ = std::move(callback); }
+        bool serializeSlices(const VdpFrame& frame, FrameSlices& out) const;
+        bool serializeSlices(uint8_t ecu_id, uint8_t command, ByteSpan data, FrameSlices& out) const;
 
+        /**
+         * @brief Evaluate the frame candidate at the start of window
+         *
+         * The stateless step behind every extract call, window[0] must be a
+         * START byte. Success: out is the frame and out.raw_bytes spans all of
+         * it. Invalid: out.error holds code, length and position (no offset),
+         * out.raw_bytes the rejected candidate; scanning resumes at window[1].
+         * Incomplete: the candidate's LEN reaches past the end of window.
+         */
+        static ParseStatus parseCandidate(ByteSpan window, ParseResultView& out);
+        
     private:
-        // Internal buffer for incoming data
-        std::deque<uint8_t> buffer_;
+        // Internal buffer for incoming data, unread bytes are always contiguous
+        RingBuffer buffer_;
         
-        // Mutex for thread safety
+        // Mutex for thread safety (Locked mode)
         std::mutex mutex_;
+
+        // Serializes producers (Locked mode): held by feed() and by a WriteLease
+        // for its lifetime, always taken before mutex_
+        std::mutex write_mutex_;
+
+        // Lock-free staging ring between producer and consumer (Spsc mode only)
+        std::unique_ptr<SpscByteRing> feed_ring_;
+        static constexpr size_t FEED_RING_CAPACITY = 64 * 1024;
+
+        // Producer-side region lent by prepareWrite() when the feed ring had no room for it
+        std::vector<uint8_t> staging_;
         
-        // Default timeout for requests
-        std::chrono::milliseconds default_timeout_;
-        
-        // Map of pending requests by sequence number or command ID
-        std::map<uint8_t, PendingRequest> pending_requests_;
-        
-        // Last used sequence number
-        std::atomic<uint8_t> last_sequence_{0};
-        
-        // Callback for sending data
-        // TODO: Move to ProtocolEngine layer
-        SendCallback send_callback_;
-        // Frame parsing state
-        bool frame_started_ = false;
+        // Partial frames older than twice this are considered stale
+        std::chrono::milliseconds frame_timeout_;
+
+        // Whether Invalid results carry raw bytes and detail fields
+        bool capture_error_details_ = true;
+
+        // Invalid result reporting, see setInvalidCoalescing() and setInvalidResultLimit()
+        bool coalesce_invalid_ = false;
+        size_t invalid_limit_ = SIZE_MAX;
+        size_t invalid_reported_ = 0;   // in the current extract call
+
+        // Stamp of the last feed(), written by the producer in Spsc mode
+        std::atomic<bool> capture_timestamps_{true};
+        std::atomic<int64_t> last_feed_ticks_{0};
+        RxTimestamp batch_timestamp_;   // last_feed_ticks_ as of the current extract call
+
+        // Instrumentation, bytes_fed written by the producer and the rest by
+        // the consumer. Results are tallied in plain fields and published at
+        // the end of each extract call.
+        struct Metrics {
+            metrics::Counter bytes_fed;
+            metrics::Counter bytes_discarded;
+            metrics::Counter frames;
+            std::array<metrics::Counter, PARSE_ERROR_COUNT> invalid;
+            metrics::Histogram feed_to_frame_ns;
+        };
+        struct Tally {
+            uint64_t bytes_discarded = 0;
+            uint64_t frames = 0;
+            std::array<uint64_t, PARSE_ERROR_COUNT> invalid{};
+
+            void discard(size_t bytes) { if constexpr (metrics::ENABLED) bytes_discarded += bytes; }
+            void frame() { if constexpr (metrics::ENABLED) ++frames; }
+            void reject(ParseError code) { if constexpr (metrics::ENABLED) ++invalid[static_cast<size_t>(code)]; }
+        };
+        Metrics metrics_;
+        Tally tally_;
+
+        // Frame parsing state. A candidate at the buffer head that needed more
+        // bytes is remembered, so extract calls skip it until they have arrived:
+        // scanning (pending_length_ 0), have START (2: waiting for LEN), have LEN.
+        size_t pending_length_ = 0;     // bytes the head candidate needs
+        bool frame_started_ = false;    // the pending candidate has a start time
         std::chrono::steady_clock::time_point last_frame_start_;
         
-        // Process a received frame and match it with pending requests
-        void processReceivedFrame(const VdpFrame& frame);
-        
-        // Handle ACK/NAK frames
-        void handleAckNak(const VdpFrame& frame, bool is_ack);
-        
-        // Generate a new sequence number
-        uint8_t getNextSequence();
-        
-        // Find a pending request that matches the response frame
-        std::map<uint8_t, PendingRequest>::iterator findMatchingRequest(const VdpFrame& response_frame);
-
         // Frame format constants
         static constexpr uint8_t START_BYTE = 0x7E;
         static constexpr uint8_t END_BYTE   = 0x7F;
@@ -256,9 +609,66 @@ namespace vdp {
         
         // Verify checksum for a complete frame
         // @param frame The frame to verify
-        // @param debugOutput Output parameter for debug information
+        // @param detail Receives the failure reason and checksums
         // @return true if checksum is valid, false otherwise
-        bool verifyChecksum(const std::vector<uint8_t>& frame, std::string& debugOutput) const;
+        static bool verifyChecksum(ByteSpan frame, ParseErrorDetail& detail);
+
+        // Parse the next reported result out of the buffer and consume its bytes
+        // @param out View of the result, borrowing from buffer_
+        // @return false once no further result can be produced without more data
+        bool nextResultNoLock(ParseResultView& out);
+
+        // As nextResultNoLock(), regardless of the Invalid result limit
+        bool parseNextNoLock(ParseResultView& out);
+
+        // Consume the rejected candidates and garbage after a rejection
+        // @return Number of bytes consumed
+        size_t absorbInvalidRunNoLock(uint16_t& coalesced);
+
+        // Finish an Invalid result for the candidate at the buffer head and skip its START byte
+        void rejectCandidateNoLock(ParseResultView& out);
+
+        // Remember the incomplete candidate at the head of window
+        void holdCandidateNoLock(ByteSpan window);
+
+        // Reject the pending candidate if it has gone stale
+        // @return true if out now holds the Stale result
+        bool rejectStaleNoLock(ParseResultView& out);
+
+        // Producer side of feed(): record the stamp of a feed
+        void stampFeed(RxTimestamp received);
+
+        // Spsc mode: publish bytes into the feed ring, waiting while it is full
+        void writeFeedRing(const uint8_t* data, size_t len);
+
+        // Lock held by consumer-side calls; a no-op lock in Spsc mode
+        std::unique_lock<std::mutex> consumerLock() {
+            return feed_ring_ ? std::unique_lock<std::mutex>(mutex_, std::defer_lock)
+                              : std::unique_lock<std::mutex>(mutex_);
+        }
+
+        // Spsc mode: move everything the producer published into buffer_.
+        // Every extract call starts here, it also latches batch_timestamp_ and
+        // restarts the Invalid result count.
+        void drainFeedRingNoLock();
+
+        // Every extract call ends here: publish tally_ into metrics_
+        void publishMetricsNoLock();
     };
+
+    template <typename Callback>
+    size_t VdpParser::extractFrameViews(Callback&& callback) {
+        auto lock = consumerLock();
+        drainFeedRingNoLock();
+        size_t count = 0;
+        ParseResultView view;
+        while (nextResultNoLock(view)) {
+            callback(static_cast<const ParseResultView&>(view));
+            ++count;
+        }
+        publishMetricsNoLock();
+
+        return count;
+    }
 } // namespace vdp
 #endif //VDP_PARSER_H
@@ -0,0 +1,255 @@
+#include "byte_kernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VDP_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define VDP_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define VDP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define VDP_TARGET(isa)
+#endif
+
+namespace vdp {
+namespace kernels {
+
+static size_t findByteScalar(const uint8_t* data, size_t len, uint8_t value) {
+    for (size_t i = 0; i < len; ++i) {
+        if (data[i] == value) {
+            return i;
+        }
+    }
+    return len;
+}
+
+static uint8_t xorReduceScalar(const uint8_t* data, size_t len) {
+    uint8_t acc = 0;
+    for (size_t i = 0; i < len; ++i) {
+        acc ^= data[i];
+    }
+    return acc;
+}
+
+static uint8_t copyXorScalar(uint8_t* dst, const uint8_t* src, size_t len) {
+    uint8_t acc = 0;
+    for (size_t i = 0; i < len; ++i) {
+        dst[i] = src[i];
+        acc ^= src[i];
+    }
+    return acc;
+}
+
+// Index of the lowest set bit, mask must be non-zero
+static inline unsigned lowestBit(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+#if defined(VDP_KERNELS_X86)
+
+VDP_TARGET("sse2")
+static size_t findByteSse2(const uint8_t* data, size_t len, uint8_t value) {
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if (mask != 0) {
+            return i + lowestBit(mask);
+        }
+    }
+    return i + findByteScalar(data + i, len - i, value);
+}
+
+VDP_TARGET("sse2")
+static uint8_t xorReduceSse2(const uint8_t* data, size_t len) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        acc = _mm_xor_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    }
+    // Fold 16 lanes down to one
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 4));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 2));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 1));
+    uint8_t folded = static_cast<uint8_t>(_mm_cvtsi128_si32(acc));
+    return folded ^ xorReduceScalar(data + i, len - i);
+}
+
+VDP_TARGET("sse2")
+static uint8_t foldSse2(__m128i acc) {
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 4));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 2));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 1));
+    return static_cast<uint8_t>(_mm_cvtsi128_si32(acc));
+}
+
+VDP_TARGET("sse2")
+static uint8_t copyXorSse2(uint8_t* dst, const uint8_t* src, size_t len) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), chunk);
+        acc = _mm_xor_si128(acc, chunk);
+    }
+    return foldSse2(acc) ^ copyXorScalar(dst + i, src + i, len - i);
+}
+
+VDP_TARGET("avx2")
+static size_t findByteAvx2(const uint8_t* data, size_t len, uint8_t value) {
+    const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        if (mask != 0) {
+            return i + lowestBit(mask);
+        }
+    }
+    return i + findByteSse2(data + i, len - i, value);
+}
+
+VDP_TARGET("avx2")
+static uint8_t xorReduceAvx2(const uint8_t* data, size_t len) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        acc = _mm256_xor_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+    }
+    __m128i half = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    half = _mm_xor_si128(half, _mm_srli_si128(half, 8));
+    half = _mm_xor_si128(half, _mm_srli_si128(half, 4));
+    half = _mm_xor_si128(half, _mm_srli_si128(half, 2));
+    half = _mm_xor_si128(half, _mm_srli_si128(half, 1));
+    uint8_t folded = static_cast<uint8_t>(_mm_cvtsi128_si32(half));
+    return folded ^ xorReduceSse2(data + i, len - i);
+}
+
+VDP_TARGET("avx2")
+static uint8_t copyXorAvx2(uint8_t* dst, const uint8_t* src, size_t len) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), chunk);
+        acc = _mm256_xor_si256(acc, chunk);
+    }
+    __m128i half = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    return foldSse2(half) ^ copyXorSse2(dst + i, src + i, len - i);
+}
+
+static bool cpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) {
+        return false;
+    }
+    __cpuid(regs, 1);
+    const bool os_saves_ymm = (regs[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(regs, 7, 0);
+    return os_saves_ymm && (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif defined(VDP_KERNELS_NEON)
+
+static size_t findByteNeon(const uint8_t* data, size_t len, uint8_t value) {
+    const uint8x16_t needle = vdupq_n_u8(value);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(data + i), needle);
+        if (vmaxvq_u8(eq) != 0) {
+            // Narrow each lane to a nibble so the match position fits in 64 bits
+            uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+            return i + (static_cast<unsigned>(__builtin_ctzll(nibbles)) >> 2);
+        }
+    }
+    return i + findByteScalar(data + i, len - i, value);
+}
+
+static uint8_t xorReduceNeon(const uint8_t* data, size_t len) {
+    uint8x16_t acc = vdupq_n_u8(0);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        acc = veorq_u8(acc, vld1q_u8(data + i));
+    }
+    uint8x8_t half = veor_u8(vget_low_u8(acc), vget_high_u8(acc));
+    uint64_t lanes = vget_lane_u64(vreinterpret_u64_u8(half), 0);
+    lanes ^= lanes >> 32;
+    lanes ^= lanes >> 16;
+    lanes ^= lanes >> 8;
+    return static_cast<uint8_t>(lanes) ^ xorReduceScalar(data + i, len - i);
+}
+
+static uint8_t copyXorNeon(uint8_t* dst, const uint8_t* src, size_t len) {
+    uint8x16_t acc = vdupq_n_u8(0);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t chunk = vld1q_u8(src + i);
+        vst1q_u8(dst + i, chunk);
+        acc = veorq_u8(acc, chunk);
+    }
+    uint8x8_t half = veor_u8(vget_low_u8(acc), vget_high_u8(acc));
+    uint64_t lanes = vget_lane_u64(vreinterpret_u64_u8(half), 0);
+    lanes ^= lanes >> 32;
+    lanes ^= lanes >> 16;
+    lanes ^= lanes >> 8;
+    return static_cast<uint8_t>(lanes) ^ copyXorScalar(dst + i, src + i, len - i);
+}
+
+#endif
+
+static const KernelSet kScalar{"scalar", findByteScalar, xorReduceScalar, copyXorScalar};
+#if defined(VDP_KERNELS_X86)
+static const KernelSet kSse2{"sse2", findByteSse2, xorReduceSse2, copyXorSse2};
+static const KernelSet kAvx2{"avx2", findByteAvx2, xorReduceAvx2, copyXorAvx2};
+#elif defined(VDP_KERNELS_NEON)
+static const KernelSet kNeon{"neon", findByteNeon, xorReduceNeon, copyXorNeon};
+#endif
+
+std::vector<KernelSet> availableKernels() {
+    std::vector<KernelSet> sets{kScalar};
+#if defined(VDP_KERNELS_X86)
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+    // SSE2 is part of the x86-64 baseline
+    sets.push_back(kSse2);
+#endif
+    if (cpuHasAvx2()) {
+        sets.push_back(kAvx2);
+    }
+#elif defined(VDP_KERNELS_NEON)
+    sets.push_back(kNeon);
+#endif
+    return sets;
+}
+
+static KernelSet selectKernels() {
+    // availableKernels() lists sets from slowest to fastest
+    return availableKernels().back();
+}
+
+const KernelSet& activeKernels() {
+    static const KernelSet selected = selectKernels();
+    return selected;
+}
+
+} // namespace kernels
+} // namespace vdp
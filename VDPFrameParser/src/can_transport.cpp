@@ -0,0 +1,204 @@
+#include "can_transport.h"
+
+#include <cerrno>
+
+#if defined(__linux__)
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace vdp::transport;
+
+#if defined(__linux__)
+
+struct CanTransport::RxBatch {
+    canfd_frame frames[RX_BATCH];
+    iovec io[RX_BATCH];
+    mmsghdr messages[RX_BATCH];
+};
+
+CanTransport::CanTransport(CanConfig config, EventLoop& loop)
+    : FdTransport(loop), config_(std::move(config)),
+      reassembler_(std::make_unique<CanReassembler>()), rx_(std::make_unique<RxBatch>()) {
+    for (size_t i = 0; i < RX_BATCH; ++i) {
+        rx_->io[i] = {&rx_->frames[i], sizeof(canfd_frame)};
+        rx_->messages[i] = {};
+        rx_->messages[i].msg_hdr.msg_iov = &rx_->io[i];
+        rx_->messages[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+CanTransport::~CanTransport() {
+    // Stop the loop from calling receive() before the batch buffers go away
+    disconnect();
+}
+
+// CAN ID of the given ECU_ID byte, with the extended flag when the base needs it
+static canid_t canIdOf(uint32_t base_id, uint8_t ecu_byte) {
+    const canid_t id = base_id | ecu_byte;
+    return id > CAN_SFF_MASK ? (id & CAN_EFF_MASK) | CAN_EFF_FLAG : id;
+}
+
+int CanTransport::openDescriptor(const std::string& connection_string) {
+    const int fd = ::socket(PF_CAN, SOCK_RAW | SOCK_CLOEXEC, CAN_RAW);
+    if (fd < 0) {
+        setLastError(systemError("socket"));
+        return -1;
+    }
+
+    ifreq request{};
+    std::strncpy(request.ifr_name, connection_string.c_str(), IFNAMSIZ - 1);
+    if (::ioctl(fd, SIOCGIFINDEX, &request) != 0) {
+        setLastError(systemError("Unknown CAN interface " + connection_string));
+        ::close(fd);
+        return -1;
+    }
+    const int ifindex = request.ifr_ifindex;
+
+    if (config_.fd) {
+        if (::ioctl(fd, SIOCGIFMTU, &request) != 0 || request.ifr_mtu != CANFD_MTU) {
+            setLastError("Interface does not support CAN-FD: " + connection_string);
+            ::close(fd);
+            return -1;
+        }
+        const int enable = 1;
+        setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable));
+    }
+
+    // Only responses reach the socket, filtered by the kernel
+    const bool extended = (config_.base_id | 0xFF) > CAN_SFF_MASK;
+    const canid_t id_mask = extended ? (CAN_EFF_MASK | CAN_EFF_FLAG) : (CAN_SFF_MASK | CAN_EFF_FLAG);
+    std::vector<can_filter> filters;
+    if (config_.ecu_filter.empty()) {
+        filters.push_back({canIdOf(config_.base_id, 0x80), id_mask & ~canid_t{0x7F}});
+    } else {
+        for (uint8_t ecu : config_.ecu_filter) {
+            filters.push_back({canIdOf(config_.base_id, static_cast<uint8_t>(0x80 | ecu)), id_mask});
+        }
+    }
+    if (setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(),
+                   static_cast<socklen_t>(filters.size() * sizeof(can_filter))) != 0) {
+        setLastError(systemError("CAN_RAW_FILTER"));
+        ::close(fd);
+        return -1;
+    }
+
+    sockaddr_can address{};
+    address.can_family = AF_CAN;
+    address.can_ifindex = ifindex;
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        setLastError(systemError("bind " + connection_string));
+        ::close(fd);
+        return -1;
+    }
+
+    reassembler_->reset();
+    return fd;
+}
+
+bool CanTransport::receive(int fd, std::string& error) {
+    // One batch per wakeup, see FdTransport::receive()
+    const int count = ::recvmmsg(fd, rx_->messages, RX_BATCH, MSG_DONTWAIT, nullptr);
+    if (count < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return true;
+        }
+        error = systemError("recvmmsg");
+        return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const canfd_frame& frame = rx_->frames[i];
+        if (frame.can_id & (CAN_RTR_FLAG | CAN_ERR_FLAG)) {
+            continue;
+        }
+        const uint32_t id = frame.can_id & ((frame.can_id & CAN_EFF_FLAG) ? CAN_EFF_MASK : CAN_SFF_MASK);
+        if ((id & ~uint32_t{0xFF}) != config_.base_id) {
+            continue;
+        }
+        // Classic frames arrive as CAN_MTU bytes, their len is at most 8
+        const size_t length = std::min<size_t>(frame.len, rx_->messages[i].msg_len == CAN_MTU ? CAN_MAX_DLEN
+                                                                                                : CANFD_MAX_DLEN);
+        reassembler_->push(static_cast<uint8_t>(id & 0xFF), frame.data, length,
+                           [this](const uint8_t* data, size_t size) { deliver(data, size); });
+    }
+    return true;
+}
+
+bool CanTransport::sendv(const IoSlice* slices, size_t count) {
+    // The ECU_ID byte of the frame selects the CAN ID
+    const IoSlice* header = count > 0 && slices[0].length >= 3 ? &slices[0] : nullptr;
+    if (header == nullptr) {
+        setLastError("Frame header missing");
+        return false;
+    }
+    const canid_t can_id = canIdOf(config_.base_id, header->data[2]);
+    const size_t max_payload = config_.fd ? FD_PAYLOAD : CLASSIC_PAYLOAD;
+    const size_t mtu = config_.fd ? CANFD_MTU : CAN_MTU;
+
+    // A 253-byte frame takes 32 classic frames, all of them go out in one call
+    canfd_frame frames[32];
+    iovec io[32];
+    mmsghdr messages[32];
+    unsigned segments = 0;
+    segmentForCan(slices, count, max_payload, [&](const uint8_t* data, size_t length) {
+        canfd_frame& frame = frames[segments];
+        frame = {};
+        frame.can_id = can_id;
+        frame.len = static_cast<uint8_t>(length);
+        std::memcpy(frame.data, data, length);
+        io[segments] = {&frame, mtu};
+        messages[segments] = {};
+        messages[segments].msg_hdr.msg_iov = &io[segments];
+        messages[segments].msg_hdr.msg_iovlen = 1;
+        ++segments;
+    });
+
+    std::lock_guard<std::mutex> lock(sendMutex());
+    const int fd = descriptor();
+    if (fd < 0) {
+        setLastError("Not connected");
+        return false;
+    }
+
+    unsigned sent = 0;
+    while (sent < segments) {
+        const int result = ::sendmmsg(fd, messages + sent, segments - sent, 0);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+                setLastError(systemError("sendmmsg"));
+                return false;
+            }
+            // TX queue full, wait for the controller to drain it
+            pollfd pfd{fd, POLLOUT, 0};
+            if (::poll(&pfd, 1, SEND_TIMEOUT_MS) <= 0) {
+                setLastError("Send timed out");
+                return false;
+            }
+            continue;
+        }
+        sent += static_cast<unsigned>(result);
+    }
+    return true;
+}
+
+#else
+
+struct CanTransport::RxBatch {};
+
+CanTransport::CanTransport(CanConfig config, EventLoop& loop)
+    : FdTransport(loop), config_(std::move(config)) {}
+CanTransport::~CanTransport() = default;
+int CanTransport::openDescriptor(const std::string&) { return -1; }
+bool CanTransport::receive(int, std::string&) { return false; }
+bool CanTransport::sendv(const IoSlice*, size_t) { return false; }
+
+#endif
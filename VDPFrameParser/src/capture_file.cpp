@@ -0,0 +1,159 @@
+#include "capture_file.h"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VDP_HAS_MMAP 1
+#endif
+
+using namespace vdp;
+
+bool vdp::parseCaptureHeader(ByteSpan file, ByteSpan& payload, uint16_t* flags) {
+    if (file.size < CaptureHeader::SIZE || std::memcmp(file.data, CaptureHeader::MAGIC, sizeof(CaptureHeader::MAGIC)) != 0) {
+        return false;
+    }
+    const uint16_t version = static_cast<uint16_t>(file[8] | (file[9] << 8));
+    if (version != CaptureHeader::VERSION) {
+        return false;
+    }
+    const uint16_t header_flags = static_cast<uint16_t>(file[10] | (file[11] << 8));
+    if ((header_flags & ~CaptureHeader::KNOWN_FLAGS) != 0 || (flags == nullptr && header_flags != 0)) {
+        return false;
+    }
+    if (flags != nullptr) {
+        *flags = header_flags;
+    }
+    payload = file.subspan(CaptureHeader::SIZE);
+    return true;
+}
+
+std::vector<uint8_t> vdp::makeCaptureHeader(uint16_t flags) {
+    std::vector<uint8_t> header(CaptureHeader::SIZE, 0);
+    std::memcpy(header.data(), CaptureHeader::MAGIC, sizeof(CaptureHeader::MAGIC));
+    header[8] = static_cast<uint8_t>(CaptureHeader::VERSION & 0xFF);
+    header[9] = static_cast<uint8_t>(CaptureHeader::VERSION >> 8);
+    header[10] = static_cast<uint8_t>(flags & 0xFF);
+    header[11] = static_cast<uint8_t>(flags >> 8);
+    return header;
+}
+
+namespace {
+
+// Character classes for decodeHex(): nibble value, or one of the markers
+constexpr uint8_t SKIP = 0x10;
+constexpr uint8_t COMMENT = 0x11;
+constexpr uint8_t NEWLINE = 0x12;
+
+constexpr std::array<uint8_t, 256> makeHexTable() {
+    std::array<uint8_t, 256> table{};
+    for (auto& entry : table) {
+        entry = SKIP;
+    }
+    for (int c = '0'; c <= '9'; ++c) {
+        table[c] = static_cast<uint8_t>(c - '0');
+    }
+    for (int c = 'a'; c <= 'f'; ++c) {
+        table[c] = static_cast<uint8_t>(c - 'a' + 10);
+        table[c - 'a' + 'A'] = static_cast<uint8_t>(c - 'a' + 10);
+    }
+    table['#'] = COMMENT;
+    table['\n'] = NEWLINE;
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> HEX_TABLE = makeHexTable();
+
+} // namespace
+
+size_t vdp::decodeHex(ByteSpan text, std::vector<uint8_t>& out) {
+    const size_t start = out.size();
+    out.reserve(start + text.size / 2);
+
+    const uint8_t* p = text.data;
+    const uint8_t* const end = p + text.size;
+    int high = -1;   // pending first nibble of a byte
+    while (p < end) {
+        const uint8_t value = HEX_TABLE[*p++];
+        if (value < 16) {
+            if (high < 0) {
+                high = value;
+            } else {
+                out.push_back(static_cast<uint8_t>((high << 4) | value));
+                high = -1;
+            }
+        } else if (value == NEWLINE) {
+            high = -1;   // stray nibble of the line
+        } else if (value == COMMENT) {
+            const void* newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+            p = newline ? static_cast<const uint8_t*>(newline) : end;
+        }
+    }
+    return out.size() - start;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+#if defined(VDP_HAS_MMAP)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        error = "Cannot stat " + path + ": " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ != 0) {
+        void* address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            error = "Cannot map " + path + ": " + std::strerror(errno);
+            size_ = 0;
+            ::close(fd);
+            return false;
+        }
+        // Read front to back once
+        ::madvise(address, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const uint8_t*>(address);
+        mapped_ = true;
+    }
+    ::close(fd);
+    return true;
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    fallback_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#if defined(VDP_HAS_MMAP)
+    if (mapped_) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+    fallback_.clear();
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+}
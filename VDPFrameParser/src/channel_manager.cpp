@@ -0,0 +1,319 @@
+#include "channel_manager.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace vdp;
+
+namespace {
+
+void pinToCpu(std::thread& thread, size_t cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % CPU_SETSIZE, &set);
+    // Best effort, e.g. a restricted cpuset leaves the thread unpinned
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+    (void)thread;
+    (void)cpu;
+#endif
+}
+
+bool tryClaim(std::atomic<bool>& busy) {
+    return !busy.load(std::memory_order_relaxed) && !busy.exchange(true, std::memory_order_acquire);
+}
+
+} // namespace
+
+ChannelManager::ChannelManager(size_t channel_count, ChannelManagerConfig config) : config_(config) {
+    size_t shard_count = config_.shards;
+    if (shard_count == 0) {
+        shard_count = std::thread::hardware_concurrency();
+    }
+    shard_count = std::max<size_t>(1, std::min(shard_count, std::max<size_t>(1, channel_count)));
+
+    channels_.reserve(channel_count);
+    for (size_t i = 0; i < channel_count; ++i) {
+        channels_.push_back(std::make_unique<Channel>(config_, static_cast<uint32_t>(i % shard_count)));
+    }
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>(config_.result_capacity));
+        shards_.back()->owned.reserve(channel_count);
+    }
+
+    const size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_[i]->thread = std::thread(&ChannelManager::run, this, static_cast<uint32_t>(i));
+        if (config_.pin_threads) {
+            pinToCpu(shards_[i]->thread, i % cpus);
+        }
+    }
+}
+
+ChannelManager::~ChannelManager() {
+    stop_.store(true, std::memory_order_release);
+    for (auto& shard : shards_) {
+        {
+            std::lock_guard<std::mutex> lock(shard->sleep_mutex);
+            shard->signaled = true;
+        }
+        shard->wakeup.notify_one();
+    }
+    for (auto& shard : shards_) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+}
+
+size_t ChannelManager::feed(ChannelId channel, const uint8_t* data, size_t len) {
+    Channel& c = *channels_[channel];
+    const size_t accepted = c.input.write(data, len);
+    if (accepted != 0) {
+        notifyOwner(c);
+    }
+    return accepted;
+}
+
+bool ChannelManager::expect(ChannelId channel, uint8_t ecu_id, uint8_t command, uint64_t tag) {
+    Channel& c = *channels_[channel];
+    if (!c.expectations.push({ecu_id, command, tag, Clock::now() + config_.expectation_timeout})) {
+        return false;
+    }
+    notifyOwner(c);
+    return true;
+}
+
+void ChannelManager::notifyOwner(Channel& channel) {
+    // Pairs with the fence in run(): either the worker re-scans after the
+    // work was queued, or this sees it sleeping. The owner is read after the
+    // fence, so a thief that went to sleep right after a steal is the one woken.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wake(*shards_[channel.shard.load(std::memory_order_relaxed)]);
+}
+
+void ChannelManager::wake(Shard& shard) {
+    if (shard.sleeping.load(std::memory_order_relaxed)) {
+        {
+            std::lock_guard<std::mutex> lock(shard.sleep_mutex);
+            shard.signaled = true;
+        }
+        shard.wakeup.notify_one();
+    }
+}
+
+bool ChannelManager::hasQueuedWork(const Shard& shard) const {
+    // A channel stolen since then was taken by a shard that is awake
+    for (ChannelId id : shard.owned) {
+        const Channel& channel = *channels_[id];
+        if (!channel.input.empty() || !channel.expectations.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ChannelManager::run(uint32_t index) {
+    Shard& shard = *shards_[index];
+    int idle_passes = 0;
+
+    while (!stop_.load(std::memory_order_acquire)) {
+        bool worked = false;
+        uint32_t backlogged = 0;
+        shard.owned.clear();
+        for (ChannelId id = 0; id < channels_.size(); ++id) {
+            Channel& channel = *channels_[id];
+            if (channel.shard.load(std::memory_order_relaxed) != index) {
+                continue;
+            }
+            shard.owned.push_back(id);
+            if (!tryClaim(channel.busy)) {
+                continue;
+            }
+            // Ownership may have moved between the check and the claim
+            if (channel.shard.load(std::memory_order_relaxed) == index) {
+                worked |= service(channel, id, index);
+                backlogged += channel.backlog ? 1 : 0;
+            }
+            channel.busy.store(false, std::memory_order_release);
+        }
+        shard.backlogged.store(backlogged, std::memory_order_relaxed);
+
+        if (backlogged > 1) {
+            // Let an idle shard take one of them over
+            for (auto& other : shards_) {
+                if (other.get() != &shard && other->sleeping.load(std::memory_order_relaxed)) {
+                    wake(*other);
+                    break;
+                }
+            }
+        } else if (!worked) {
+            worked = steal(index);
+        }
+
+        if (worked) {
+            idle_passes = 0;
+            continue;
+        }
+        if (++idle_passes < SPIN_PASSES) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(shard.sleep_mutex);
+        shard.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto woken = [&] { return shard.signaled || stop_.load(std::memory_order_acquire); };
+        if (backlogged != 0) {
+            // Waiting for poll() to make room, which sends no wakeup
+            shard.wakeup.wait_for(lock, std::chrono::milliseconds(1), woken);
+        } else if (!hasQueuedWork(shard)) {
+            // Work queued before the fence was not signaled, hence the check
+            shard.wakeup.wait(lock, woken);
+        }
+        shard.signaled = false;
+        shard.sleeping.store(false, std::memory_order_relaxed);
+        idle_passes = 0;
+    }
+}
+
+bool ChannelManager::service(Channel& channel, ChannelId id, uint32_t shard_index) {
+    if (channel.results_shard != shard_index) {
+        // Just stolen: new results must not overtake those in the previous owner's queue
+        if (channel.undelivered.load(std::memory_order_acquire) != 0) {
+            channel.backlog = true;
+            return false;
+        }
+        channel.results_shard = shard_index;
+    }
+
+    Shard& shard = *shards_[shard_index];
+    bool worked = false;
+    channel.expectations.consume([&](const Expectation& expectation) {
+        const auto handle = channel.pending.insert(expectation.ecu_id, expectation.command, expectation.tag);
+        if (handle == PendingRequestTable<uint64_t>::INVALID_HANDLE) {
+            dropped_expectations_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            channel.deadlines.push_back({handle, expectation.deadline});
+        }
+        worked = true;
+    });
+    // Before any frame is matched, so a late response is not taken for a newer request
+    expireExpectations(channel);
+
+    // Results left over from the previous pass go out before more bytes are parsed
+    static constexpr size_t BATCH = 32;
+    InlineParseResult batch[BATCH];
+    bool results_full = false;
+    auto extract = [&] {
+        for (;;) {
+            const size_t room = std::min(shard.results.freeSlots(), BATCH);
+            if (room == 0) {
+                results_full = true;
+                return;
+            }
+            const size_t count = channel.parser.extractFrames(batch, room);
+            if (count == 0) {
+                return;
+            }
+            channel.undelivered.fetch_add(static_cast<uint32_t>(count), std::memory_order_relaxed);
+            for (size_t i = 0; i < count; ++i) {
+                ChannelResult result;
+                result.channel = id;
+                result.result = batch[i];
+                const InlineFrame& frame = batch[i].frame;
+                if (batch[i].status == ParseStatus::Success) {
+                    // ACK/NAK answer the command carried in DATA[0]
+                    const bool ack_nak = frame.command == static_cast<uint8_t>(CommandType::Acknowledge) ||
+                                         frame.command == static_cast<uint8_t>(CommandType::NegativeAck);
+                    uint64_t tag;
+                    if (ack_nak ? frame.length != 0 && channel.pending.takeOldest(frame.ecu_id, frame.payload[0], tag)
+                                : channel.pending.takeOldest(frame.ecu_id, frame.command, tag)) {
+                        result.tag = tag;
+                    }
+                }
+                shard.results.push(result);
+            }
+            worked = true;
+        }
+    };
+
+    extract();
+    bool input_left = false;
+    if (!results_full) {
+        ByteSpan first, second;
+        const size_t available = channel.input.readable(first, second);
+        const size_t take = std::min(available, QUANTUM);
+        if (take != 0) {
+            const size_t from_first = std::min(take, first.size);
+            channel.parser.feed(first.data, from_first);
+            if (take > from_first) {
+                channel.parser.feed(second.data, take - from_first);
+            }
+            channel.input.release(take);
+            worked = true;
+            extract();
+        }
+        input_left = available > take;
+    }
+    channel.backlog = input_left || results_full;
+    return worked;
+}
+
+void ChannelManager::expireExpectations(Channel& channel) {
+    if (channel.deadlines.empty()) {
+        return;
+    }
+    const Clock::time_point now = Clock::now();
+    uint64_t expired = 0;
+    while (!channel.deadlines.empty()) {
+        const PendingDeadline& oldest = channel.deadlines.front();
+        // Answered entries are gone from the table and only leave the queue here
+        if (channel.pending.find(oldest.handle) != nullptr) {
+            if (oldest.deadline > now) {
+                break;
+            }
+            uint64_t tag;
+            channel.pending.take(oldest.handle, tag);
+            ++expired;
+        }
+        channel.deadlines.pop_front();
+    }
+    if (expired != 0) {
+        dropped_expectations_.fetch_add(expired, std::memory_order_relaxed);
+    }
+}
+
+bool ChannelManager::steal(uint32_t thief) {
+    if (shards_.size() < 2) {
+        return false;
+    }
+    for (ChannelId id = 0; id < channels_.size(); ++id) {
+        Channel& channel = *channels_[id];
+        const uint32_t owner = channel.shard.load(std::memory_order_relaxed);
+        // Moving a shard's only busy channel would just move the hot spot
+        if (owner == thief || shards_[owner]->backlogged.load(std::memory_order_relaxed) < 2 ||
+            !tryClaim(channel.busy)) {
+            continue;
+        }
+        const bool movable = channel.shard.load(std::memory_order_relaxed) == owner && channel.backlog;
+        if (movable) {
+            channel.shard.store(thief, std::memory_order_release);
+            // Until its next pass, the owner has one backlogged channel less to be stolen
+            shards_[owner]->backlogged.fetch_sub(1, std::memory_order_relaxed);
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            service(channel, id, thief);
+        }
+        channel.busy.store(false, std::memory_order_release);
+        if (movable) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,183 @@
+#include "event_loop.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+using namespace vdp::transport;
+
+#if defined(__linux__)
+
+static uint32_t toEpollEvents(uint32_t events) {
+    uint32_t epoll_events = 0;
+    if (events & EventLoop::READABLE) {
+        epoll_events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (events & EventLoop::WRITABLE) {
+        epoll_events |= EPOLLOUT;
+    }
+    return epoll_events;
+}
+
+static uint32_t fromEpollEvents(uint32_t epoll_events) {
+    uint32_t events = 0;
+    if (epoll_events & EPOLLIN) {
+        events |= EventLoop::READABLE;
+    }
+    if (epoll_events & EPOLLOUT) {
+        events |= EventLoop::WRITABLE;
+    }
+    if (epoll_events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
+        events |= EventLoop::HANGUP;
+    }
+    return events;
+}
+
+EventLoop::EventLoop() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ >= 0 && wake_fd_ >= 0) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = wake_fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+    }
+    thread_ = std::thread(&EventLoop::run, this);
+    thread_id_ = thread_.get_id();
+}
+
+EventLoop::~EventLoop() {
+    stop_ = true;
+    wake();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+bool EventLoop::add(int fd, uint32_t events, Handler handler) {
+    if (epoll_fd_ < 0 || fd < 0) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!registrations_.emplace(fd, std::make_shared<Registration>(Registration{fd, std::move(handler)})).second) {
+            return false;
+        }
+    }
+
+    epoll_event ev{};
+    ev.events = toEpollEvents(events);
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        registrations_.erase(fd);
+        return false;
+    }
+    return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events) {
+    epoll_event ev{};
+    ev.events = toEpollEvents(events);
+    ev.data.fd = fd;
+    return epoll_fd_ >= 0 && epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::remove(int fd) {
+    // Off the loop thread, wait for the handlers being run to return. On the
+    // loop thread the running handler holds its own reference to the registration.
+    std::unique_lock<std::mutex> dispatch_lock(dispatch_mutex_, std::defer_lock);
+    if (!inLoopThread()) {
+        dispatch_lock.lock();
+    }
+
+    bool found;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        found = registrations_.erase(fd) != 0;
+    }
+    if (found && epoll_fd_ >= 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+size_t EventLoop::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return registrations_.size();
+}
+
+void EventLoop::wake() {
+    if (wake_fd_ >= 0) {
+        const uint64_t one = 1;
+        ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void EventLoop::run() {
+    if (epoll_fd_ < 0) {
+        return;
+    }
+
+    epoll_event events[64];
+    while (!stop_) {
+        const int count = epoll_wait(epoll_fd_, events, 64, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex_);
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                uint64_t value;
+                ssize_t ignored = read(wake_fd_, &value, sizeof(value));
+                (void)ignored;
+                continue;
+            }
+
+            // Events for descriptors removed earlier in this batch are dropped
+            std::shared_ptr<Registration> registration;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = registrations_.find(fd);
+                if (it == registrations_.end()) {
+                    continue;
+                }
+                registration = it->second;
+            }
+            registration->handler(fromEpollEvents(events[i].events));
+        }
+    }
+}
+
+#else
+
+EventLoop::EventLoop() : thread_id_() {}
+EventLoop::~EventLoop() = default;
+bool EventLoop::add(int, uint32_t, Handler) { return false; }
+bool EventLoop::modify(int, uint32_t) { return false; }
+void EventLoop::remove(int) {}
+size_t EventLoop::size() const { return 0; }
+void EventLoop::wake() {}
+void EventLoop::run() {}
+
+#endif
+
+EventLoop& EventLoop::shared() {
+    static EventLoop loop;
+    return loop;
+}
@@ -0,0 +1,372 @@
+#include "fd_transport.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+using namespace vdp::transport;
+
+FdTransport::FdTransport(EventLoop& loop) : loop_(loop) {
+}
+
+FdTransport::~FdTransport() {
+    closeDescriptor();
+}
+
+void FdTransport::setDataCallback(DataCallback callback) {
+    data_callback_ = std::move(callback);
+}
+
+bool FdTransport::setReceiveBuffer(ReceiveBuffer buffer) {
+    receive_buffer_ = std::move(buffer);
+    return true;
+}
+
+void FdTransport::setErrorCallback(ErrorCallback callback) {
+    error_callback_ = std::move(callback);
+}
+
+bool FdTransport::isConnected() const {
+    return connected_;
+}
+
+void FdTransport::disconnect() {
+    closeDescriptor();
+}
+
+std::string FdTransport::getLastError() const {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    return last_error_;
+}
+
+void FdTransport::setLastError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    last_error_ = error;
+}
+
+std::string FdTransport::systemError(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+void FdTransport::deliver(const uint8_t* data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    if (receive_buffer_.prepare) {
+        VdpParser::WriteLease lease = receive_buffer_.prepare(length);
+        std::memcpy(lease.data(), data, length);
+        receive_buffer_.commit(std::move(lease), length);
+    } else if (data_callback_) {
+        data_callback_(data, length);
+    }
+}
+
+void FdTransport::fail(const std::string& error) {
+    if (!closeDescriptor()) {
+        return;
+    }
+    setLastError(error);
+    if (error_callback_) {
+        error_callback_(error);
+    }
+}
+
+#if defined(__linux__)
+
+bool FdTransport::initialize(const std::string& connection_string) {
+    closeDescriptor();
+
+    const int fd = openDescriptor(connection_string);
+    if (fd < 0) {
+        return false;
+    }
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+        setLastError(systemError("fcntl"));
+        ::close(fd);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        fd_ = fd;
+    }
+    connected_ = true;
+    if (!loop_.add(fd, EventLoop::READABLE, [this, fd](uint32_t events) { onEvents(fd, events); })) {
+        setLastError("Failed to register with the event loop");
+        closeDescriptor();
+        return false;
+    }
+    return true;
+}
+
+bool FdTransport::closeDescriptor() {
+    int fd;
+    {
+        // Waits for a send in progress, later sends see the closed descriptor
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        fd = fd_;
+        fd_ = -1;
+    }
+    connected_ = false;
+    if (fd < 0) {
+        return false;
+    }
+    // After remove() the handler is not running, nothing reads from fd any more
+    loop_.remove(fd);
+    ::close(fd);
+    return true;
+}
+
+void FdTransport::onEvents(int fd, uint32_t events) {
+    if (events & EventLoop::READABLE) {
+        std::string error;
+        if (!receive(fd, error)) {
+            fail(error);
+        }
+        return;
+    }
+    if (events & EventLoop::HANGUP) {
+        fail("Connection closed");
+    }
+}
+
+bool FdTransport::receive(int fd, std::string& error) {
+    // Read once per wakeup, the level-triggered loop calls again while data
+    // remains, so one busy adapter cannot starve the others
+    ssize_t received;
+    if (receive_buffer_.prepare) {
+        // Straight into the consumer's memory, given back unused if nothing arrived
+        VdpParser::WriteLease lease = receive_buffer_.prepare(READ_BUFFER_SIZE);
+        received = ::read(fd, lease.data(), READ_BUFFER_SIZE);
+        if (received > 0) {
+            receive_buffer_.commit(std::move(lease), static_cast<size_t>(received));
+            return true;
+        }
+        const int saved_errno = errno;
+        lease.release();
+        errno = saved_errno;
+    } else {
+        received = ::read(fd, read_buffer_.data(), read_buffer_.size());
+        if (received > 0) {
+            deliver(read_buffer_.data(), static_cast<size_t>(received));
+            return true;
+        }
+    }
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return true;
+    }
+    error = received == 0 ? "Connection closed" : systemError("read");
+    return false;
+}
+
+bool FdTransport::send(const uint8_t* data, size_t length) {
+    const IoSlice slice{data, length};
+    return sendv(&slice, 1);
+}
+
+bool FdTransport::sendv(const IoSlice* slices, size_t count) {
+    static constexpr size_t MAX_SLICES = 16;
+    if (count > MAX_SLICES) {
+        return ITransport::sendv(slices, count);
+    }
+
+    iovec io[MAX_SLICES];
+    size_t remaining = 0;
+    for (size_t i = 0; i < count; ++i) {
+        io[i].iov_base = const_cast<uint8_t*>(slices[i].data);
+        io[i].iov_len = slices[i].length;
+        remaining += slices[i].length;
+    }
+
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    if (fd_ < 0) {
+        setLastError("Not connected");
+        return false;
+    }
+
+    iovec* next = io;
+    size_t next_count = count;
+    while (remaining > 0) {
+        const ssize_t written = ::writev(fd_, next, static_cast<int>(next_count));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                setLastError(systemError("write"));
+                return false;
+            }
+            // Output queue full, wait for it to drain
+            pollfd pfd{fd_, POLLOUT, 0};
+            if (::poll(&pfd, 1, SEND_TIMEOUT_MS) <= 0) {
+                setLastError("Send timed out");
+                return false;
+            }
+            continue;
+        }
+
+        // Skip what was written, the last slice may be partially sent
+        remaining -= static_cast<size_t>(written);
+        size_t advance = static_cast<size_t>(written);
+        while (next_count > 0 && advance >= next->iov_len) {
+            advance -= next->iov_len;
+            ++next;
+            --next_count;
+        }
+        if (next_count > 0) {
+            next->iov_base = static_cast<uint8_t*>(next->iov_base) + advance;
+            next->iov_len -= advance;
+        }
+    }
+    return true;
+}
+
+// Split "<name>[:<number>]", number keeps its value when there is no suffix
+static std::string splitNumericSuffix(const std::string& text, unsigned long& number) {
+    const size_t colon = text.rfind(':');
+    if (colon == std::string::npos || colon + 1 == text.size() ||
+        text.find_first_not_of("0123456789", colon + 1) != std::string::npos) {
+        return text;
+    }
+    number = std::stoul(text.substr(colon + 1));
+    return text.substr(0, colon);
+}
+
+static bool toSpeed(unsigned long baud, speed_t& speed) {
+    switch (baud) {
+        case 9600: speed = B9600; return true;
+        case 19200: speed = B19200; return true;
+        case 38400: speed = B38400; return true;
+        case 57600: speed = B57600; return true;
+        case 115200: speed = B115200; return true;
+        case 230400: speed = B230400; return true;
+        case 460800: speed = B460800; return true;
+        case 500000: speed = B500000; return true;
+        case 921600: speed = B921600; return true;
+        case 1000000: speed = B1000000; return true;
+        case 2000000: speed = B2000000; return true;
+        default: return false;
+    }
+}
+
+int SerialTransport::openDescriptor(const std::string& connection_string) {
+    unsigned long baud = DEFAULT_BAUD_RATE;
+    const std::string device = splitNumericSuffix(connection_string, baud);
+    speed_t speed;
+    if (!toSpeed(baud, speed)) {
+        setLastError("Unsupported baud rate: " + std::to_string(baud));
+        return -1;
+    }
+
+    const int fd = ::open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        setLastError(systemError("open " + device));
+        return -1;
+    }
+
+    termios tty{};
+    if (tcgetattr(fd, &tty) != 0) {
+        setLastError(systemError("tcgetattr " + device));
+        ::close(fd);
+        return -1;
+    }
+    cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+        setLastError(systemError("tcsetattr " + device));
+        ::close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+// Non-blocking connect bounded by timeout_ms, fd is left non-blocking
+static bool connectWithTimeout(int fd, const sockaddr* address, socklen_t length, int timeout_ms) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    if (::connect(fd, address, length) == 0) {
+        return true;
+    }
+    if (errno != EINPROGRESS) {
+        return false;
+    }
+    pollfd pfd{fd, POLLOUT, 0};
+    if (::poll(&pfd, 1, timeout_ms) <= 0) {
+        errno = ETIMEDOUT;
+        return false;
+    }
+    int error = 0;
+    socklen_t error_length = sizeof(error);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_length);
+    errno = error;
+    return error == 0;
+}
+
+int TcpTransport::openDescriptor(const std::string& connection_string) {
+    unsigned long port = DEFAULT_PORT;
+    const std::string host = splitNumericSuffix(connection_string, port);
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    const int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+    if (status != 0) {
+        setLastError("Cannot resolve " + host + ": " + gai_strerror(status));
+        return -1;
+    }
+
+    int fd = -1;
+    for (addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+        fd = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connectWithTimeout(fd, address->ai_addr, address->ai_addrlen, CONNECT_TIMEOUT_MS)) {
+            break;
+        }
+        setLastError(systemError("connect " + connection_string));
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) {
+        return -1;
+    }
+
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+#else
+
+bool FdTransport::initialize(const std::string&) {
+    setLastError("Transport not supported on this platform");
+    return false;
+}
+bool FdTransport::closeDescriptor() { return false; }
+void FdTransport::onEvents(int, uint32_t) {}
+bool FdTransport::receive(int, std::string&) { return false; }
+bool FdTransport::send(const uint8_t*, size_t) { return false; }
+bool FdTransport::sendv(const IoSlice*, size_t) { return false; }
+int SerialTransport::openDescriptor(const std::string&) { return -1; }
+int TcpTransport::openDescriptor(const std::string&) { return -1; }
+
+#endif
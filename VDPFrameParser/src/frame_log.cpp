@@ -0,0 +1,308 @@
+#include "frame_log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#if defined(VDP_HAVE_LZ4)
+#include <lz4.h>
+#endif
+
+using namespace vdp;
+
+namespace {
+
+constexpr size_t BLOCK_HEADER_SIZE = 8;
+constexpr uint8_t COALESCED_FLAG = 0x80;   // in a record's error byte
+
+#if defined(VDP_HAVE_LZ4)
+void putU32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    out[2] = static_cast<uint8_t>(value >> 16);
+    out[3] = static_cast<uint8_t>(value >> 24);
+}
+#endif
+
+uint8_t* putVarint(uint8_t* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+// Advances position past the varint; false if the block ends inside it or it is too long
+bool getVarint(ByteSpan block, size_t& position, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        if (position >= block.size || shift > 63) {
+            return false;
+        }
+        const uint8_t byte = block[position++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+}
+
+uint32_t getU32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+} // namespace
+
+bool vdp::frameLogCompressionAvailable() {
+#if defined(VDP_HAVE_LZ4)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// FrameLogWriter
+// ---------------------------------------------------------------------------
+
+FrameLogWriter::~FrameLogWriter() {
+    close();
+}
+
+bool FrameLogWriter::open(const std::string& path, FrameLogConfig config, std::string& error) {
+    close();
+    if (config.compress && !frameLogCompressionAvailable()) {
+        error = "LZ4 compression is not available in this build";
+        return false;
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        error = "Cannot create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    // The two buffers below are the only buffering
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+
+    config_ = config;
+    config_.buffer_size = std::max(config_.buffer_size, MAX_RECORD_SIZE);
+    const uint16_t flags = CaptureHeader::FRAME_LOG | (config_.compress ? CaptureHeader::LZ4 : 0);
+    const std::vector<uint8_t> header = makeCaptureHeader(flags);
+    if (std::fwrite(header.data(), 1, header.size(), file_) != header.size()) {
+        error = "Cannot write " + path + ": " + std::strerror(errno);
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    active_.bytes.resize(config_.buffer_size);
+    active_.used = 0;
+    pending_.bytes.resize(config_.buffer_size);
+    pending_.used = 0;
+    last_timestamp_us_ = 0;
+    records_ = 0;
+    stop_ = false;
+    last_error_.clear();
+    flusher_ = std::thread(&FrameLogWriter::run, this);
+    return true;
+}
+
+void FrameLogWriter::close() {
+    if (file_ == nullptr) {
+        return;
+    }
+    handOff();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    changed_.notify_all();
+    flusher_.join();
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+void FrameLogWriter::record(ByteSpan raw_bytes, const ParseErrorDetail& error,
+                            std::chrono::system_clock::time_point timestamp) {
+    if (file_ == nullptr || raw_bytes.empty()) {
+        return;
+    }
+    if (active_.used + MAX_RECORD_SIZE > active_.bytes.size()) {
+        handOff();
+    }
+
+    const int64_t timestamp_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(timestamp.time_since_epoch()).count();
+    const int64_t delta = timestamp_us - last_timestamp_us_;
+    last_timestamp_us_ = timestamp_us;
+    // Zigzag, so a clock stepping back costs a byte rather than ten
+    const uint64_t value = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+
+    uint8_t* out = active_.bytes.data() + active_.used;
+    uint8_t* const start = out;
+    out = putVarint(out, value);
+    // Raw bytes never exceed MAX_FRAME_LEN
+    *out++ = static_cast<uint8_t>(raw_bytes.size);
+    if (error.coalesced == 0) {
+        *out++ = static_cast<uint8_t>(error.code);
+    } else {
+        *out++ = static_cast<uint8_t>(error.code) | COALESCED_FLAG;
+        out = putVarint(out, error.coalesced);
+    }
+    std::memcpy(out, raw_bytes.data, raw_bytes.size);
+    active_.used += static_cast<size_t>(out - start) + raw_bytes.size;
+    ++records_;
+}
+
+void FrameLogWriter::flush() {
+    if (file_ == nullptr) {
+        return;
+    }
+    handOff();
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return pending_.used == 0; });
+}
+
+std::string FrameLogWriter::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void FrameLogWriter::handOff() {
+    if (active_.used == 0) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Only blocks if the disk has not kept up with a whole buffer
+        changed_.wait(lock, [this] { return pending_.used == 0; });
+        std::swap(active_, pending_);
+    }
+    changed_.notify_all();
+}
+
+void FrameLogWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        changed_.wait(lock, [this] { return pending_.used != 0 || stop_; });
+        if (pending_.used == 0) {
+            return;
+        }
+        // record() does not touch pending_ until it is released below
+        lock.unlock();
+        writeBlock(pending_);
+        lock.lock();
+        pending_.used = 0;
+        changed_.notify_all();
+    }
+}
+
+void FrameLogWriter::writeBlock(const Buffer& buffer) {
+    const uint8_t* data = buffer.bytes.data();
+    size_t size = buffer.used;
+#if defined(VDP_HAVE_LZ4)
+    if (config_.compress) {
+        const int bound = LZ4_compressBound(static_cast<int>(buffer.used));
+        compressed_.resize(BLOCK_HEADER_SIZE + static_cast<size_t>(bound));
+        const int compressed_size = LZ4_compress_default(reinterpret_cast<const char*>(buffer.bytes.data()),
+                                                         reinterpret_cast<char*>(compressed_.data() + BLOCK_HEADER_SIZE),
+                                                         static_cast<int>(buffer.used), bound);
+        putU32(compressed_.data(), static_cast<uint32_t>(buffer.used));
+        putU32(compressed_.data() + 4, static_cast<uint32_t>(compressed_size));
+        data = compressed_.data();
+        size = BLOCK_HEADER_SIZE + static_cast<size_t>(compressed_size);
+    }
+#endif
+    if (std::fwrite(data, 1, size, file_) != size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = std::string("Frame log write failed: ") + std::strerror(errno);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// FrameLogReader
+// ---------------------------------------------------------------------------
+
+FrameLogReader::FrameLogReader(ByteSpan payload, uint16_t flags)
+    : input_(payload), compressed_((flags & CaptureHeader::LZ4) != 0) {
+    if (!compressed_) {
+        block_ = payload;
+        input_position_ = payload.size;
+    }
+}
+
+bool FrameLogReader::next(FrameLogRecord& out) {
+    while (position_ >= block_.size) {
+        if (!loadBlock()) {
+            return false;
+        }
+    }
+
+    uint64_t value = 0;
+    if (!getVarint(block_, position_, value)) {
+        error_ = "Corrupt frame log record";
+        return false;
+    }
+    if (block_.size - position_ < 2) {
+        error_ = "Truncated frame log record";
+        return false;
+    }
+    const size_t length = block_[position_++];
+    const uint8_t error = block_[position_++];
+    uint64_t coalesced = 0;
+    if ((error & ~COALESCED_FLAG) >= PARSE_ERROR_COUNT ||
+        ((error & COALESCED_FLAG) != 0 && (!getVarint(block_, position_, coalesced) || coalesced > UINT16_MAX))) {
+        error_ = "Corrupt frame log record";
+        return false;
+    }
+    if (length > block_.size - position_) {
+        error_ = "Truncated frame log record";
+        return false;
+    }
+    out.error = static_cast<ParseError>(error & ~COALESCED_FLAG);
+    out.coalesced = static_cast<uint16_t>(coalesced);
+
+    const int64_t delta = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    timestamp_us_ += delta;
+    out.timestamp = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds(timestamp_us_)));
+    out.raw_bytes = block_.subspan(position_, length);
+    position_ += length;
+    return true;
+}
+
+bool FrameLogReader::loadBlock() {
+    if (input_position_ >= input_.size) {
+        return false;
+    }
+    if (input_.size - input_position_ < BLOCK_HEADER_SIZE) {
+        error_ = "Truncated frame log block";
+        return false;
+    }
+    const uint32_t raw_size = getU32(input_.data + input_position_);
+    const uint32_t compressed_size = getU32(input_.data + input_position_ + 4);
+    if (compressed_size > input_.size - input_position_ - BLOCK_HEADER_SIZE ||
+        raw_size > static_cast<uint32_t>(std::numeric_limits<int>::max())) {
+        error_ = "Truncated frame log block";
+        return false;
+    }
+#if defined(VDP_HAVE_LZ4)
+    decompressed_.resize(raw_size);
+    const int decompressed = LZ4_decompress_safe(
+        reinterpret_cast<const char*>(input_.data + input_position_ + BLOCK_HEADER_SIZE),
+        reinterpret_cast<char*>(decompressed_.data()), static_cast<int>(compressed_size), static_cast<int>(raw_size));
+    if (decompressed != static_cast<int>(raw_size)) {
+        error_ = "Corrupt frame log block";
+        return false;
+    }
+    input_position_ += BLOCK_HEADER_SIZE + compressed_size;
+    block_ = {decompressed_.data(), decompressed_.size()};
+    position_ = 0;
+    return true;
+#else
+    error_ = "Frame log is LZ4 compressed, LZ4 is not available in this build";
+    return false;
+#endif
+}
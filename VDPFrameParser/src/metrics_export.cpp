@@ -0,0 +1,154 @@
+#include "metrics_export.h"
+
+#include <cstdio>
+
+using namespace vdp;
+
+namespace {
+
+constexpr double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+class Writer {
+public:
+    Writer(std::string& out, const std::string& labels, bool with_metadata)
+        : out_(out), labels_(labels), with_metadata_(with_metadata) {}
+
+    void metadata(const char* name, const char* type, const char* help) {
+        if (!with_metadata_) {
+            return;
+        }
+        out_ += "# HELP ";
+        out_ += name;
+        out_ += ' ';
+        out_ += help;
+        out_ += "\n# TYPE ";
+        out_ += name;
+        out_ += ' ';
+        out_ += type;
+        out_ += '\n';
+    }
+
+    void sample(const char* name, const char* suffix, const std::string& extra_label, uint64_t value) {
+        char number[24];
+        std::snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(value));
+        line(name, suffix, extra_label, number);
+    }
+
+    void sample(const char* name, const char* suffix, const std::string& extra_label, double value) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.9g", value);
+        line(name, suffix, extra_label, number);
+    }
+
+    void counter(const char* name, const char* help, uint64_t value) {
+        metadata(name, "counter", help);
+        sample(name, "", std::string(), value);
+    }
+
+    void gauge(const char* name, const char* help, uint64_t value) {
+        metadata(name, "gauge", help);
+        sample(name, "", std::string(), value);
+    }
+
+    // Nanosecond histogram as a summary in seconds
+    void summary(const char* name, const char* help, const metrics::HistogramSnapshot& histogram) {
+        metadata(name, "summary", help);
+        for (double q : QUANTILES) {
+            char label[32];
+            std::snprintf(label, sizeof(label), "quantile=\"%g\"", q);
+            sample(name, "", label, static_cast<double>(histogram.percentile(q)) * 1e-9);
+        }
+        sample(name, "_sum", std::string(), static_cast<double>(histogram.sum) * 1e-9);
+        sample(name, "_count", std::string(), histogram.count);
+    }
+
+private:
+    void line(const char* name, const char* suffix, const std::string& extra_label, const char* value) {
+        out_ += name;
+        out_ += suffix;
+        if (!labels_.empty() || !extra_label.empty()) {
+            out_ += '{';
+            out_ += labels_;
+            if (!labels_.empty() && !extra_label.empty()) {
+                out_ += ',';
+            }
+            out_ += extra_label;
+            out_ += '}';
+        }
+        out_ += ' ';
+        out_ += value;
+        out_ += '\n';
+    }
+
+    std::string& out_;
+    const std::string& labels_;
+    bool with_metadata_;
+};
+
+const char* reasonLabel(ParseError code) {
+    switch (code) {
+        case ParseError::None:
+            return "none";
+        case ParseError::BadLength:
+            return "bad_length";
+        case ParseError::BadEndMarker:
+            return "bad_end_marker";
+        case ParseError::BadChecksum:
+            return "bad_checksum";
+        case ParseError::Truncated:
+            return "truncated";
+        case ParseError::Stale:
+            return "stale";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+void vdp::appendPrometheus(std::string& out, const ParserMetricsSnapshot& metrics,
+                           const std::string& labels, bool with_metadata) {
+    Writer writer(out, labels, with_metadata);
+    writer.counter("vdp_parser_bytes_fed_total", "Bytes fed to the parser", metrics.bytes_fed);
+    writer.counter("vdp_parser_bytes_discarded_total", "Bytes skipped while resynchronizing",
+                   metrics.bytes_discarded);
+    writer.counter("vdp_parser_frames_total", "Valid frames parsed", metrics.frames);
+
+    writer.metadata("vdp_parser_invalid_total", "counter", "Rejected frame candidates by reason");
+    for (size_t i = 1; i < PARSE_ERROR_COUNT; ++i) {
+        writer.sample("vdp_parser_invalid_total", "",
+                      std::string("reason=\"") + reasonLabel(static_cast<ParseError>(i)) + '"',
+                      metrics.invalid[i]);
+    }
+
+    writer.summary("vdp_parser_feed_to_frame_seconds", "Time from the last feed to frame extraction",
+                   metrics.feed_to_frame_ns);
+}
+
+void vdp::appendPrometheus(std::string& out, const protocol::EngineMetricsSnapshot& metrics,
+                           const std::string& labels, bool with_metadata) {
+    Writer writer(out, labels, with_metadata);
+    writer.counter("vdp_engine_requests_total", "Requests accepted", metrics.requests);
+    writer.counter("vdp_engine_rejected_total", "Requests refused because too many were pending",
+                   metrics.rejected);
+    writer.counter("vdp_engine_responses_total", "Replies matched to a request", metrics.responses);
+    writer.counter("vdp_engine_timeouts_total", "Request attempts that timed out", metrics.timeouts);
+    writer.counter("vdp_engine_retries_total", "Request attempts retried", metrics.retries);
+
+    // Statuses that never occurred are left out, NAKs without a status byte count as "none"
+    writer.metadata("vdp_engine_naks_total", "counter", "NAK frames received by status");
+    uint64_t with_status = 0;
+    for (size_t status = 0; status < metrics.naks_by_status.size(); ++status) {
+        if (metrics.naks_by_status[status] != 0) {
+            char label[24];
+            std::snprintf(label, sizeof(label), "status=\"0x%02x\"", static_cast<unsigned>(status));
+            writer.sample("vdp_engine_naks_total", "", label, metrics.naks_by_status[status]);
+            with_status += metrics.naks_by_status[status];
+        }
+    }
+    writer.sample("vdp_engine_naks_total", "", "status=\"none\"", metrics.naks - with_status);
+
+    writer.gauge("vdp_engine_queue_depth", "Requests queued or in flight", metrics.queue_depth);
+    writer.gauge("vdp_engine_max_queue_depth", "Highest queue depth seen", metrics.max_queue_depth);
+    writer.summary("vdp_engine_round_trip_seconds", "Time from transmission to the matched reply",
+                   metrics.round_trip_ns);
+}
@@ -0,0 +1,355 @@
+#include "mobile_bridge_impl.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace carly::protocol;
+
+// ---------------------------------------------------------------------------
+// MobileBridgeImpl
+// ---------------------------------------------------------------------------
+
+MobileBridgeImpl::MobileBridgeImpl(vdp::transport::TransportFactory::Type transport_type)
+    : MobileBridgeImpl(transport_type == vdp::transport::TransportFactory::Type::MOCK
+                           ? std::make_unique<MockTransport>()
+                           : vdp::transport::TransportFactory::create(transport_type)) {
+}
+
+MobileBridgeImpl::MobileBridgeImpl(std::unique_ptr<vdp::transport::ITransport> transport)
+    : engine_(std::make_unique<vdp::protocol::VDPEngine>(std::move(transport))) {
+}
+
+MobileBridgeImpl::~MobileBridgeImpl() {
+    // The engine fails outstanding requests on destruction, and their
+    // callbacks may still use this bridge
+    engine_.reset();
+}
+
+bool MobileBridgeImpl::initialize(const std::string& device_path) {
+    if (!engine_->initialize(device_path)) {
+        setLastError(engine_->getLastError());
+        return false;
+    }
+    return true;
+}
+
+Response MobileBridgeImpl::sendFrame(const Frame& frame, uint32_t timeout_ms) {
+    vdp::protocol::Response response = engine_->sendFrame(convertToVdpFrame(frame), timeout_ms);
+    if (response.status != vdp::protocol::Status::Success) {
+        setLastError(response.error_message);
+    }
+    return convertFromVdpResponse(std::move(response));
+}
+
+void MobileBridgeImpl::sendFrameAsync(const Frame& frame,
+                                      ResponseCallback on_response,
+                                      ErrorCallback on_error) {
+    engine_->sendFrameAsync(convertToVdpFrame(frame),
+                            [this, on_response = std::move(on_response), on_error = std::move(on_error)](
+                                vdp::protocol::Response&& response) {
+        if (response.status == vdp::protocol::Status::Success) {
+            if (on_response) {
+                on_response(convertFromVdpResponse(std::move(response)));
+            }
+            return;
+        }
+        setLastError(response.error_message);
+        if (on_error) {
+            on_error(response.error_message);
+        }
+    });
+}
+
+std::vector<uint8_t> MobileBridgeImpl::sendRawData(const std::vector<uint8_t>& data) {
+    return engine_->sendRawData(data);
+}
+
+void MobileBridgeImpl::processIncomingData(const uint8_t* data, size_t length) {
+    engine_->processIncomingData(data, length);
+}
+
+bool MobileBridgeImpl::isConnected() const {
+    return engine_->isConnected();
+}
+
+void MobileBridgeImpl::disconnect() {
+    engine_->disconnect();
+}
+
+std::string MobileBridgeImpl::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void MobileBridgeImpl::setLastError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_error_ = error;
+}
+
+namespace {
+
+// The ring's head and tail are plain fields in caller memory, accessed atomically
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+              alignof(std::atomic<uint32_t>) == alignof(uint32_t) &&
+              std::atomic<uint32_t>::is_always_lock_free,
+              "CompletionRing indices must be usable as lock-free atomics");
+static_assert(sizeof(CompletionRecord) == 256, "CompletionRecord layout is part of the C interface");
+
+std::atomic<uint32_t>& ringIndex(uint32_t& index) {
+    return *reinterpret_cast<std::atomic<uint32_t>*>(&index);
+}
+
+// [ECU_ID][CMD][DATA_LEN] before each request's DATA
+constexpr size_t BATCH_RECORD_HEADER = 3;
+
+} // namespace
+
+bool MobileBridgeImpl::attachCompletionRing(CompletionRing* ring) {
+    if (ring && (!ring->records || ring->capacity == 0 || (ring->capacity & (ring->capacity - 1)) != 0)) {
+        setLastError("Completion ring capacity must be a power of two");
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(ring_mutex_);
+    if (ring_in_flight_ != 0) {
+        setLastError("Batch requests are still in flight");
+        return false;
+    }
+    ring_ = ring;
+    return true;
+}
+
+int32_t MobileBridgeImpl::submitFrameBatch(const uint8_t* requests, size_t length, uint32_t* first_request_id) {
+    // Validate the whole buffer first so a malformed one sends nothing
+    std::vector<vdp::protocol::Frame> frames;
+    for (size_t offset = 0; offset < length;) {
+        if (length - offset < BATCH_RECORD_HEADER) {
+            setLastError("Malformed request batch: truncated record at offset " + std::to_string(offset));
+            return -1;
+        }
+        const size_t data_length = requests[offset + 2];
+        if (data_length > vdp::InlineFrame::CAPACITY ||
+            length - offset - BATCH_RECORD_HEADER < data_length) {
+            setLastError("Malformed request batch: bad data length at offset " + std::to_string(offset));
+            return -1;
+        }
+        const uint8_t* data = requests + offset + BATCH_RECORD_HEADER;
+        frames.push_back({requests[offset], requests[offset + 1], std::vector<uint8_t>(data, data + data_length)});
+        offset += BATCH_RECORD_HEADER + data_length;
+    }
+
+    uint32_t first_id;
+    size_t accepted;
+    {
+        std::lock_guard<std::mutex> lock(ring_mutex_);
+        if (!ring_) {
+            setLastError("No completion ring attached");
+            return -1;
+        }
+        // Reserve a record for every accepted request up front
+        const uint32_t used = ringIndex(ring_->head).load(std::memory_order_relaxed) -
+                              ringIndex(ring_->tail).load(std::memory_order_acquire);
+        const uint32_t free_records = ring_->capacity - used - ring_in_flight_;
+        accepted = std::min<size_t>({frames.size(), free_records, static_cast<size_t>(INT32_MAX)});
+        first_id = next_request_id_;
+        next_request_id_ += static_cast<uint32_t>(accepted);
+        ring_in_flight_ += static_cast<uint32_t>(accepted);
+    }
+
+    if (first_request_id) {
+        *first_request_id = first_id;
+    }
+    for (size_t i = 0; i < accepted; ++i) {
+        const uint32_t request_id = first_id + static_cast<uint32_t>(i);
+        engine_->sendFrameAsync(std::move(frames[i]), [this, request_id](vdp::protocol::Response&& response) {
+            completeBatchRequest(request_id, std::move(response));
+        });
+    }
+    return static_cast<int32_t>(accepted);
+}
+
+void MobileBridgeImpl::completeBatchRequest(uint32_t request_id, vdp::protocol::Response&& response) {
+    const Status status = mapVdpStatusToMobile(response);
+    std::lock_guard<std::mutex> lock(ring_mutex_);
+    const uint32_t head = ringIndex(ring_->head).load(std::memory_order_relaxed);
+    CompletionRecord& record = ring_->records[head & (ring_->capacity - 1)];
+    record.request_id = request_id;
+    record.status = static_cast<uint8_t>(status);
+    record.ecu_id = response.frame.ecu_id;
+    record.command = response.frame.command;
+    const size_t data_length = std::min(response.frame.data.size(), sizeof(record.data));
+    record.data_length = static_cast<uint8_t>(data_length);
+    if (data_length != 0) {
+        std::memcpy(record.data, response.frame.data.data(), data_length);
+    }
+    ringIndex(ring_->head).store(head + 1, std::memory_order_release);
+    --ring_in_flight_;
+}
+
+// Status codes in mobile_bridge.h match the VDP ones, failed responses carry
+// the ECU's code in DATA[0] (DATA[1] for a NAK)
+Status MobileBridgeImpl::mapVdpStatusToMobile(const vdp::protocol::Response& response) {
+    switch (response.status) {
+        case vdp::protocol::Status::Success:
+            return Status::SUCCESS;
+        case vdp::protocol::Status::Timeout:
+            return Status::TIMEOUT;
+        case vdp::protocol::Status::Error:
+            break;
+    }
+
+    const vdp::protocol::Frame& frame = response.frame;
+    const bool is_nak = frame.command == static_cast<uint8_t>(vdp::CommandType::NegativeAck);
+    const bool is_response = (frame.ecu_id & vdp::RESPONSE_ECU_ID_MASK) != 0;
+    const size_t code_index = is_nak ? 1 : 0;
+    if ((is_nak || is_response) && frame.data.size() > code_index) {
+        switch (static_cast<Status>(frame.data[code_index])) {
+            case Status::INVALID_COMMAND:
+            case Status::INVALID_DATA:
+            case Status::ECU_BUSY:
+                return static_cast<Status>(frame.data[code_index]);
+            default:
+                break;
+        }
+    }
+    return Status::GENERAL_ERROR;
+}
+
+vdp::protocol::Frame MobileBridgeImpl::convertToVdpFrame(const Frame& mobile_frame) {
+    return {mobile_frame.ecu_id, mobile_frame.command, mobile_frame.data};
+}
+
+Frame MobileBridgeImpl::convertFromVdpFrame(vdp::protocol::Frame&& vdp_frame) {
+    Frame frame(vdp_frame.ecu_id, vdp_frame.command);
+    frame.data = std::move(vdp_frame.data);
+    return frame;
+}
+
+Response MobileBridgeImpl::convertFromVdpResponse(vdp::protocol::Response&& vdp_response) {
+    const Status status = mapVdpStatusToMobile(vdp_response);
+    return {status, convertFromVdpFrame(std::move(vdp_response.frame))};
+}
+
+// ---------------------------------------------------------------------------
+// MockTransport
+// ---------------------------------------------------------------------------
+
+MockTransport::MockTransport() = default;
+
+bool MockTransport::initialize(const std::string&) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connected_ = true;
+    last_error_.clear();
+    return true;
+}
+
+bool MockTransport::send(const uint8_t* data, size_t length) {
+    std::vector<uint8_t> response;
+    DataCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!connected_) {
+            last_error_ = "Not connected";
+            return false;
+        }
+        last_sent_data_.assign(data, data + length);
+        if (auto_response_enabled_) {
+            response = auto_response_data_;
+            callback = data_callback_;
+        }
+    }
+    // Answered synchronously, as if the response arrived before send() returned
+    if (callback && !response.empty()) {
+        callback(response.data(), response.size());
+    }
+    return true;
+}
+
+void MockTransport::setDataCallback(DataCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    data_callback_ = std::move(callback);
+}
+
+void MockTransport::setErrorCallback(ErrorCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_callback_ = std::move(callback);
+}
+
+bool MockTransport::isConnected() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return connected_;
+}
+
+void MockTransport::disconnect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connected_ = false;
+}
+
+std::string MockTransport::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void MockTransport::simulateIncomingData(const std::vector<uint8_t>& data) {
+    DataCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = data_callback_;
+    }
+    if (callback && !data.empty()) {
+        callback(data.data(), data.size());
+    }
+}
+
+void MockTransport::simulateError(const std::string& error) {
+    ErrorCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = error;
+        callback = error_callback_;
+    }
+    if (callback) {
+        callback(error);
+    }
+}
+
+std::vector<uint8_t> MockTransport::getLastSentData() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_sent_data_;
+}
+
+void MockTransport::setAutoResponse(bool enabled, const std::vector<uint8_t>& response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto_response_enabled_ = enabled;
+    auto_response_data_ = response;
+}
+
+// ---------------------------------------------------------------------------
+// C interface
+// ---------------------------------------------------------------------------
+
+extern "C" {
+
+IProtocolEngine* createProtocolEngine() {
+    return new MobileBridgeImpl();
+}
+
+void destroyProtocolEngine(IProtocolEngine* engine) {
+    delete engine;
+}
+
+IProtocolEngine* createProtocolEngineWithTransport(int transport_type) {
+    return new MobileBridgeImpl(static_cast<vdp::transport::TransportFactory::Type>(transport_type));
+}
+
+bool attachCompletionRing(IProtocolEngine* engine, CompletionRing* ring) {
+    auto* bridge = dynamic_cast<MobileBridgeImpl*>(engine);
+    return bridge && bridge->attachCompletionRing(ring);
+}
+
+int32_t submitFrameBatch(IProtocolEngine* engine, const uint8_t* requests, size_t length,
+                         uint32_t* first_request_id) {
+    auto* bridge = dynamic_cast<MobileBridgeImpl*>(engine);
+    return bridge ? bridge->submitFrameBatch(requests, length, first_request_id) : -1;
+}
+
+} // extern "C"
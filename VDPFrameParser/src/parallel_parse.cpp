@@ -0,0 +1,166 @@
+#include "parallel_parse.h"
+#include "byte_kernels.h"
+
+#include <algorithm>
+#include <thread>
+
+using namespace vdp;
+
+namespace {
+
+constexpr uint8_t START_BYTE = 0x7E;
+
+// Offset of the first START byte at or after from, or input.size if none
+size_t findStart(ByteSpan input, size_t from) {
+    if (from >= input.size) {
+        return input.size;
+    }
+    return from + kernels::findByte(input.data + from, input.size - from, START_BYTE);
+}
+
+// One step of the sequential scan at the START byte at pos, moves pos to the next one.
+// false if the candidate is incomplete: the scan stops there for good.
+bool step(ByteSpan input, size_t& pos, ParseResultView& out) {
+    switch (VdpParser::parseCandidate(input.subspan(pos), out)) {
+        case ParseStatus::Success:
+            pos = findStart(input, pos + out.raw_bytes.size);
+            return true;
+        case ParseStatus::Invalid:
+            out.error.offset = pos;
+            pos = findStart(input, pos + 1);
+            return true;
+        default:
+            return false;
+    }
+}
+
+struct Chunk {
+    size_t begin = 0;
+    size_t end = 0;
+    // Speculative parse from the first START byte at or after begin
+    std::vector<size_t> starts;             // offset of each result's START byte
+    std::vector<ParseResultView> results;
+    size_t exit = 0;                        // where the scan continues, at or after end
+    bool stalled = false;                   // stopped at an incomplete frame
+
+    // After stitching: repaired results, then results[accepted_from...]
+    std::vector<ParseResultView> repaired;
+    size_t accepted_from = 0;
+    size_t output_offset = 0;
+
+    size_t size() const { return repaired.size() + results.size() - accepted_from; }
+    const ParseResultView& operator[](size_t i) const {
+        return i < repaired.size() ? repaired[i] : results[accepted_from + i - repaired.size()];
+    }
+};
+
+void parseChunk(ByteSpan input, Chunk& chunk) {
+    size_t pos = findStart(input, chunk.begin);
+    ParseResultView view;
+    while (pos < chunk.end) {
+        const size_t start = pos;
+        if (!step(input, pos, view)) {
+            chunk.stalled = true;
+            break;
+        }
+        chunk.starts.push_back(start);
+        chunk.results.push_back(view);
+    }
+    chunk.exit = pos;
+}
+
+/**
+ * Continue the sequential scan at pos through chunk, return where it leaves it.
+ * Sets stalled once the scan has stopped at an incomplete frame.
+ */
+size_t stitch(ByteSpan input, Chunk& chunk, size_t pos, bool& stalled) {
+    chunk.accepted_from = chunk.results.size();
+    ParseResultView view;
+    while (pos < chunk.end) {
+        const auto met = std::lower_bound(chunk.starts.begin(), chunk.starts.end(), pos);
+        if (met != chunk.starts.end() && *met == pos) {
+            // Same position, same scan from here on
+            chunk.accepted_from = static_cast<size_t>(met - chunk.starts.begin());
+            stalled = chunk.stalled;
+            return chunk.exit;
+        }
+        if (!step(input, pos, view)) {
+            stalled = true;
+            return pos;
+        }
+        chunk.repaired.push_back(view);
+    }
+    return pos;
+}
+
+// Run fn(i) for i in [0, count) on count threads, one of them the caller
+template <typename Fn>
+void runOnThreads(size_t count, Fn fn) {
+    std::vector<std::thread> workers;
+    workers.reserve(count - 1);
+    for (size_t i = 1; i < count; ++i) {
+        workers.emplace_back(fn, i);
+    }
+    fn(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+std::vector<Chunk> parseChunks(ByteSpan input, size_t threads, size_t min_chunk) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const size_t count = std::max<size_t>(1, std::min(threads, input.size / std::max<size_t>(1, min_chunk)));
+
+    std::vector<Chunk> chunks(count);
+    for (size_t i = 0; i < count; ++i) {
+        chunks[i].begin = input.size * i / count;
+        chunks[i].end = input.size * (i + 1) / count;
+    }
+    runOnThreads(count, [&](size_t i) { parseChunk(input, chunks[i]); });
+
+    // The first chunk is entered where its own parse started, the others are
+    // replayed from where the scan actually enters them
+    size_t pos = chunks[0].exit;
+    bool stalled = chunks[0].stalled;
+    size_t output_offset = chunks[0].size();
+    for (size_t i = 1; i < count; ++i) {
+        Chunk& chunk = chunks[i];
+        if (stalled) {
+            chunk.accepted_from = chunk.results.size();
+        } else {
+            pos = stitch(input, chunk, pos, stalled);
+        }
+        chunk.output_offset = output_offset;
+        output_offset += chunk.size();
+    }
+    return chunks;
+}
+
+} // namespace
+
+std::vector<ParseResultView> vdp::parallelParseViews(ByteSpan input, size_t threads, size_t min_chunk) {
+    const std::vector<Chunk> chunks = parseChunks(input, threads, min_chunk);
+    std::vector<ParseResultView> views;
+    views.reserve(chunks.back().output_offset + chunks.back().size());
+    for (const Chunk& chunk : chunks) {
+        views.insert(views.end(), chunk.repaired.begin(), chunk.repaired.end());
+        views.insert(views.end(), chunk.results.begin() + static_cast<std::ptrdiff_t>(chunk.accepted_from),
+                     chunk.results.end());
+    }
+    return views;
+}
+
+std::vector<ParseResult> vdp::parallelParse(ByteSpan input, size_t threads, size_t min_chunk) {
+    const std::vector<Chunk> chunks = parseChunks(input, threads, min_chunk);
+    std::vector<ParseResult> results(chunks.back().output_offset + chunks.back().size());
+    // Copies allocate, so they are spread over the threads as well
+    runOnThreads(chunks.size(), [&](size_t i) {
+        const Chunk& chunk = chunks[i];
+        for (size_t j = 0; j < chunk.size(); ++j) {
+            results[chunk.output_offset + j] = chunk[j].toResult();
+        }
+    });
+    return results;
+}
@@ -0,0 +1,801 @@
+#include "protocol_engine.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+using namespace vdp;
+using namespace vdp::protocol;
+
+// Helper function to convert a byte to a 2-character hex string
+static std::string to_hex(uint8_t byte) {
+    std::stringstream ss;
+    ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
+    return ss.str();
+}
+
+// Helper to get status string from status code
+static std::string getStatusString(uint8_t status_code) {
+    switch (static_cast<ResponseStatus>(status_code)) {
+        case ResponseStatus::Success: return "Success";
+        case ResponseStatus::InvalidCommand: return "Invalid Command";
+        case ResponseStatus::InvalidData: return "Invalid Data";
+        case ResponseStatus::EcuBusy: return "ECU Busy";
+        case ResponseStatus::GeneralError: return "General Error";
+        case ResponseStatus::InvalidStatus: return "Invalid Status";
+        default: return "Unknown Status";
+    }
+}
+
+// Status codes an ECU may legitimately put in the first DATA byte of a response
+static bool isValidResponseStatus(uint8_t status_code) {
+    switch (static_cast<ResponseStatus>(status_code)) {
+        case ResponseStatus::Success:
+        case ResponseStatus::InvalidCommand:
+        case ResponseStatus::InvalidData:
+        case ResponseStatus::EcuBusy:
+        case ResponseStatus::GeneralError:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ProtocolEngineBase
+// ---------------------------------------------------------------------------
+
+ProtocolEngineBase::ProtocolEngineBase(std::unique_ptr<transport::ITransport> transport)
+    : transport_(std::move(transport)), parser_(std::make_unique<VdpParser>()) {
+}
+
+ProtocolEngineBase::~ProtocolEngineBase() {
+    disconnect();
+}
+
+bool ProtocolEngineBase::initialize(const std::string& connection_string) {
+    if (!transport_) {
+        setLastError("No transport available");
+        return false;
+    }
+
+    transport_->setDataCallback([this](const uint8_t* data, size_t length) {
+        onTransportDataReceived(data, length);
+    });
+    // Transports that support it read straight into the parser's buffer
+    transport_->setReceiveBuffer({
+        [this](size_t capacity) { return parser_->prepareWrite(capacity); },
+        [this](VdpParser::WriteLease lease, size_t length) { onTransportDataCommitted(std::move(lease), length); }});
+    transport_->setErrorCallback([this](const std::string& error) {
+        onTransportErrorReceived(error);
+    });
+
+    if (!transport_->initialize(connection_string)) {
+        setLastError("Transport initialization failed: " + transport_->getLastError());
+        return false;
+    }
+
+    parser_->reset();
+    connected_ = true;
+    return true;
+}
+
+bool ProtocolEngineBase::isConnected() const {
+    return connected_ && transport_ && transport_->isConnected();
+}
+
+void ProtocolEngineBase::disconnect() {
+    if (connected_.exchange(false) && transport_) {
+        transport_->disconnect();
+    }
+}
+
+std::string ProtocolEngineBase::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+bool ProtocolEngineBase::sendRawData(const uint8_t* data, size_t length) {
+    if (!connected_ || !transport_) {
+        setLastError("Not connected");
+        return false;
+    }
+    if (!transport_->send(data, length)) {
+        setLastError("Transport send failed: " + transport_->getLastError());
+        return false;
+    }
+    return true;
+}
+
+bool ProtocolEngineBase::sendRawData(const FrameSlices& slices) {
+    if (!connected_ || !transport_) {
+        setLastError("Not connected");
+        return false;
+    }
+    const transport::IoSlice io[] = {
+        {slices.header, sizeof(slices.header)},
+        {slices.payload.data, slices.payload.size},
+        {slices.footer, sizeof(slices.footer)},
+    };
+    if (!transport_->sendv(io, 3)) {
+        setLastError("Transport send failed: " + transport_->getLastError());
+        return false;
+    }
+    return true;
+}
+
+void ProtocolEngineBase::setLastError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_error_ = error;
+}
+
+void ProtocolEngineBase::processIncomingData(const uint8_t* data, size_t length) {
+    onTransportDataReceived(data, length);
+}
+
+void ProtocolEngineBase::processIncomingData(const uint8_t* data, size_t length, RxTimestamp received) {
+    parser_->feed(data, length, received);
+    processParserResults(parser_->extractFrames());
+}
+
+void ProtocolEngineBase::onTransportDataReceived(const uint8_t* data, size_t length) {
+    parser_->feed(data, length);
+    processParserResults(parser_->extractFrames());
+}
+
+void ProtocolEngineBase::onTransportDataCommitted(VdpParser::WriteLease lease, size_t length) {
+    lease.commit(length);
+    processParserResults(parser_->extractFrames());
+}
+
+void ProtocolEngineBase::onTransportErrorReceived(const std::string& error) {
+    setLastError(error);
+    onTransportError(error);
+}
+
+void ProtocolEngineBase::processParserResults(std::vector<ParseResult>&& results) {
+    for (auto& result : results) {
+        if (result.status == ParseStatus::Success && result.frame) {
+            onFrameReceived(std::move(*result.frame));
+        } else if (result.status == ParseStatus::Invalid) {
+            onParseError(result.message());
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// VDPEngine
+// ---------------------------------------------------------------------------
+
+VDPEngine::VDPEngine(std::unique_ptr<transport::ITransport> transport, size_t request_capacity)
+    : ProtocolEngineBase(std::move(transport)), pending_requests_(std::tuple_size<decltype(ecu_queues_)>::value),
+      request_capacity_(request_capacity), queue_pool_(request_capacity) {
+    timeout_thread_ = std::thread(&VDPEngine::timeoutWorker, this);
+}
+
+VDPEngine::~VDPEngine() {
+    // Stop receiving before tearing down request state
+    disconnect();
+
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        stop_timeout_thread_ = true;
+    }
+    timeout_cv_.notify_all();
+    if (timeout_thread_.joinable()) {
+        timeout_thread_.join();
+    }
+
+    // Fail anything still outstanding so no caller is left waiting
+    std::vector<PendingRequest> remaining;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        drainAllNoLock(remaining);
+    }
+    for (auto& request : remaining) {
+        request.on_complete({Status::Error, std::move(request.original_frame), "Engine shut down"});
+    }
+}
+
+Response VDPEngine::sendFrame(const Frame& frame, uint32_t timeout_ms) {
+    struct SyncState {
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool done = false;
+        Response response;
+    };
+    auto state = std::make_shared<SyncState>();
+
+    submitRequest(frame, std::chrono::milliseconds(timeout_ms), [state](Response&& response) {
+        std::lock_guard<std::mutex> lock(state->mtx);
+        state->response = std::move(response);
+        state->done = true;
+        state->cv.notify_one();
+    });
+
+    // Every request completes: by response, send failure or the timeout worker
+    std::unique_lock<std::mutex> lock(state->mtx);
+    state->cv.wait(lock, [&] { return state->done; });
+    return std::move(state->response);
+}
+
+void VDPEngine::sendFrameAsync(const Frame& frame,
+                               ResponseCallback on_response,
+                               ErrorCallback on_error) {
+    std::chrono::milliseconds timeout;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        timeout = default_timeout_;
+    }
+
+    submitRequest(frame, timeout,
+                  [on_response = std::move(on_response), on_error = std::move(on_error)](Response&& response) {
+        if (response.status == Status::Success) {
+            if (on_response) {
+                on_response(response);
+            }
+        } else if (on_error) {
+            on_error(response.error_message);
+        }
+    });
+}
+
+void VDPEngine::sendFrameAsync(Frame frame, CompletionCallback on_complete) {
+    std::chrono::milliseconds timeout;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        timeout = default_timeout_;
+    }
+    submitRequest(std::move(frame), timeout, std::move(on_complete));
+}
+
+std::vector<uint8_t> VDPEngine::sendRawData(const std::vector<uint8_t>& data) {
+    // Raw sends are not tracked, responses surface through onFrameReceived
+    ProtocolEngineBase::sendRawData(data.data(), data.size());
+    return {};
+}
+
+void VDPEngine::setDefaultTimeout(std::chrono::milliseconds timeout) {
+    std::lock_guard<std::mutex> lock(requests_mutex_);
+    default_timeout_ = timeout;
+}
+
+size_t VDPEngine::pendingRequestCount() const {
+    std::lock_guard<std::mutex> lock(requests_mutex_);
+    return pending_requests_.size() + queued_count_;
+}
+
+void VDPEngine::setInterFrameDelay(std::chrono::microseconds delay) {
+    std::lock_guard<std::mutex> lock(requests_mutex_);
+    inter_frame_delay_ = delay;
+}
+
+void VDPEngine::setRetryPolicy(CommandType command, const RetryPolicy& policy) {
+    std::lock_guard<std::mutex> lock(requests_mutex_);
+    policies_[static_cast<uint8_t>(command)] = policy;
+}
+
+RetryPolicy VDPEngine::retryPolicy(CommandType command) const {
+    std::lock_guard<std::mutex> lock(requests_mutex_);
+    return policies_[static_cast<uint8_t>(command)];
+}
+
+EcuStats VDPEngine::ecuStats(uint8_t ecu_id) const {
+    std::lock_guard<std::mutex> lock(requests_mutex_);
+    return ecuStatsNoLock(ecu_id);
+}
+
+EngineMetricsSnapshot VDPEngine::metrics() const {
+    EngineMetricsSnapshot out;
+    std::lock_guard<std::mutex> lock(requests_mutex_);
+    out.requests = metrics_.requests.value();
+    out.rejected = metrics_.rejected.value();
+    out.responses = metrics_.responses.value();
+    out.timeouts = metrics_.timeouts.value();
+    out.retries = metrics_.retries.value();
+    out.naks = metrics_.naks.value();
+    for (size_t status = 0; status < out.naks_by_status.size(); ++status) {
+        out.naks_by_status[status] = metrics_.naks_by_status[status].value();
+    }
+    out.queue_depth = pending_requests_.size() + queued_count_;
+    out.max_queue_depth = metrics_.max_queue_depth;
+    out.round_trip_ns = metrics_.round_trip_ns.snapshot();
+    return out;
+}
+
+std::vector<EcuStats> VDPEngine::ecuStatsSnapshot() const {
+    std::vector<EcuStats> snapshot;
+    std::lock_guard<std::mutex> lock(requests_mutex_);
+    for (size_t ecu = 0; ecu < ecu_stats_.size(); ++ecu) {
+        if (ecu_stats_[ecu].responses() != 0 || ecu_stats_[ecu].timeouts() != 0) {
+            snapshot.push_back(ecuStatsNoLock(static_cast<uint8_t>(ecu)));
+        }
+    }
+    return snapshot;
+}
+
+EcuStats VDPEngine::ecuStatsNoLock(uint8_t ecu_id) const {
+    ecu_id &= ~RESPONSE_ECU_ID_MASK;
+    const LatencyTracker& tracker = ecu_stats_[ecu_id];
+    RetryPolicy adaptive;
+    adaptive.adaptive_timeout = true;
+
+    EcuStats stats;
+    stats.ecu_id = ecu_id;
+    stats.responses = tracker.responses();
+    stats.timeouts = tracker.timeouts();
+    stats.retries = tracker.retries();
+    stats.ewma = tracker.ewma();
+    stats.deviation = tracker.deviation();
+    stats.p99 = tracker.p99();
+    stats.adaptive_timeout = adaptive.attemptTimeout(tracker, default_timeout_);
+    return stats;
+}
+
+void VDPEngine::submitBatch(std::vector<Frame> frames, BatchCallback on_complete) {
+    if (frames.empty()) {
+        if (on_complete) {
+            on_complete({});
+        }
+        return;
+    }
+
+    // Checked before anything is queued, so the batch is sent whole or not at all
+    const bool too_large = std::any_of(frames.begin(), frames.end(),
+                                       [](const Frame& frame) { return frame.data.size() > MAX_DATA_SIZE; });
+    if (too_large) {
+        std::vector<Response> responses;
+        responses.reserve(frames.size());
+        for (Frame& frame : frames) {
+            const bool oversized = frame.data.size() > MAX_DATA_SIZE;
+            responses.push_back({Status::Error, std::move(frame),
+                                 oversized ? "Frame data too large" : "Not sent, another frame of the batch is too large"});
+        }
+        if (on_complete) {
+            on_complete(responses);
+        }
+        return;
+    }
+
+    struct BatchState {
+        std::mutex mtx;
+        std::vector<Response> responses;
+        size_t remaining;
+        BatchCallback on_complete;
+    };
+    auto state = std::make_shared<BatchState>();
+    state->responses.resize(frames.size());
+    state->remaining = frames.size();
+    state->on_complete = std::move(on_complete);
+
+    std::chrono::milliseconds timeout;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        timeout = default_timeout_;
+    }
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+        submitRequest(std::move(frames[i]), timeout, [state, i](Response&& response) {
+            bool last;
+            {
+                std::lock_guard<std::mutex> lock(state->mtx);
+                state->responses[i] = std::move(response);
+                last = --state->remaining == 0;
+            }
+            if (last && state->on_complete) {
+                state->on_complete(state->responses);
+            }
+        });
+    }
+}
+
+void VDPEngine::submitRequest(Frame frame,
+                              std::chrono::milliseconds timeout,
+                              CompletionCallback on_complete) {
+    if (frame.data.size() > MAX_DATA_SIZE) {
+        on_complete({Status::Error, std::move(frame), "Frame data too large"});
+        return;
+    }
+
+    bool accepted = false;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        // Retries move a request from flight back into the queue, so the pool
+        // cannot run out while the total stays below its capacity
+        if (pending_requests_.size() + queued_count_ < request_capacity_) {
+            // Queue behind earlier requests to the same ECU
+            const uint8_t ecu = frame.ecu_id & ~RESPONSE_ECU_ID_MASK;
+            EcuQueue& queue = ecu_queues_[ecu];
+            const QueuePool::Index index = queue_pool_.acquire();
+            QueuedRequest& queued = queue_pool_[index];
+            queued.frame = std::move(frame);
+            queued.timeout = timeout;
+            queued.on_complete = std::move(on_complete);
+            queue.waiting.pushBack(queue_pool_, index);
+            ++queued_count_;
+            if (!queue.busy && !queue.ready) {
+                queue.ready = true;
+                ready_ecus_.push_back(ecu);
+            }
+            accepted = true;
+            metrics_.requests.add();
+            if constexpr (metrics::ENABLED) {
+                metrics_.max_queue_depth = std::max(metrics_.max_queue_depth, pending_requests_.size() + queued_count_);
+            }
+        } else {
+            metrics_.rejected.add();
+        }
+    }
+    if (!accepted) {
+        on_complete({Status::Error, std::move(frame), "Too many pending requests"});
+        return;
+    }
+    pumpQueue();
+}
+
+bool VDPEngine::dispatchNextNoLock(std::chrono::steady_clock::time_point now, Dispatch& out) {
+    if (ready_ecus_.empty() || now < next_send_time_) {
+        return false;
+    }
+
+    // Round-robin over idle ECUs, each gets one request in flight. ECUs whose
+    // next request is a retry still backing off are passed over.
+    auto it = ready_ecus_.begin();
+    while (it != ready_ecus_.end() && now < frontNoLock(ecu_queues_[*it]).not_before) {
+        ++it;
+    }
+    if (it == ready_ecus_.end()) {
+        return false;
+    }
+    const uint8_t ecu = *it;
+    ready_ecus_.erase(it);
+    EcuQueue& queue = ecu_queues_[ecu];
+    queue.ready = false;
+    queue.busy = true;
+
+    const QueuePool::Index index = queue.waiting.popFront(queue_pool_);
+    QueuedRequest& queued = queue_pool_[index];
+    --queued_count_;
+
+    const auto timeout = policies_[queued.frame.command].attemptTimeout(ecu_stats_[ecu], queued.timeout);
+
+    // Register before sending, the response may arrive before send() returns.
+    // At most one request per ECU is in flight, so neither table can be full.
+    const Frame& frame = queued.frame;
+    out.ecu_id = frame.ecu_id;
+    out.command = frame.command;
+    out.length = static_cast<uint8_t>(frame.data.size());   // validated by submitRequest()
+    std::copy(frame.data.begin(), frame.data.end(), out.payload.begin());
+
+    PendingRequest request;
+    request.on_complete = std::move(queued.on_complete);
+    request.original_frame = std::move(queued.frame);
+    request.sent_time = now;
+    request.timeout = queued.timeout;
+    request.attempt = queued.attempt;
+    queue_pool_.release(index);
+    out.handle = pending_requests_.insert(out.ecu_id, out.command, std::move(request));
+    pending_requests_.find(out.handle)->timer = timers_.arm(now + timeout, out.handle);
+
+    next_send_time_ = now + inter_frame_delay_;
+    return true;
+}
+
+void VDPEngine::transmit(const Dispatch& dispatch) {
+    // The payload goes to the transport in place as the middle slice
+    FrameSlices slices;
+    parser().serializeSlices(dispatch.ecu_id, dispatch.command, ByteSpan{dispatch.payload.data(), dispatch.length},
+                             slices);
+    if (ProtocolEngineBase::sendRawData(slices)) {
+        return;
+    }
+
+    PendingRequest request;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        found = pending_requests_.take(dispatch.handle, request);
+        if (found) {
+            timers_.cancel(request.timer);
+            releaseEcuNoLock(dispatch.ecu_id);
+        }
+    }
+    if (found) {
+        const std::string error = "Failed to send frame: " + getLastError();
+        request.on_complete({Status::Error, std::move(request.original_frame), error});
+    }
+}
+
+void VDPEngine::pumpQueue() {
+    Dispatch dispatch;
+    for (;;) {
+        bool dispatched;
+        bool wake_worker;
+        {
+            std::lock_guard<std::mutex> lock(requests_mutex_);
+            dispatched = dispatchNextNoLock(std::chrono::steady_clock::now(), dispatch);
+            wake_worker = nextWakeupNoLock() < worker_deadline_;
+        }
+        if (wake_worker) {
+            timeout_cv_.notify_one();
+        }
+        if (!dispatched) {
+            return;
+        }
+        transmit(dispatch);
+    }
+}
+
+void VDPEngine::releaseEcuNoLock(uint8_t ecu_id) {
+    EcuQueue& queue = ecu_queues_[ecu_id & ~RESPONSE_ECU_ID_MASK];
+    queue.busy = false;
+    if (!queue.waiting.empty() && !queue.ready) {
+        queue.ready = true;
+        ready_ecus_.push_back(ecu_id & ~RESPONSE_ECU_ID_MASK);
+    }
+}
+
+std::chrono::steady_clock::time_point VDPEngine::nextWakeupNoLock() const {
+    auto wakeup = timers_.nextDeadline();
+    if (ready_ecus_.empty()) {
+        return wakeup;
+    }
+    // The next transmission waits for pacing and for the earliest backoff to end
+    auto send_time = std::chrono::steady_clock::time_point::max();
+    for (uint8_t ecu : ready_ecus_) {
+        send_time = std::min(send_time, queue_pool_[ecu_queues_[ecu].waiting.head].not_before);
+    }
+    send_time = std::max(send_time, next_send_time_);
+    return std::min(wakeup, send_time);
+}
+
+bool VDPEngine::retryNoLock(PendingRequest& request, std::chrono::steady_clock::time_point now) {
+    const Frame& frame = request.original_frame;
+    const RetryPolicy& policy = policies_[frame.command];
+    if (request.attempt >= policy.max_retries) {
+        return false;
+    }
+
+    const uint8_t ecu = frame.ecu_id & ~RESPONSE_ECU_ID_MASK;
+    LatencyTracker& stats = ecu_stats_[ecu];
+    const uint8_t attempt = static_cast<uint8_t>(request.attempt + 1);
+    stats.recordRetry();
+    metrics_.retries.add();
+
+    // Ahead of later requests to the same ECU, the caller releases the ECU
+    const QueuePool::Index index = queue_pool_.acquire();
+    QueuedRequest& queued = queue_pool_[index];
+    queued.frame = std::move(request.original_frame);
+    queued.timeout = request.timeout;
+    queued.on_complete = std::move(request.on_complete);
+    queued.attempt = attempt;
+    queued.not_before = now + policy.backoff(stats, attempt);
+    ecu_queues_[ecu].waiting.pushFront(queue_pool_, index);
+    ++queued_count_;
+    return true;
+}
+
+void VDPEngine::drainAllNoLock(std::vector<PendingRequest>& out) {
+    pending_requests_.drain(out);
+    timers_.clear();
+    for (auto& queue : ecu_queues_) {
+        while (!queue.waiting.empty()) {
+            const QueuePool::Index index = queue.waiting.popFront(queue_pool_);
+            PendingRequest request;
+            request.on_complete = std::move(queue_pool_[index].on_complete);
+            request.original_frame = std::move(queue_pool_[index].frame);
+            out.push_back(std::move(request));
+            queue_pool_.release(index);
+        }
+        queue.busy = false;
+        queue.ready = false;
+    }
+    ready_ecus_.clear();
+    queued_count_ = 0;
+}
+
+bool VDPEngine::takeMatchingRequest(uint8_t ecu_id, uint8_t command, PendingRequest& out) {
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(requests_mutex_);
+    if (!pending_requests_.takeOldest(ecu_id, command, out)) {
+        return false;
+    }
+    timers_.cancel(out.timer);
+    ecu_stats_[ecu_id & ~RESPONSE_ECU_ID_MASK].record(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - out.sent_time));
+    metrics_.responses.add();
+    metrics_.round_trip_ns.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - out.sent_time).count()));
+    return true;
+}
+
+void VDPEngine::completeRequest(PendingRequest& request, Response&& response, bool ecu_busy) {
+    bool retried;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        retried = ecu_busy && policies_[request.original_frame.command].retry_on_busy &&
+                  retryNoLock(request, std::chrono::steady_clock::now());
+        releaseEcuNoLock(request.original_frame.ecu_id);
+    }
+    // The ECU is free again, start its next request before running the callback
+    pumpQueue();
+    if (!retried) {
+        request.on_complete(std::move(response));
+    }
+}
+
+// Process received frame and match with pending requests
+void VDPEngine::onFrameReceived(VdpFrame&& frame) {
+    // Handle ACK/NAK frames first
+    if (frame.command == static_cast<uint8_t>(CommandType::Acknowledge)) {
+        handleAckNak(std::move(frame), true);
+        return;
+    } else if (frame.command == static_cast<uint8_t>(CommandType::NegativeAck)) {
+        handleAckNak(std::move(frame), false);
+        return;
+    }
+
+    // Validate the command
+    if (!isValidCommand(frame.command)) {
+        sendNak(frame.ecu_id, frame.command, ResponseStatus::InvalidCommand);
+        return;
+    }
+
+    // Check if this is a response frame (ECU_ID has 0x80 bit set)
+    bool is_response = (frame.ecu_id & RESPONSE_ECU_ID_MASK) != 0;
+    uint8_t ecu_id = frame.ecu_id & ~RESPONSE_ECU_ID_MASK;
+
+    PendingRequest request;
+    if (!takeMatchingRequest(ecu_id, frame.command, request)) {
+        // Unsolicited frame (keep-alives always are), nothing is waiting for it
+        return;
+    }
+
+    if (is_response && !frame.data.empty()) {
+        uint8_t status = frame.data[0];
+        if (!isValidResponseStatus(status)) {
+            sendNak(frame.ecu_id, frame.command, ResponseStatus::InvalidStatus);
+            completeRequest(request, createResponse(Status::Error, std::move(frame),
+                                                    "Response with invalid status code: 0x" + to_hex(status)), false);
+            return;
+        }
+        if (status != static_cast<uint8_t>(ResponseStatus::Success)) {
+            completeRequest(request, createResponse(Status::Error, std::move(frame),
+                                                    "ECU responded: " + getStatusString(status) +
+                                                    " (0x" + to_hex(status) + ")"),
+                            status == static_cast<uint8_t>(ResponseStatus::EcuBusy));
+            return;
+        }
+    }
+
+    completeRequest(request, createResponse(Status::Success, std::move(frame)), false);
+}
+
+// Handle ACK/NAK frames, DATA[0] carries the command being (N)ACK'ed
+void VDPEngine::handleAckNak(VdpFrame&& frame, bool is_ack) {
+    if (frame.data.empty()) {
+        // Invalid ACK/NAK - nothing to correlate with
+        return;
+    }
+    if (metrics::ENABLED && !is_ack) {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        metrics_.naks.add();
+        if (frame.data.size() > 1) {
+            metrics_.naks_by_status[frame.data[1]].add();
+        }
+    }
+
+    PendingRequest request;
+    if (!takeMatchingRequest(frame.ecu_id & ~RESPONSE_ECU_ID_MASK, frame.data[0], request)) {
+        return;
+    }
+
+    if (is_ack) {
+        if (frame.data.size() > 1 && !isValidResponseStatus(frame.data[1])) {
+            std::string error = "ACK with invalid status code: 0x" + to_hex(frame.data[1]);
+            completeRequest(request, createResponse(Status::Error, std::move(frame), std::move(error)), false);
+        } else {
+            completeRequest(request, createResponse(Status::Success, std::move(frame)), false);
+        }
+        return;
+    }
+
+    // NAK handling
+    std::string error = "NAK received";
+    bool ecu_busy = false;
+    if (frame.data.size() > 1) {
+        uint8_t error_code = frame.data[1];
+        error += ": " + getStatusString(error_code) + " (0x" + to_hex(error_code) + ")";
+        ecu_busy = error_code == static_cast<uint8_t>(ResponseStatus::EcuBusy);
+    }
+    completeRequest(request, createResponse(Status::Error, std::move(frame), std::move(error)), ecu_busy);
+}
+
+void VDPEngine::sendNak(uint8_t ecu_id, uint8_t command, ResponseStatus status) {
+    // NAK payload is [CMD][STATUS], built on the stack
+    const uint8_t payload[2] = {command, static_cast<uint8_t>(status)};
+    uint8_t nak_bytes[MAX_SERIALIZED_FRAME_SIZE];
+    size_t length = parser().serializeInto(ecu_id & ~RESPONSE_ECU_ID_MASK, // Clear response bit if set
+                                           static_cast<uint8_t>(CommandType::NegativeAck),
+                                           ByteSpan{payload, sizeof(payload)}, nak_bytes, sizeof(nak_bytes));
+    ProtocolEngineBase::sendRawData(nak_bytes, length);
+}
+
+void VDPEngine::onParseError(const std::string& error) {
+    setLastError("Parse error: " + error);
+}
+
+void VDPEngine::onTransportError(const std::string& error) {
+    // The link is unusable, fail everything in flight or queued
+    std::vector<PendingRequest> failed;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        drainAllNoLock(failed);
+    }
+    for (auto& request : failed) {
+        request.on_complete({Status::Error, std::move(request.original_frame), "Transport error: " + error});
+    }
+}
+
+void VDPEngine::timeoutWorker() {
+    std::vector<PendingRequest> expired;
+    Dispatch dispatch;
+    std::unique_lock<std::mutex> lock(requests_mutex_);
+    while (!stop_timeout_thread_) {
+        // Sleep until the earliest timer or paced transmission, or until
+        // something earlier is scheduled
+        worker_deadline_ = nextWakeupNoLock();
+        if (worker_deadline_ == std::chrono::steady_clock::time_point::max()) {
+            timeout_cv_.wait(lock);
+        } else {
+            timeout_cv_.wait_until(lock, worker_deadline_);
+        }
+        if (stop_timeout_thread_) {
+            break;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        collectExpiredNoLock(now, expired);
+        bool dispatched = dispatchNextNoLock(now, dispatch);
+        if (expired.empty() && !dispatched) {
+            continue;
+        }
+
+        // Sends and callbacks run without the lock so callbacks may issue new requests
+        lock.unlock();
+        if (dispatched) {
+            transmit(dispatch);
+        }
+        for (auto& request : expired) {
+            request.on_complete({Status::Timeout, std::move(request.original_frame), "Request timed out"});
+        }
+        expired.clear();
+        lock.lock();
+    }
+}
+
+void VDPEngine::collectExpiredNoLock(std::chrono::steady_clock::time_point now,
+                                     std::vector<PendingRequest>& expired) {
+    timers_.advance(now, [&](uint64_t handle) {
+        PendingRequest request;
+        // A handle already taken has nothing left to retry or expire
+        if (!pending_requests_.take(static_cast<RequestTable::Handle>(handle), request)) {
+            return;
+        }
+        const uint8_t ecu_id = request.original_frame.ecu_id;
+        ecu_stats_[ecu_id & ~RESPONSE_ECU_ID_MASK].recordTimeout();
+        metrics_.timeouts.add();
+        if (!retryNoLock(request, now)) {
+            expired.push_back(std::move(request));
+        }
+        releaseEcuNoLock(ecu_id);
+    });
+}
+
+Frame VDPEngine::convertFromVdpFrame(VdpFrame&& frame) {
+    return {frame.ecu_id, frame.command, std::move(frame.data)};
+}
+
+Response VDPEngine::createResponse(Status status, VdpFrame&& frame, std::string error) {
+    return {status, convertFromVdpFrame(std::move(frame)), std::move(error)};
+}
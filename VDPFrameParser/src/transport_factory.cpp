@@ -0,0 +1,19 @@
+#include "can_transport.h"
+#include "fd_transport.h"
+#include "transport_interface.h"
+
+using namespace vdp::transport;
+
+std::unique_ptr<ITransport> TransportFactory::create(Type type) {
+    switch (type) {
+        case Type::SERIAL:
+            return std::make_unique<SerialTransport>();
+        case Type::CAN:
+            return std::make_unique<CanTransport>();
+        case Type::TCP:
+            return std::make_unique<TcpTransport>();
+        default:
+            // No implementation in this library
+            return nullptr;
+    }
+}
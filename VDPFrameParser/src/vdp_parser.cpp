@@ -1,463 +1,641 @@
 #include "vdp_parser.h"
+#include "byte_kernels.h"
 #include <stdexcept>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
-#include <condition_variable>
+#include <thread>
 
 using namespace vdp;
 
-// Helper function to convert a byte to a 2-character hex string
-static std::string to_hex(uint8_t byte) {
-    std::stringstream ss;
-    ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
-    return ss.str();
-}
-
 void VdpParser::serializeFrame(const VdpFrame& frame, std::vector<uint8_t>& out) const {
-    // Clear output vector
-    out.clear();
-    
-    // Start with the frame start byte
-    out.push_back(START_BYTE);
-    
-    // Calculate frame length (ECU_ID + CMD + DATA + CHK)
-    size_t data_length = 2 + frame.data.size(); // ECU_ID (1) + CMD (1) + DATA (n)
-    if (data_length > 253 - 4) { // 4 = START(1) + LEN(1) + CHK(1) + END(1)
+    if (frame.data.size() > MAX_FRAME_LEN - HEADER_SIZE - FOOTER_SIZE) {
         throw std::runtime_error("Frame data too large");  //throw because the error is not expected
     }
-    
-    // Add length byte (including all bytes except START and END)
-    out.push_back(static_cast<uint8_t>(data_length + 2)); // +2 for CHK and LEN itself
-    
-    // Add ECU ID and command
-    out.push_back(frame.ecu_id);
-    out.push_back(frame.command);
-    
-    // Add data if present
-    if (!frame.data.empty()) {
-        out.insert(out.end(), frame.data.begin(), frame.data.end());
+
+    // resize() keeps the vector's capacity, so reused vectors do not reallocate
+    out.resize(HEADER_SIZE + frame.data.size() + FOOTER_SIZE);
+    serializeInto(frame, out.data(), out.size());
+}
+
+size_t VdpParser::serializeInto(const VdpFrame& frame, uint8_t* out, size_t capacity) const {
+    return serializeInto(frame.ecu_id, frame.command, ByteSpan{frame.data.data(), frame.data.size()},
+                         out, capacity);
+}
+
+size_t VdpParser::serializeInto(uint8_t ecu_id, uint8_t command, ByteSpan data,
+                                uint8_t* out, size_t capacity) const {
+    // LEN is the total frame length: [7E][LEN][ECU][CMD][DATA...][CHK][7F]
+    const size_t frame_length = HEADER_SIZE + data.size + FOOTER_SIZE;
+    if (frame_length > MAX_FRAME_LEN || frame_length > capacity) {
+        return 0;
     }
-    
-    // Calculate and add checksum (XOR of all bytes after START)
-    uint8_t checksum = 0;
-    for (size_t i = 1; i < out.size(); ++i) {
-        checksum ^= out[i];
+
+    out[0] = START_BYTE;
+    out[1] = static_cast<uint8_t>(frame_length);
+    out[2] = ecu_id;
+    out[3] = command;
+
+    // Checksum is the XOR of all bytes after START, the payload part is
+    // accumulated while it is copied
+    uint8_t checksum = out[1] ^ ecu_id ^ command;
+    checksum ^= kernels::copyXor(out + HEADER_SIZE, data.data, data.size);
+
+    out[HEADER_SIZE + data.size] = checksum;
+    out[HEADER_SIZE + data.size + 1] = END_BYTE;
+    return frame_length;
+}
+
+bool VdpParser::serializeSlices(const VdpFrame& frame, FrameSlices& out) const {
+    return serializeSlices(frame.ecu_id, frame.command, ByteSpan{frame.data.data(), frame.data.size()}, out);
+}
+
+bool VdpParser::serializeSlices(uint8_t ecu_id, uint8_t command, ByteSpan data, FrameSlices& out) const {
+    const size_t frame_length = HEADER_SIZE + data.size + FOOTER_SIZE;
+    if (frame_length > MAX_FRAME_LEN) {
+        return false;
     }
-    out.push_back(checksum);
-    
-    // Add end byte
-    out.push_back(END_BYTE);
+
+    out.header[0] = START_BYTE;
+    out.header[1] = static_cast<uint8_t>(frame_length);
+    out.header[2] = ecu_id;
+    out.header[3] = command;
+    out.payload = data;
+    out.footer[0] = out.header[1] ^ ecu_id ^ command ^ kernels::xorReduce(data.data, data.size);
+    out.footer[1] = END_BYTE;
+    return true;
 }
 
-bool VdpParser::verifyChecksum(const std::vector<uint8_t>& frame, std::string& debugOutput) const {
+bool VdpParser::verifyChecksum(ByteSpan frame, ParseErrorDetail& detail) {
     // Frame must have at least: [7E][LEN][ECU][CMD][CHK][7F] (6 bytes)
-    if (frame.size() < 6) {
-        std::stringstream ss;
-        ss << "Frame too short for checksum verification (size: " << frame.size() << ")";
-        debugOutput = ss.str();
+    if (frame.size < 6) {
+        detail.code = ParseError::Truncated;
+        detail.length = static_cast<uint8_t>(frame.size);
         return false;
     }
     
-    uint8_t calculated_checksum = 0;
     // XOR all bytes from LEN until the checksum byte
-    for (size_t i = 1; i < frame.size() - 2; ++i) {
-        calculated_checksum ^= frame[i];
-    }
+    uint8_t calculated_checksum = kernels::xorReduce(frame.data + 1, frame.size - 3);
     
     // Get the expected checksum (byte before the end byte)
-    uint8_t expected_checksum = frame[frame.size() - 2];
+    uint8_t expected_checksum = frame[frame.size - 2];
     
     if (calculated_checksum != expected_checksum) {
-        std::stringstream ss;
-        ss << "Checksum verification failed: " 
-           << "calculated=0x" << std::hex << (int)calculated_checksum 
-           << ", expected=0x" << (int)expected_checksum << std::dec;
-        debugOutput = ss.str();
+        detail.code = ParseError::BadChecksum;
+        detail.length = static_cast<uint8_t>(frame.size);
+        detail.position = static_cast<uint8_t>(frame.size - 2);
+        detail.calculated = calculated_checksum;
+        detail.expected = expected_checksum;
         return false;
     }
     
     return true;
 }
 
-std::vector<ParseResult> VdpParser::extractFrames() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::vector<ParseResult> results;
-
-    while (true) {
-        // 1. Find the next start byte and discard any garbage before it.
-        // This is the key to resynchronization after an error.
-        size_t start_byte_pos = 0;
-        while (start_byte_pos < buffer_.size() && buffer_[start_byte_pos] != START_BYTE) {
-            start_byte_pos++;
-        }
-
-        if (start_byte_pos > 0) {
-            buffer_.erase(buffer_.begin(), buffer_.begin() + start_byte_pos);
-        }
+// Names the error, all that is printed when its details were not captured
+static const char* codeName(ParseError code) {
+    switch (code) {
+        case ParseError::None:
+            return "";
+        case ParseError::BadLength:
+            return "Invalid frame length";
+        case ParseError::BadEndMarker:
+            return "End marker not found";
+        case ParseError::BadChecksum:
+            return "Checksum verification failed";
+        case ParseError::Truncated:
+            return "Frame too short for checksum verification";
+        case ParseError::Stale:
+            return "Partial frame timed out";
+    }
+    return "Unknown parse error";
+}
 
-        // If we don't have enough data for a header, we're done for now.
-        if (buffer_.size() < 2) {
-            break;
-        }
+static std::string describeCode(const ParseErrorDetail& detail) {
+    if (!detail.captured) {
+        return codeName(detail.code);
+    }
+    std::stringstream ss;
+    switch (detail.code) {
+        case ParseError::None:
+            return "";
+        case ParseError::BadLength:
+            return "Invalid frame length: " + std::to_string(detail.length);
+        case ParseError::BadEndMarker:
+            return "End marker not found at position: " + std::to_string(detail.position);
+        case ParseError::BadChecksum:
+            ss << "Checksum verification failed: "
+               << "calculated=0x" << std::hex << (int)detail.calculated
+               << ", expected=0x" << (int)detail.expected << std::dec;
+            return ss.str();
+        case ParseError::Truncated:
+            ss << "Frame too short for checksum verification (size: " << (int)detail.length << ")";
+            return ss.str();
+        case ParseError::Stale:
+            return "Partial frame timed out after " + std::to_string(detail.length) + " bytes";
+    }
+    return "Unknown parse error";
+}
 
-        // At this point, buffer_[0] is START_BYTE.
+std::string vdp::describeParseError(const ParseErrorDetail& detail) {
+    if (detail.coalesced == 0) {
+        return describeCode(detail);
+    }
+    return describeCode(detail) + " (and " + std::to_string(detail.coalesced) + " more invalid candidates)";
+}
 
-        // 2. Get frame length and validate.
-        uint8_t frame_length = buffer_[1];
-        if (frame_length < MIN_FRAME_LEN || frame_length > MAX_FRAME_LEN) {
-            std::vector<uint8_t> invalid_data(buffer_.begin(), buffer_.begin() + 2);
-            results.push_back({ParseStatus::Invalid, {}, "Invalid frame length: " + std::to_string(frame_length), invalid_data});
-            buffer_.pop_front(); // Discard the bad 0x7E and rescan.
-            continue;
-        }
+// Offset of the first START_BYTE in window at or after from, or window.size if none
+static size_t findStartByte(ByteSpan window, size_t from, uint8_t start_byte) {
+    if (from >= window.size) {
+        return window.size;
+    }
+    return from + kernels::findByte(window.data + from, window.size - from, start_byte);
+}
 
-        // 3. Check if the full frame is in the buffer.
-        if (buffer_.size() < frame_length) {
-            // Not enough data yet. Stop processing and wait for more to arrive.
-            break;
+bool VdpParser::nextResultNoLock(ParseResultView& out) {
+    while (parseNextNoLock(out)) {
+        if (out.status == ParseStatus::Success || invalid_reported_ < invalid_limit_) {
+            invalid_reported_ += out.status != ParseStatus::Success;
+            return true;
         }
+        // Over the limit, resync past the rejection without reporting it
+    }
+    return false;
+}
 
-        // 4. Check for the end marker.
-        if (buffer_[frame_length - 1] != END_BYTE) {
-            std::vector<uint8_t> invalid_data(buffer_.begin(), buffer_.begin() + frame_length);
-            results.push_back({ParseStatus::Invalid, {}, "End marker not found at position: " + std::to_string(frame_length - 1), invalid_data});
-            buffer_.pop_front(); // Discard the bad 0x7E and rescan.
-            continue;
+bool VdpParser::parseNextNoLock(ParseResultView& out) {
+    // 0. A partial frame is waiting at the head: drop it if the bytes that
+    // arrived since came after too long a gap, else wait until it is complete.
+    if (pending_length_ != 0) {
+        if (rejectStaleNoLock(out)) {
+            return true;
         }
-
-        // 5. Extract the frame and verify checksum.
-        std::vector<uint8_t> frame(buffer_.begin(), buffer_.begin() + frame_length);
-        std::string checksumDebug;
-        if (!verifyChecksum(frame, checksumDebug)) {
-            results.push_back({ParseStatus::Invalid, {}, checksumDebug, frame});
-            buffer_.pop_front(); // Discard the bad 0x7E and rescan.
-            continue;
+        if (buffer_.size() < pending_length_) {
+            return false;
         }
+    }
 
-        // 6. Process the valid frame.
-        VdpFrame vdp_frame;
-        vdp_frame.ecu_id = frame[2];
-        vdp_frame.command = frame[3];
-        vdp_frame.data.assign(frame.begin() + 4, frame.end() - 2);
-        results.emplace_back(ParseStatus::Success, vdp_frame, "", frame);
+    // 1. Find the next start byte and discard any garbage before it.
+    // This is the key to resynchronization after an error.
+    ByteSpan window = buffer_.readable();
+    size_t start_byte_pos = findStartByte(window, 0, START_BYTE);
 
-        // 7. Remove the processed frame from the buffer.
-        buffer_.erase(buffer_.begin(), buffer_.begin() + frame_length);
+    if (start_byte_pos > 0) {
+        buffer_.consume(start_byte_pos);
+        window = window.subspan(start_byte_pos);
+        tally_.discard(start_byte_pos);
     }
 
-    checkTimeoutsNoLock();
-    return results;
+    const ParseStatus status = parseCandidate(window, out);
+    out.timestamp = batch_timestamp_;
+    switch (status) {
+        case ParseStatus::Success:
+            // Consuming the frame only advances the read index, so the view
+            // stays backed by the buffer until the next write.
+            buffer_.consume(out.raw_bytes.size);
+            tally_.frame();
+            resetFrameState();
+            return true;
+        case ParseStatus::Invalid:
+            tally_.reject(out.error.code);
+            rejectCandidateNoLock(out);
+            return true;
+        default:
+            if (window.empty()) {
+                return false;
+            }
+            holdCandidateNoLock(window);
+            return false;
+    }
 }
 
-// Constructor
-VdpParser::VdpParser(std::chrono::milliseconds default_timeout)
-    : default_timeout_(default_timeout), frame_started_(false) {
-    // Initialize frame timing state
-    resetFrameState();
+void VdpParser::holdCandidateNoLock(ByteSpan window) {
+    // A valid LEN is known once two bytes are in, an invalid one is rejected right away
+    pending_length_ = window.size < 2 ? 2 : window[1];
+    if (!frame_started_ && batch_timestamp_.valid()) {
+        // Started by the last feed, no clock read needed
+        frame_started_ = true;
+        last_frame_start_ = batch_timestamp_.toSteady();
+    }
 }
 
-// Helper to check if frame is taking too long
-bool VdpParser::isFrameTakingTooLong() const {
-    if (!frame_started_) {
+bool VdpParser::rejectStaleNoLock(ParseResultView& out) {
+    // Measured against the latest feed: a partial frame only goes stale
+    // once bytes arrive after a gap, a quiet line leaves it alone
+    if (!frame_started_ || batch_timestamp_.toSteady() - last_frame_start_ <= frame_timeout_ * 2) {
         return false;
     }
-
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now - last_frame_start_);
-
-    // Consider a frame taking too long if it's been more than 2x the default timeout
-    return elapsed > (default_timeout_ * 2);
+    // The candidate ends at its LEN or at the next START byte, whichever
+    // comes first: everything after that is rescanned and may hold frames
+    const ByteSpan window = buffer_.readable();
+    size_t held = std::min(window.size, pending_length_);
+    held = std::min(held, findStartByte(window.subspan(0, held), 1, START_BYTE));
+    out.status = ParseStatus::Invalid;
+    out.frame = {};
+    out.error = {};
+    out.error.code = ParseError::Stale;
+    out.error.length = static_cast<uint8_t>(std::min(held, MAX_FRAME_LEN));
+    out.raw_bytes = window.subspan(0, held);
+    out.timestamp = batch_timestamp_;
+    tally_.reject(ParseError::Stale);
+    rejectCandidateNoLock(out);
+    return true;
 }
 
-void VdpParser::resetFrameState() {
-    frame_started_ = false;
-    last_frame_start_ = std::chrono::steady_clock::now();
-}
+ParseStatus VdpParser::parseCandidate(ByteSpan window, ParseResultView& out) {
+    // If we don't have enough data for a header, we're done for now.
+    if (window.size < 2) {
+        return ParseStatus::Incomplete;
+    }
 
-// Feed implementation with mutex protection
-void VdpParser::feed(const uint8_t* data, size_t len) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    buffer_.insert(buffer_.end(), data, data + len);
-}
+    // At this point, window[0] is START_BYTE.
+    out.status = ParseStatus::Invalid;
+    out.frame = {};
+    out.error = {};
+    out.raw_bytes = {};
+
+    // 2. Get frame length and validate.
+    uint8_t frame_length = window[1];
+    if (frame_length < MIN_FRAME_LEN || frame_length > MAX_FRAME_LEN) {
+        out.error.code = ParseError::BadLength;
+        out.error.length = frame_length;
+        out.error.position = 1;
+        out.raw_bytes = window.subspan(0, 2);
+        return ParseStatus::Invalid;
+    }
 
-// Reset implementation with mutex protection
-void VdpParser::reset() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    buffer_.clear();
-    resetFrameState();
-}
+    // 3. Check if the full frame is in the buffer.
+    if (window.size < frame_length) {
+        // Not enough data yet. Stop processing and wait for more to arrive.
+        return ParseStatus::Incomplete;
+    }
 
-// Send frame with response handler
-// TODO: Move it upper Layer
-void VdpParser::sendFrame(const VdpFrame& frame, ResponseHandler handler,
-                         std::chrono::milliseconds timeout_ms) {
-    if (timeout_ms == std::chrono::milliseconds(0)) {
-        timeout_ms = default_timeout_;
+    ByteSpan frame = window.subspan(0, frame_length);
+
+    // 4. Check for the end marker.
+    if (frame[frame_length - 1] != END_BYTE) {
+        out.error.code = ParseError::BadEndMarker;
+        out.error.length = frame_length;
+        out.error.position = static_cast<uint8_t>(frame_length - 1);
+        out.raw_bytes = frame;
+        return ParseStatus::Invalid;
     }
 
-    auto now = std::chrono::system_clock::now();
-    auto timeout_time = now + timeout_ms;
+    // 5. Verify checksum in place.
+    if (!verifyChecksum(frame, out.error)) {
+        out.raw_bytes = frame;
+        return ParseStatus::Invalid;
+    }
 
-    // Add sequence number to the frame if needed
-    uint8_t sequence = getNextSequence();
+    // 6. Hand out the valid frame.
+    out.status = ParseStatus::Success;
+    out.frame.ecu_id = frame[2];
+    out.frame.command = frame[3];
+    out.frame.data = frame.subspan(HEADER_SIZE, frame_length - HEADER_SIZE - FOOTER_SIZE);
+    out.raw_bytes = frame;
+    return ParseStatus::Success;
+}
 
-    // Store the pending request
-    PendingRequest request;
-    request.request_frame = frame;
-    request.handler = std::move(handler);
-    request.timeout_time = timeout_time;
-    request.completed = false;
+void VdpParser::rejectCandidateNoLock(ParseResultView& out) {
+    // Consuming only advances the read index, raw_bytes stays readable
+    if (capture_error_details_) {
+        out.error.offset = buffer_.consumedTotal();
+    } else {
+        out.error = ParseErrorDetail{out.error.code};
+        out.error.captured = false;
+        out.raw_bytes = {};
+    }
+    buffer_.consume(1); // Discard the bad 0x7E and rescan.
+    tally_.discard(1);
+    resetFrameState();
 
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        pending_requests_[sequence] = std::move(request);
+    if (coalesce_invalid_) {
+        // raw_bytes keeps the first candidate, consumers rely on it fitting a frame
+        const size_t run = 1 + absorbInvalidRunNoLock(out.error.coalesced);
+        if (capture_error_details_) {
+            out.error.run_length = static_cast<uint32_t>(std::min<size_t>(run, UINT32_MAX));
+        }
     }
+}
 
-    // TODO: Implement actual frame sending logic
-    // sendRawFrame(frame);
+size_t VdpParser::absorbInvalidRunNoLock(uint16_t& coalesced) {
+    size_t consumed = 0;
+    ParseResultView next;
+    while (coalesced < UINT16_MAX) {
+        const ByteSpan window = buffer_.readable();
+        const size_t start = findStartByte(window, 0, START_BYTE);
+        if (start == window.size || parseCandidate(window.subspan(start), next) != ParseStatus::Invalid) {
+            // The garbage up to a frame, a partial candidate or the end belongs to the run
+            buffer_.consume(start);
+            tally_.discard(start);
+            return consumed + start;
+        }
+        tally_.reject(next.error.code);
+        buffer_.consume(start + 1);
+        tally_.discard(start + 1);
+        consumed += start + 1;
+        ++coalesced;
+    }
+    return consumed;
 }
 
-// Send and wait for response
-// TODO: Move it upper Layer
-ParseResult VdpParser::sendAndWait(const VdpFrame& frame,
-                                  std::chrono::milliseconds timeout_ms) {
-    std::mutex mtx;
-    std::condition_variable cv;
-    ParseResult result;
-    bool response_received = false;
+std::vector<ParseResult> VdpParser::extractFrames() {
+    auto lock = consumerLock();
+    drainFeedRingNoLock();
+    std::vector<ParseResult> results;
 
-    auto handler = [&](const ParseResult& res) {
-        std::unique_lock<std::mutex> lock(mtx);
-        result = res;
-        response_received = true;
-        cv.notify_one();
-    };
+    ParseResultView view;
+    while (nextResultNoLock(view)) {
+        results.push_back(view.toResult());
+    }
+    publishMetricsNoLock();
 
-    sendFrame(frame, handler, timeout_ms);
+    return results;
+}
 
-    std::unique_lock<std::mutex> lock(mtx);
-    if (cv.wait_for(lock, timeout_ms, [&] { return response_received; })) {
-        return result;
-    } else {
-        return {ParseStatus::Timeout, std::nullopt, "Response timeout", {}};
+size_t VdpParser::extractFrames(ParseBatch& out) {
+    auto lock = consumerLock();
+    drainFeedRingNoLock();
+    out.clear();
+
+    ParseResultView view;
+    while (nextResultNoLock(view)) {
+        out.append(view);
     }
+    publishMetricsNoLock();
+
+    return out.size();
 }
 
-// Process received frame and match with pending requests
-void VdpParser::processReceivedFrame(const VdpFrame& frame) {
-    // Handle ACK/NAK frames first
-    if (frame.command == static_cast<uint8_t>(CommandType::Acknowledge)) {
-        handleAckNak(frame, true);
-        return;
-    } else if (frame.command == static_cast<uint8_t>(CommandType::NegativeAck)) {
-        handleAckNak(frame, false);
-        return;
+size_t VdpParser::extractFrames(InlineParseResult* out, size_t capacity) {
+    auto lock = consumerLock();
+    drainFeedRingNoLock();
+
+    size_t count = 0;
+    ParseResultView view;
+    while (count < capacity && nextResultNoLock(view)) {
+        InlineParseResult& result = out[count++];
+        result.status = view.status;
+        result.error = view.error;
+        result.timestamp = view.timestamp;
+        // Fill in place, only the DATA bytes in use are copied
+        result.frame.ecu_id = view.frame.ecu_id;
+        result.frame.command = view.frame.command;
+        result.frame.assign(view.frame.data);
     }
+    publishMetricsNoLock();
 
-    // Check if this is a response frame (ECU_ID has 0x80 bit set)
-    bool is_response = (frame.ecu_id & RESPONSE_ECU_ID_MASK) != 0;
+    return count;
+}
 
-    // For response frames, validate status code
-    if (is_response && !frame.data.empty()) {
-        uint8_t status = frame.data[0];
+void VdpParser::setErrorDetailCapture(bool enabled) {
+    auto lock = consumerLock();
+    capture_error_details_ = enabled;
+}
 
-        // Special handling for invalid status codes
-        if (status == 0x00 || status == 0x80) {
-            // Create and send NAK for invalid status code
-            VdpFrame nak_frame;
-            nak_frame.ecu_id = frame.ecu_id & ~RESPONSE_ECU_ID_MASK; // Clear response bit
-            nak_frame.command = static_cast<uint8_t>(CommandType::NegativeAck);
-            nak_frame.data.push_back(frame.command);
-            nak_frame.data.push_back(static_cast<uint8_t>(ResponseStatus::InvalidStatus));
+void VdpParser::setInvalidCoalescing(bool enabled) {
+    auto lock = consumerLock();
+    coalesce_invalid_ = enabled;
+}
 
-            std::vector<uint8_t> nak_bytes;
-            serializeFrame(nak_frame, nak_bytes);
-            if (send_callback_) {
-                send_callback_(nak_bytes.data(), nak_bytes.size());
-            }
-            return;
-        }
+void VdpParser::setInvalidResultLimit(size_t max_per_call) {
+    auto lock = consumerLock();
+    invalid_limit_ = max_per_call;
+}
+
+void VdpParser::setTimestampCapture(bool enabled) {
+    capture_timestamps_.store(enabled, std::memory_order_relaxed);
+    if (!enabled) {
+        last_feed_ticks_.store(0, std::memory_order_relaxed);
     }
+}
 
-    // Validate the command
-    if (!isValidCommand(frame.command)) {
-        // Create and send NAK for invalid command
-        VdpFrame nak_frame;
-        nak_frame.ecu_id = frame.ecu_id & ~RESPONSE_ECU_ID_MASK; // Clear response bit if set
-        nak_frame.command = static_cast<uint8_t>(CommandType::NegativeAck);
-        nak_frame.data.push_back(frame.command); // Include the invalid command
-        nak_frame.data.push_back(static_cast<uint8_t>(ResponseStatus::InvalidCommand));
+ParserMetricsSnapshot VdpParser::metrics() const {
+    ParserMetricsSnapshot out;
+    out.bytes_fed = metrics_.bytes_fed.value();
+    out.bytes_discarded = metrics_.bytes_discarded.value();
+    out.frames = metrics_.frames.value();
+    for (size_t i = 0; i < PARSE_ERROR_COUNT; ++i) {
+        out.invalid[i] = metrics_.invalid[i].value();
+    }
+    out.feed_to_frame_ns = metrics_.feed_to_frame_ns.snapshot();
+    return out;
+}
 
-        std::vector<uint8_t> nak_bytes;
-        serializeFrame(nak_frame, nak_bytes);
-        if (send_callback_) {
-            send_callback_(nak_bytes.data(), nak_bytes.size());
-        }
+void VdpParser::publishMetricsNoLock() {
+    if constexpr (!metrics::ENABLED) {
         return;
     }
-
-    // Try to find a matching request
-    auto it = findMatchingRequest(frame);
-    if (it != pending_requests_.end()) {
-        // Found a matching request, call its handler
-        ParseResult result{ParseStatus::Success, frame, "", {}};
-        it->second.handler(result);
-        it->second.completed = true;
-        pending_requests_.erase(it);
-    } else {
-        // Handle unsolicited frames (no matching request)
-        // TODO: Add handling for unsolicited frames if needed
-        if (frame.command != static_cast<uint8_t>(CommandType::KeepAlive)) {
-            // Log or handle unexpected frame (except keep-alive which is always unsolicited)
+    // Nothing is rejected without discarding its START byte
+    if (tally_.frames == 0 && tally_.bytes_discarded == 0) {
+        return;
+    }
+    if (tally_.frames != 0) {
+        metrics_.frames.add(tally_.frames);
+        if (batch_timestamp_.valid()) {
+            // One clock read per call, every frame of it gets the same sample
+            const int64_t latency = RxTimestamp::now().ticks - batch_timestamp_.ticks;
+            metrics_.feed_to_frame_ns.record(static_cast<uint64_t>(std::max<int64_t>(latency, 0)), tally_.frames);
         }
     }
-}
-
-// Helper to get status string from status code
-static std::string getStatusString(uint8_t status_code) {
-    switch (static_cast<ResponseStatus>(status_code)) {
-        case ResponseStatus::Success: return "Success";
-        case ResponseStatus::InvalidCommand: return "Invalid Command";
-        case ResponseStatus::InvalidData: return "Invalid Data";
-        case ResponseStatus::EcuBusy: return "ECU Busy";
-        case ResponseStatus::GeneralError: return "General Error";
-        case ResponseStatus::InvalidStatus: return "Invalid Status";
-        default: return "Unknown Status";
+    metrics_.bytes_discarded.add(tally_.bytes_discarded);
+    for (size_t i = 0; i < PARSE_ERROR_COUNT; ++i) {
+        if (tally_.invalid[i] != 0) {
+            metrics_.invalid[i].add(tally_.invalid[i]);
+        }
     }
+    tally_ = Tally{};
 }
 
-// Validate response frame and extract status
-static bool validateResponseFrame(const VdpFrame& frame, uint8_t& out_status) {
-    // Check if this is a response frame (ECU_ID has 0x80 bit set)
-    if ((frame.ecu_id & RESPONSE_ECU_ID_MASK) == 0) {
-        return false; // Not a response frame
+// Constructor
+VdpParser::VdpParser(std::chrono::milliseconds frame_timeout, ConcurrencyMode mode)
+    : frame_timeout_(frame_timeout), frame_started_(false) {
+    if (mode == ConcurrencyMode::Spsc) {
+        feed_ring_ = std::make_unique<SpscByteRing>(FEED_RING_CAPACITY);
     }
+    // Initialize frame timing state
+    resetFrameState();
+}
 
-    // Response must have at least one data byte for status
-    if (frame.data.empty()) {
+// Helper to check if frame is taking too long
+bool VdpParser::isFrameTakingTooLong() const {
+    if (!frame_started_) {
         return false;
     }
 
-    out_status = frame.data[0];
-    return true;
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now - last_frame_start_);
+
+    // Consider a frame taking too long if it's been more than 2x the frame timeout
+    return elapsed > (frame_timeout_ * 2);
 }
 
-// Handle ACK/NAK frames
-void VdpParser::handleAckNak(const VdpFrame& frame, bool is_ack) {
-    if (frame.data.empty()) {
-        // Invalid ACK/NAK - no sequence number
-        return;
+// Runs after every result, so it leaves the clock alone: last_frame_start_ only counts while frame_started_
+void VdpParser::resetFrameState() {
+    pending_length_ = 0;
+    frame_started_ = false;
+}
+
+void VdpParser::feed(const uint8_t* data, size_t len) {
+    feed(data, len, capture_timestamps_.load(std::memory_order_relaxed) ? RxTimestamp::now() : RxTimestamp{});
+}
+
+void VdpParser::stampFeed(RxTimestamp received) {
+    if (capture_timestamps_.load(std::memory_order_relaxed)) {
+        // Relaxed: in Spsc mode the ring publishes the bytes, a stamp off by one batch is harmless
+        last_feed_ticks_.store(received.ticks, std::memory_order_relaxed);
     }
+}
 
-    uint8_t sequence = frame.data[0];
-    auto it = pending_requests_.find(sequence);
-    if (it != pending_requests_.end()) {
-        ParseResult result;
-        if (is_ack) {
-            if (frame.data.size() > 1) {
-                // Check for special status codes in ACK
-                uint8_t status = frame.data[1];
-                if (status == static_cast<uint8_t>(ResponseStatus::InvalidStatus) ||
-                    status == 0x00) {
-                    // Treat as error
-                    result = {
-                        ParseStatus::Error,
-                        frame,
-                        "ACK with invalid status code: 0x" + to_hex(status),
-                        {}
-                    };
-                } else {
-                    result = {ParseStatus::Success, frame, "ACK received", {}};
-                }
-            } else {
-                result = {ParseStatus::Success, frame, "ACK received", {}};
-            }
-        } else {
-            // NAK handling
-            std::string error = "NAK received";
-            if (frame.data.size() > 1) {
-                uint8_t error_code = frame.data[1];
-                error += ": " + getStatusString(error_code) + " (0x" + to_hex(error_code) + ")";
-
-                // Special handling for 0x00 and 0x80
-                if (error_code == 0x00 || error_code == 0x80) {
-                    error += " - Invalid status code";
-                }
-            }
-            result = {ParseStatus::Nack, frame, error, {}};
+void VdpParser::writeFeedRing(const uint8_t* data, size_t len) {
+    // Lock-free path: publish into the ring, back off while the consumer catches up
+    while (len > 0) {
+        size_t written = feed_ring_->write(data, len);
+        data += written;
+        len -= written;
+        if (len > 0) {
+            std::this_thread::yield();
         }
-        it->second.handler(result);
-        it->second.completed = true;
-        pending_requests_.erase(it);
     }
 }
 
-// Generate a new sequence number
-uint8_t VdpParser::getNextSequence() {
-    // Simple incrementing sequence number (wraps around at 255)
-    return ++last_sequence_;
+// Feed implementation with mutex protection
+void VdpParser::feed(const uint8_t* data, size_t len, RxTimestamp received) {
+    stampFeed(received);
+    if (feed_ring_) {
+        metrics_.bytes_fed.add(len);
+        writeFeedRing(data, len);
+        return;
+    }
+
+    std::lock_guard<std::mutex> write_lock(write_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    metrics_.bytes_fed.add(len);
+    buffer_.write(data, len);
 }
 
-// Find a pending request that matches the response frame
-std::map<uint8_t, PendingRequest>::iterator VdpParser::findMatchingRequest(const VdpFrame& response_frame) {
-    // Simple implementation: match by command type and ECU ID
-    // You might want to implement more sophisticated matching logic
-    for (auto it = pending_requests_.begin(); it != pending_requests_.end(); ++it) {
-        const auto& request = it->second;
-        if (!request.completed &&
-            request.request_frame.command == response_frame.command &&
-            request.request_frame.ecu_id == response_frame.ecu_id) {
-            return it;
+VdpParser::WriteLease VdpParser::prepareWrite(size_t n) {
+    WriteLease lease;
+    lease.parser_ = this;
+    lease.size_ = n;
+    if (feed_ring_) {
+        lease.data_ = feed_ring_->prepareWrite(n);
+        if (!lease.data_) {
+            // Wrap point or full ring: receive into staging, commit() copies it over
+            staging_.resize(std::max<size_t>(n, 1));
+            lease.data_ = staging_.data();
+            lease.staged_ = true;
         }
+        return lease;
     }
-    return pending_requests_.end();
-}
 
-// Check for and handle timeouts
-void VdpParser::checkTimeouts() {
+    // Held until the lease ends; the consumer only waits for the bookkeeping here
+    lease.lock_ = std::unique_lock<std::mutex>(write_mutex_);
     std::lock_guard<std::mutex> lock(mutex_);
-    checkTimeoutsNoLock();
+    lease.data_ = buffer_.prepareWrite(n);
+    return lease;
 }
 
-void VdpParser::checkTimeoutsNoLock() {
-    auto now = std::chrono::system_clock::now();
+VdpParser::WriteLease::WriteLease(WriteLease&& other) noexcept
+    : parser_(std::exchange(other.parser_, nullptr)),
+      lock_(std::move(other.lock_)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      staged_(std::exchange(other.staged_, false)) {}
+
+VdpParser::WriteLease& VdpParser::WriteLease::operator=(WriteLease&& other) noexcept {
+    if (this != &other) {
+        release();
+        parser_ = std::exchange(other.parser_, nullptr);
+        lock_ = std::move(other.lock_);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        staged_ = std::exchange(other.staged_, false);
+    }
+    return *this;
+}
 
-    for (auto it = pending_requests_.begin(); it != pending_requests_.end(); ) {
-        if (!it->second.completed && now > it->second.timeout_time) {
-            // Request timed out
-            ParseResult result{ParseStatus::Timeout, std::nullopt, "Request timed out", {}};
-            it->second.handler(result);
-            it->second.completed = true; // Mark as completed to avoid double handling
-            it = pending_requests_.erase(it);
+void VdpParser::WriteLease::commit(size_t len) {
+    if (parser_) {
+        commit(len, parser_->capture_timestamps_.load(std::memory_order_relaxed) ? RxTimestamp::now()
+                                                                                  : RxTimestamp{});
+    }
+}
+
+void VdpParser::WriteLease::commit(size_t len, RxTimestamp received) {
+    VdpParser* parser = std::exchange(parser_, nullptr);
+    if (!parser) {
+        return;
+    }
+    parser->stampFeed(received);
+    parser->metrics_.bytes_fed.add(len);
+    if (parser->feed_ring_) {
+        if (staged_) {
+            parser->writeFeedRing(data_, len);
         } else {
-            ++it;
+            parser->feed_ring_->commitWrite(len);
         }
+    } else {
+        std::lock_guard<std::mutex> lock(parser->mutex_);
+        parser->buffer_.commitWrite(len);
     }
+    release();
 }
 
-// Set default timeout for all requests
-void VdpParser::setDefaultTimeout(std::chrono::milliseconds timeout) {
-    default_timeout_ = timeout;
+void VdpParser::WriteLease::release() {
+    if (parser_ && !parser_->feed_ring_) {
+        std::lock_guard<std::mutex> lock(parser_->mutex_);
+        parser_->buffer_.cancelWrite();
+    }
+    parser_ = nullptr;
+    data_ = nullptr;
+    size_ = 0;
+    staged_ = false;
+    if (lock_.owns_lock()) {
+        lock_.unlock();
+    }
+}
+
+void VdpParser::drainFeedRingNoLock() {
+    // One load per extract call, so the per-result loop does not touch an atomic
+    batch_timestamp_ = RxTimestamp{last_feed_ticks_.load(std::memory_order_relaxed)};
+    invalid_reported_ = 0;
+    if (!feed_ring_) {
+        return;
+    }
+    ByteSpan first, second;
+    size_t available = feed_ring_->readable(first, second);
+    buffer_.write(first.data, first.size);
+    buffer_.write(second.data, second.size);
+    feed_ring_->release(available);
+}
+
+// Reset implementation with mutex protection
+void VdpParser::reset() {
+    auto lock = consumerLock();
+    if (feed_ring_) {
+        // Discard whatever the producer has published so far
+        ByteSpan first, second;
+        feed_ring_->release(feed_ring_->readable(first, second));
+    }
+    buffer_.clear();
+    resetFrameState();
 }
 
 // Find the next start byte in the buffer
 size_t VdpParser::findNextStartByte() const {
-    if (buffer_.empty()) {
+    ByteSpan window = buffer_.readable();
+    if (window.empty()) {
         return std::string::npos;
     }
     
     // Start from the second byte since we know the first one is not a start byte
-    for (size_t i = 1; i < buffer_.size(); ++i) {
-        if (buffer_[i] == START_BYTE) {
-            return i;
-        }
-    }
+    size_t pos = findStartByte(window, 1, START_BYTE);
     
     // No start byte found
-    return std::string::npos;
+    return pos < window.size ? pos : std::string::npos;
 }
 
 // Create ACK frame
@@ -0,0 +1,101 @@
+//
+// Byte kernel tests: every SIMD kernel must match the scalar reference
+//
+#include "catch2/catch_all.hpp"
+#include "byte_kernels.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace vdp;
+
+static vector<uint8_t> randomBytes(size_t len, uint32_t seed) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> dist(0, 255);
+    vector<uint8_t> bytes(len);
+    for (auto& b : bytes) {
+        b = static_cast<uint8_t>(dist(rng));
+        if (b == 0x7E) {
+            b = 0x00; // Keep the needle out unless a test places it
+        }
+    }
+    return bytes;
+}
+
+TEST_CASE("Scalar kernel is always available and listed first") {
+    auto sets = kernels::availableKernels();
+    REQUIRE(!sets.empty());
+    REQUIRE(string(sets.front().name) == "scalar");
+    REQUIRE(kernels::activeKernels().find_byte != nullptr);
+    REQUIRE(kernels::activeKernels().xor_reduce != nullptr);
+}
+
+TEST_CASE("findByte kernels match scalar for every length, offset and position") {
+    auto sets = kernels::availableKernels();
+    const auto& scalar = sets.front();
+    auto buffer = randomBytes(320, 1);
+
+    for (const auto& set : sets) {
+        INFO("kernel set: " << set.name);
+        for (size_t offset = 0; offset < 4; ++offset) {
+            for (size_t len = 0; len <= 300; ++len) {
+                const uint8_t* data = buffer.data() + offset;
+                // Needle absent
+                REQUIRE(set.find_byte(data, len, 0x7E) == len);
+
+                // Needle at a few positions, including both ends and a second match
+                for (size_t pos : {size_t(0), len / 2, len ? len - 1 : 0}) {
+                    if (pos >= len) {
+                        continue;
+                    }
+                    auto copy = buffer;
+                    copy[offset + pos] = 0x7E;
+                    if (pos + 17 < len) {
+                        copy[offset + pos + 17] = 0x7E;
+                    }
+                    const uint8_t* cdata = copy.data() + offset;
+                    REQUIRE(set.find_byte(cdata, len, 0x7E) == scalar.find_byte(cdata, len, 0x7E));
+                    REQUIRE(set.find_byte(cdata, len, 0x7E) == pos);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("xorReduce kernels match scalar for every length and offset") {
+    auto sets = kernels::availableKernels();
+    const auto& scalar = sets.front();
+    auto buffer = randomBytes(320, 2);
+
+    for (const auto& set : sets) {
+        INFO("kernel set: " << set.name);
+        for (size_t offset = 0; offset < 4; ++offset) {
+            for (size_t len = 0; len <= 300; ++len) {
+                const uint8_t* data = buffer.data() + offset;
+                REQUIRE(set.xor_reduce(data, len) == scalar.xor_reduce(data, len));
+            }
+        }
+    }
+}
+
+TEST_CASE("copyXor kernels copy exactly len bytes and match xorReduce") {
+    auto sets = kernels::availableKernels();
+    const auto& scalar = sets.front();
+    auto buffer = randomBytes(320, 3);
+
+    for (const auto& set : sets) {
+        INFO("kernel set: " << set.name);
+        for (size_t offset = 0; offset < 4; ++offset) {
+            for (size_t len = 0; len <= 300; ++len) {
+                const uint8_t* src = buffer.data() + offset;
+                vector<uint8_t> dst(len + 8, 0xAA);
+                REQUIRE(set.copy_xor(dst.data() + 4, src, len) == scalar.xor_reduce(src, len));
+                REQUIRE(equal(src, src + len, dst.begin() + 4));
+                // Guard bytes on both sides stay untouched
+                REQUIRE(dst[3] == 0xAA);
+                REQUIRE(dst[len + 4] == 0xAA);
+            }
+        }
+    }
+}
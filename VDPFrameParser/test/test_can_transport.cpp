@@ -0,0 +1,122 @@
+//
+// VDP over CAN: segmentation, per-ECU reassembly and the SocketCAN transport
+//
+#include "catch2/catch_all.hpp"
+#include "can_transport.h"
+#include "vdp_parser.h"
+#include "test_frames.h"
+
+using namespace std;
+using namespace vdp;
+using namespace vdp::transport;
+
+static vector<vector<uint8_t>> segment(const vector<uint8_t>& frame, size_t max_payload) {
+    vector<vector<uint8_t>> payloads;
+    const IoSlice slice{frame.data(), frame.size()};
+    segmentForCan(&slice, 1, max_payload, [&](const uint8_t* data, size_t length) {
+        payloads.emplace_back(data, data + length);
+    });
+    return payloads;
+}
+
+TEST_CASE("Frames are split into CAN payloads") {
+    SECTION("Classic CAN uses 8-byte payloads, the last one unpadded") {
+        auto frame = encodeFrame(0x01, 0x20, vector<uint8_t>(14, 0xAB));  // 20 bytes
+        auto payloads = segment(frame, CanTransport::CLASSIC_PAYLOAD);
+        REQUIRE(payloads.size() == 3);
+        REQUIRE(payloads[0].size() == 8);
+        REQUIRE(payloads[2].size() == 4);
+    }
+
+    SECTION("CAN-FD pads the last payload to a valid length") {
+        auto frame = encodeFrame(0x01, 0x20, vector<uint8_t>(247, 0x11));  // 253 bytes
+        auto payloads = segment(frame, CanTransport::FD_PAYLOAD);
+        REQUIRE(payloads.size() == 4);
+        REQUIRE(payloads[3].size() == 64);   // 61 bytes padded
+        REQUIRE(payloads[3][61] == CAN_PADDING_BYTE);
+
+        auto small = segment(encodeFrame(0x01, 0x10, {0x01, 0x02, 0x03, 0x04}), CanTransport::FD_PAYLOAD);
+        REQUIRE(small.size() == 1);
+        REQUIRE(small[0].size() == 12);      // 10 bytes padded
+    }
+
+    SECTION("Slices are gathered in order") {
+        auto frame = encodeFrame(0x05, 0x10, {0x01, 0x02, 0x03});
+        const IoSlice slices[] = {{frame.data(), 4}, {frame.data() + 4, 3}, {frame.data() + 7, 2}};
+        vector<uint8_t> joined;
+        segmentForCan(slices, 3, 8, [&](const uint8_t* data, size_t length) {
+            joined.insert(joined.end(), data, data + length);
+        });
+        REQUIRE(joined == frame);
+    }
+}
+
+TEST_CASE("CanReassembler delivers whole frames per ECU") {
+    auto reassembler = make_unique<CanReassembler>();
+    vector<vector<uint8_t>> delivered;
+    auto deliver = [&](const uint8_t* data, size_t length) { delivered.emplace_back(data, data + length); };
+
+    SECTION("Interleaved responses from two ECUs are kept apart") {
+        auto a = encodeFrame(0x81, 0x10, vector<uint8_t>(20, 0xAA));
+        auto b = encodeFrame(0x82, 0x10, vector<uint8_t>(12, 0xBB));
+        auto pa = segment(a, 8), pb = segment(b, 8);
+        for (size_t i = 0; i < max(pa.size(), pb.size()); ++i) {
+            if (i < pa.size()) reassembler->push(0x81, pa[i].data(), pa[i].size(), deliver);
+            if (i < pb.size()) reassembler->push(0x82, pb[i].data(), pb[i].size(), deliver);
+        }
+        REQUIRE(delivered == vector<vector<uint8_t>>{b, a});
+        REQUIRE(reassembler->pending(0x81) == 0);
+
+        // The frames parse as if they had arrived on a byte stream
+        VdpParser parser;
+        for (const auto& frame : delivered) {
+            parser.feed(frame.data(), frame.size());
+        }
+        auto results = parser.extractFrames();
+        REQUIRE(results.size() == 2);
+        REQUIRE(results[0].status == ParseStatus::Success);
+        REQUIRE(results[1].status == ParseStatus::Success);
+    }
+
+    SECTION("Padding after a CAN-FD frame is passed through for the parser to skip") {
+        auto frame = encodeFrame(0x81, 0x10, {0x00, 0x01, 0x02, 0x03});
+        auto payloads = segment(frame, 64);
+        reassembler->push(0x81, payloads[0].data(), payloads[0].size(), deliver);
+        REQUIRE(delivered.size() == 2);
+        REQUIRE(delivered[0] == frame);
+        REQUIRE(delivered[1] == vector<uint8_t>(2, CAN_PADDING_BYTE));
+    }
+
+    SECTION("A frame whose start was lost passes through, the next one reassembles") {
+        auto lost = encodeFrame(0x81, 0x10, vector<uint8_t>(10, 0x01));
+        auto payloads = segment(lost, 8);
+        reassembler->push(0x81, payloads[1].data(), payloads[1].size(), deliver);
+        REQUIRE(delivered.size() == 1);
+        REQUIRE(reassembler->pending(0x81) == 0);
+
+        auto next = encodeFrame(0x81, 0x10, {0x00});
+        reassembler->push(0x81, next.data(), next.size(), deliver);
+        REQUIRE(delivered.back() == next);
+    }
+
+    SECTION("An impossible LEN is handed to the parser right away") {
+        const uint8_t bad[] = {0x7E, 0x02};
+        reassembler->push(0x81, bad, sizeof(bad), deliver);
+        REQUIRE(delivered == vector<vector<uint8_t>>{{0x7E, 0x02}});
+        REQUIRE(reassembler->pending(0x81) == 0);
+    }
+}
+
+TEST_CASE("CanTransport reports a missing interface") {
+    CanConfig config;
+    config.fd = true;
+    config.ecu_filter = {0x01, 0x02};
+    CanTransport transport(config);
+    REQUIRE(transport.config().ecu_filter.size() == 2);
+    REQUIRE_FALSE(transport.initialize("vdpcan-missing0"));
+    REQUIRE_FALSE(transport.getLastError().empty());
+    REQUIRE_FALSE(transport.isConnected());
+
+    auto created = TransportFactory::create(TransportFactory::Type::CAN);
+    REQUIRE(dynamic_cast<CanTransport*>(created.get()) != nullptr);
+}
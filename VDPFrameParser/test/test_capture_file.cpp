@@ -0,0 +1,100 @@
+//
+// Capture file tests: hex decoding, binary capture header and mapped files
+//
+#include "catch2/catch_all.hpp"
+#include "capture_file.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace std;
+using namespace vdp;
+
+static ByteSpan spanOf(const string& text) {
+    return {reinterpret_cast<const uint8_t*>(text.data()), text.size()};
+}
+
+static string tempPath(const char* name) {
+    return string("vdp_capture_test_") + name;
+}
+
+static void writeFile(const string& path, const string& contents) {
+    ofstream out(path, ios::binary);
+    out << contents;
+}
+
+TEST_CASE("decodeHex follows the line-by-line rules") {
+    vector<uint8_t> out;
+
+    SECTION("Separators and case are ignored") {
+        REQUIRE(decodeHex(spanOf("aa 0b:Cd\tEF\n10"), out) == 5);
+        REQUIRE(out == vector<uint8_t>{0xAA, 0x0B, 0xCD, 0xEF, 0x10});
+    }
+
+    SECTION("Comments run to the end of the line") {
+        REQUIRE(decodeHex(spanOf("# header 12 34\n01 02 # 03 04\n05 # trailing"), out) == 3);
+        REQUIRE(out == vector<uint8_t>{0x01, 0x02, 0x05});
+    }
+
+    SECTION("A stray nibble is dropped at the end of its line") {
+        REQUIRE(decodeHex(spanOf("01 2\n34\n5"), out) == 2);
+        REQUIRE(out == vector<uint8_t>{0x01, 0x34});
+    }
+
+    SECTION("Bytes are appended") {
+        out = {0xFF};
+        REQUIRE(decodeHex(spanOf("00"), out) == 1);
+        REQUIRE(out == vector<uint8_t>{0xFF, 0x00});
+    }
+}
+
+TEST_CASE("Capture header round trip") {
+    vector<uint8_t> file = makeCaptureHeader();
+    REQUIRE(file.size() == CaptureHeader::SIZE);
+    file.push_back(0x10);
+    file.push_back(0x20);
+
+    ByteSpan payload;
+    REQUIRE(parseCaptureHeader({file.data(), file.size()}, payload));
+    REQUIRE(payload.size == 2);
+    REQUIRE(payload[0] == 0x10);
+
+    SECTION("Other versions are rejected") {
+        file[8] = CaptureHeader::VERSION + 1;
+        REQUIRE_FALSE(parseCaptureHeader({file.data(), file.size()}, payload));
+    }
+
+    SECTION("Text is not a capture") {
+        REQUIRE_FALSE(parseCaptureHeader(spanOf("VDPCAP 01 02 03 04 05 06 07 08"), payload));
+        REQUIRE_FALSE(parseCaptureHeader(spanOf("VDP"), payload));
+    }
+}
+
+TEST_CASE("MappedFile exposes the whole file") {
+    MappedFile file;
+    string error;
+
+    SECTION("Regular file") {
+        const string path = tempPath("regular");
+        writeFile(path, "07 01 02 03");
+        REQUIRE(file.open(path, error));
+        REQUIRE(string(reinterpret_cast<const char*>(file.bytes().data), file.bytes().size) == "07 01 02 03");
+        file.close();
+        REQUIRE(file.bytes().size == 0);
+        remove(path.c_str());
+    }
+
+    SECTION("Empty file") {
+        const string path = tempPath("empty");
+        writeFile(path, "");
+        REQUIRE(file.open(path, error));
+        REQUIRE(file.bytes().size == 0);
+        remove(path.c_str());
+    }
+
+    SECTION("Missing file") {
+        REQUIRE_FALSE(file.open(tempPath("missing"), error));
+        REQUIRE_FALSE(error.empty());
+    }
+}
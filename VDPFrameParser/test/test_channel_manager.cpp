@@ -0,0 +1,186 @@
+//
+// ChannelManager tests: sharded parsing, response tagging and work stealing
+//
+#include "catch2/catch_all.hpp"
+#include "channel_manager.h"
+#include "test_frames.h"
+
+#include <map>
+
+using namespace std;
+using namespace vdp;
+
+static void feedAll(ChannelManager& manager, uint32_t channel, const vector<uint8_t>& bytes) {
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+        offset += manager.feed(channel, bytes.data() + offset, bytes.size() - offset);
+    }
+}
+
+// Poll until count results arrived or two seconds passed
+static vector<ChannelResult> collect(ChannelManager& manager, size_t count) {
+    vector<ChannelResult> results;
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(2);
+    while (results.size() < count && chrono::steady_clock::now() < deadline) {
+        if (manager.poll([&](const ChannelResult& result) { results.push_back(result); }) == 0) {
+            this_thread::yield();
+        }
+    }
+    return results;
+}
+
+TEST_CASE("ChannelManager parses every channel in order") {
+    ChannelManagerConfig config;
+    config.shards = 3;
+    config.pin_threads = false;
+    ChannelManager manager(8, config);
+    REQUIRE(manager.shardCount() == 3);
+    REQUIRE(manager.shardOf(4) == 1);
+
+    for (uint32_t channel = 0; channel < 8; ++channel) {
+        vector<uint8_t> stream;
+        for (uint8_t i = 0; i < 20; ++i) {
+            auto frame = encodeFrame(0x81, 0x10, {0x00, static_cast<uint8_t>(channel), i});
+            stream.insert(stream.end(), frame.begin(), frame.end());
+        }
+        stream.insert(stream.end(), {0x7E, 0x02});   // BadLength, the results keep flowing
+        feedAll(manager, channel, stream);
+    }
+
+    auto results = collect(manager, 8 * 21);
+    REQUIRE(results.size() == 8 * 21);
+    map<uint32_t, vector<ChannelResult>> by_channel;
+    for (const auto& result : results) {
+        by_channel[result.channel].push_back(result);
+    }
+    for (uint32_t channel = 0; channel < 8; ++channel) {
+        const auto& list = by_channel[channel];
+        REQUIRE(list.size() == 21);
+        for (uint8_t i = 0; i < 20; ++i) {
+            REQUIRE(list[i].result.status == ParseStatus::Success);
+            REQUIRE(list[i].result.frame.payload[1] == channel);
+            REQUIRE(list[i].result.frame.payload[2] == i);
+            REQUIRE(list[i].tag == ChannelResult::NO_TAG);
+        }
+        REQUIRE(list[20].result.error.code == ParseError::BadLength);
+    }
+}
+
+TEST_CASE("ChannelManager tags expected responses") {
+    ChannelManagerConfig config;
+    config.shards = 2;
+    config.pin_threads = false;
+    ChannelManager manager(2, config);
+
+    REQUIRE(manager.expect(1, 0x01, 0x10, 7));
+    REQUIRE(manager.expect(1, 0x02, 0x20, 8));
+    vector<uint8_t> stream = encodeFrame(0x81, 0x10, {0x00});                   // answers tag 7
+    auto nak = encodeFrame(0x02, 0x15, {0x20, 0x01});                            // NAK for tag 8
+    auto unsolicited = encodeFrame(0x81, 0x10, {0x00});
+    stream.insert(stream.end(), nak.begin(), nak.end());
+    stream.insert(stream.end(), unsolicited.begin(), unsolicited.end());
+    feedAll(manager, 1, stream);
+
+    auto results = collect(manager, 3);
+    REQUIRE(results.size() == 3);
+    REQUIRE(results[0].tag == 7);
+    REQUIRE(results[1].tag == 8);
+    REQUIRE(results[2].tag == ChannelResult::NO_TAG);
+}
+
+TEST_CASE("ChannelManager drops expectations that are never answered") {
+    ChannelManagerConfig config;
+    config.shards = 1;
+    config.pin_threads = false;
+    config.expectation_timeout = chrono::milliseconds(20);
+    ChannelManager manager(1, config);
+
+    REQUIRE(manager.expect(0, 0x01, 0x10, 7));
+    REQUIRE(manager.expect(0, 0x01, 0x20, 8));
+    this_thread::sleep_for(chrono::milliseconds(100));
+
+    // Both expired before their frames came in, so neither is tagged
+    vector<uint8_t> stream = encodeFrame(0x81, 0x10, {0x00});
+    auto nak = encodeFrame(0x02, 0x15, {0x20, 0x01});
+    stream.insert(stream.end(), nak.begin(), nak.end());
+    feedAll(manager, 0, stream);
+
+    auto results = collect(manager, 2);
+    REQUIRE(results.size() == 2);
+    REQUIRE(results[0].tag == ChannelResult::NO_TAG);
+    REQUIRE(results[1].tag == ChannelResult::NO_TAG);
+    REQUIRE(manager.droppedExpectations() == 2);
+}
+
+TEST_CASE("ChannelManager wakes sleeping shards for new bytes") {
+    ChannelManagerConfig config;
+    config.shards = 2;
+    config.pin_threads = false;
+    ChannelManager manager(2, config);
+
+    auto frame = encodeFrame(0x81, 0x10, {0x00});
+    for (uint32_t round = 0; round < 20; ++round) {
+        // Long enough for both workers to stop spinning and wait
+        this_thread::sleep_for(chrono::milliseconds(5));
+        feedAll(manager, round % 2, frame);
+        auto results = collect(manager, 1);
+        REQUIRE(results.size() == 1);
+        REQUIRE(results[0].channel == round % 2);
+    }
+}
+
+TEST_CASE("ChannelManager moves backlogged channels to idle shards") {
+    ChannelManagerConfig config;
+    config.shards = 2;
+    config.pin_threads = false;
+    ChannelManager manager(4, config);
+
+    // Channels 0 and 2 both belong to shard 0 and are kept loaded
+    vector<uint8_t> stream;
+    for (size_t i = 0; i < 256; ++i) {
+        auto frame = encodeFrame(0x81, 0x10, vector<uint8_t>(247, static_cast<uint8_t>(i)));
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    map<uint32_t, size_t> offset, sent;
+    map<uint32_t, uint8_t> next;
+    size_t received = 0;
+    auto check = [&](const ChannelResult& result) {
+        // Stealing never reorders a channel
+        REQUIRE(result.result.status == ParseStatus::Success);
+        REQUIRE(result.result.frame.payload[0] == next[result.channel]);
+        next[result.channel] = static_cast<uint8_t>(next[result.channel] + 1);
+        ++received;
+    };
+
+    auto feedBoth = [&] {
+        for (uint32_t channel : {0u, 2u}) {
+            size_t& at = offset[channel];
+            const size_t accepted = manager.feed(channel, stream.data() + at, stream.size() - at);
+            sent[channel] += accepted;
+            at = (at + accepted) % stream.size();
+        }
+    };
+
+    // Unpolled results fill shard 0's queue, which leaves both channels backlogged
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (manager.steals() == 0 && chrono::steady_clock::now() < deadline) {
+        feedBoth();
+        this_thread::yield();
+    }
+    REQUIRE(manager.steals() >= 1);
+
+    // The stolen channel resumes once its earlier results are polled
+    for (int round = 0; round < 200; ++round) {
+        feedBoth();
+        manager.poll(check);
+    }
+
+    // Every complete frame fed comes out once the channels drain
+    const size_t expected = sent[0] / 253 + sent[2] / 253;
+    while (received < expected && chrono::steady_clock::now() < deadline + chrono::seconds(2)) {
+        if (manager.poll(check) == 0) {
+            this_thread::yield();
+        }
+    }
+    REQUIRE(received == expected);
+}
@@ -0,0 +1,298 @@
+//
+// EventLoop, serial (pty) and TCP transports
+//
+#include "catch2/catch_all.hpp"
+#include "fd_transport.h"
+#include "protocol_engine.h"
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+using namespace vdp;
+using namespace vdp::transport;
+
+// Collects bytes delivered by a transport's data callback
+struct Received {
+    mutex mtx;
+    condition_variable cv;
+    vector<uint8_t> bytes;
+    vector<string> errors;
+
+    void attach(ITransport& transport) {
+        transport.setDataCallback([this](const uint8_t* data, size_t length) {
+            lock_guard<mutex> lock(mtx);
+            bytes.insert(bytes.end(), data, data + length);
+            cv.notify_all();
+        });
+        transport.setErrorCallback([this](const string& error) {
+            lock_guard<mutex> lock(mtx);
+            errors.push_back(error);
+            cv.notify_all();
+        });
+    }
+
+    bool waitFor(size_t count) {
+        unique_lock<mutex> lock(mtx);
+        return cv.wait_for(lock, chrono::seconds(2), [&] { return bytes.size() >= count; });
+    }
+
+    bool waitForError() {
+        unique_lock<mutex> lock(mtx);
+        return cv.wait_for(lock, chrono::seconds(2), [&] { return !errors.empty(); });
+    }
+};
+
+// Read exactly count bytes from a blocking descriptor
+static vector<uint8_t> readExactly(int fd, size_t count) {
+    vector<uint8_t> bytes(count);
+    size_t offset = 0;
+    while (offset < count) {
+        ssize_t n = ::read(fd, bytes.data() + offset, count - offset);
+        if (n <= 0) {
+            bytes.resize(offset);
+            break;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    return bytes;
+}
+
+// Listening socket on an ephemeral loopback port
+struct Listener {
+    int fd = -1;
+    uint16_t port = 0;
+
+    Listener() {
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        ::listen(fd, 8);
+        socklen_t length = sizeof(address);
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+        port = ntohs(address.sin_port);
+    }
+    ~Listener() { ::close(fd); }
+
+    string endpoint() const { return "127.0.0.1:" + to_string(port); }
+    int accept() const { return ::accept(fd, nullptr, nullptr); }
+};
+
+TEST_CASE("EventLoop dispatches readiness and stops after remove") {
+    EventLoop loop;
+    int fds[2];
+    REQUIRE(::pipe2(fds, O_NONBLOCK) == 0);
+
+    mutex mtx;
+    condition_variable cv;
+    int calls = 0;
+    REQUIRE(loop.add(fds[0], EventLoop::READABLE, [&](uint32_t events) {
+        uint8_t byte;
+        while (::read(fds[0], &byte, 1) == 1) {
+        }
+        lock_guard<mutex> lock(mtx);
+        calls += (events & EventLoop::READABLE) ? 1 : 0;
+        cv.notify_all();
+    }));
+    REQUIRE(loop.size() == 1);
+    REQUIRE_FALSE(loop.add(fds[0], EventLoop::READABLE, [](uint32_t) {}));
+
+    REQUIRE(::write(fds[1], "x", 1) == 1);
+    {
+        unique_lock<mutex> lock(mtx);
+        REQUIRE(cv.wait_for(lock, chrono::seconds(2), [&] { return calls == 1; }));
+    }
+
+    loop.remove(fds[0]);
+    REQUIRE(loop.size() == 0);
+    REQUIRE(::write(fds[1], "y", 1) == 1);
+    this_thread::sleep_for(chrono::milliseconds(20));
+    {
+        lock_guard<mutex> lock(mtx);
+        REQUIRE(calls == 1);
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST_CASE("SerialTransport exchanges bytes over a pseudo terminal") {
+    const int master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    REQUIRE(master >= 0);
+    REQUIRE(::grantpt(master) == 0);
+    REQUIRE(::unlockpt(master) == 0);
+    const string device = ::ptsname(master);
+
+    SerialTransport transport;
+    Received received;
+    received.attach(transport);
+    REQUIRE(transport.initialize(device + ":115200"));
+    REQUIRE(transport.isConnected());
+
+    const uint8_t frame[] = {0x7E, 0x07, 0x01, 0x10, 0x00, 0x01, 0x17, 0x7F};
+    REQUIRE(::write(master, frame, sizeof(frame)) == static_cast<ssize_t>(sizeof(frame)));
+    REQUIRE(received.waitFor(sizeof(frame)));
+    REQUIRE(received.bytes == vector<uint8_t>(frame, frame + sizeof(frame)));
+
+    // Slices go out in order as one write
+    const uint8_t header[] = {0x7E, 0x06}, tail[] = {0x01, 0x50, 0x57, 0x7F};
+    const IoSlice slices[] = {{header, sizeof(header)}, {tail, sizeof(tail)}};
+    REQUIRE(transport.sendv(slices, 2));
+    REQUIRE(readExactly(master, 6) == vector<uint8_t>{0x7E, 0x06, 0x01, 0x50, 0x57, 0x7F});
+
+    transport.disconnect();
+    REQUIRE_FALSE(transport.isConnected());
+    REQUIRE_FALSE(transport.send(frame, sizeof(frame)));
+    ::close(master);
+}
+
+TEST_CASE("SerialTransport rejects bad connection strings") {
+    SerialTransport transport;
+    REQUIRE_FALSE(transport.initialize("/dev/does-not-exist"));
+    REQUIRE(transport.getLastError().find("open /dev/does-not-exist") == 0);
+    REQUIRE_FALSE(transport.initialize("/dev/null:12345"));
+    REQUIRE(transport.getLastError() == "Unsupported baud rate: 12345");
+}
+
+TEST_CASE("TcpTransport connects, sends and reports the peer closing") {
+    Listener listener;
+    TcpTransport transport;
+    Received received;
+    received.attach(transport);
+    REQUIRE(transport.initialize(listener.endpoint()));
+    const int peer = listener.accept();
+    REQUIRE(peer >= 0);
+
+    const uint8_t request[] = {0x7E, 0x06, 0x01, 0x50, 0x57, 0x7F};
+    REQUIRE(transport.send(request, sizeof(request)));
+    REQUIRE(readExactly(peer, sizeof(request)) == vector<uint8_t>(request, request + sizeof(request)));
+
+    REQUIRE(::write(peer, request, sizeof(request)) == static_cast<ssize_t>(sizeof(request)));
+    REQUIRE(received.waitFor(sizeof(request)));
+
+    ::close(peer);
+    REQUIRE(received.waitForError());
+    REQUIRE(received.errors.front() == "Connection closed");
+    REQUIRE_FALSE(transport.isConnected());
+}
+
+TEST_CASE("TcpTransport reads straight into a receive buffer") {
+    Listener listener;
+    TcpTransport transport;
+    Received received;
+    received.attach(transport);
+
+    // A parser's memory the transport reads into; the data callback must stay silent
+    VdpParser parser;
+    size_t prepared = 0;
+    size_t committed = 0;
+    REQUIRE(transport.setReceiveBuffer({
+        [&](size_t capacity) {
+            lock_guard<mutex> lock(received.mtx);
+            prepared = capacity;
+            return parser.prepareWrite(capacity);
+        },
+        [&](VdpParser::WriteLease lease, size_t length) {
+            lease.commit(length);
+            lock_guard<mutex> lock(received.mtx);
+            committed += length;
+            received.cv.notify_all();
+        }}));
+    REQUIRE(transport.initialize(listener.endpoint()));
+    const int peer = listener.accept();
+    REQUIRE(peer >= 0);
+
+    const uint8_t response[] = {0x7E, 0x06, 0x81, 0x50, 0xD7, 0x7F};
+    REQUIRE(::write(peer, response, sizeof(response)) == static_cast<ssize_t>(sizeof(response)));
+    {
+        unique_lock<mutex> lock(received.mtx);
+        REQUIRE(received.cv.wait_for(lock, chrono::seconds(2), [&] { return committed >= sizeof(response); }));
+        REQUIRE(prepared == FdTransport::READ_BUFFER_SIZE);
+    }
+    auto results = parser.extractFrames();
+    REQUIRE(results.size() == 1);
+    REQUIRE(results[0].raw_bytes == vector<uint8_t>(response, response + sizeof(response)));
+    REQUIRE(received.bytes.empty());
+
+    // The closing read gives its lease back without feeding anything
+    ::close(peer);
+    REQUIRE(received.waitForError());
+    REQUIRE(committed == sizeof(response));
+    parser.feed(response, sizeof(response));
+    REQUIRE(parser.extractFrames().size() == 1);
+}
+
+TEST_CASE("Many transports share one event loop") {
+    Listener listener;
+    EventLoop loop;
+    constexpr size_t COUNT = 64;
+    vector<unique_ptr<TcpTransport>> transports;
+    vector<unique_ptr<Received>> received;
+    vector<int> peers;
+    for (size_t i = 0; i < COUNT; ++i) {
+        transports.push_back(make_unique<TcpTransport>(loop));
+        received.push_back(make_unique<Received>());
+        received.back()->attach(*transports.back());
+        REQUIRE(transports.back()->initialize(listener.endpoint()));
+        peers.push_back(listener.accept());
+    }
+    REQUIRE(loop.size() == COUNT);
+
+    for (size_t i = 0; i < COUNT; ++i) {
+        const uint8_t byte = static_cast<uint8_t>(i);
+        REQUIRE(::write(peers[i], &byte, 1) == 1);
+    }
+    for (size_t i = 0; i < COUNT; ++i) {
+        REQUIRE(received[i]->waitFor(1));
+        REQUIRE(received[i]->bytes == vector<uint8_t>{static_cast<uint8_t>(i)});
+    }
+
+    transports.clear();
+    REQUIRE(loop.size() == 0);
+    for (int peer : peers) {
+        ::close(peer);
+    }
+}
+
+TEST_CASE("VDPEngine runs over a TCP transport") {
+    Listener listener;
+    auto engine = make_unique<protocol::VDPEngine>(TransportFactory::create(TransportFactory::Type::TCP));
+    REQUIRE(engine->initialize(listener.endpoint()));
+    const int peer = listener.accept();
+
+    // Gateway side: answer the request with a success response
+    thread gateway([&] {
+        auto request = readExactly(peer, 8);
+        VdpParser codec;
+        vector<uint8_t> response;
+        codec.serializeFrame({static_cast<uint8_t>(request[2] | 0x80), request[3], {0x00, 0x2A}}, response);
+        ssize_t ignored = ::write(peer, response.data(), response.size());
+        (void)ignored;
+    });
+
+    protocol::Response response = engine->sendFrame({0x01, 0x10, {0x00, 0x01}}, 1000);
+    gateway.join();
+    REQUIRE(response.status == protocol::Status::Success);
+    REQUIRE(response.frame.data == vector<uint8_t>{0x00, 0x2A});
+    engine.reset();
+    ::close(peer);
+}
+
+TEST_CASE("TransportFactory creates the descriptor-based transports") {
+    REQUIRE(dynamic_cast<SerialTransport*>(TransportFactory::create(TransportFactory::Type::SERIAL).get()));
+    REQUIRE(dynamic_cast<TcpTransport*>(TransportFactory::create(TransportFactory::Type::TCP).get()));
+    // TCP carries no DoIP header or routing activation, so it does not stand in for DOIP
+    REQUIRE(TransportFactory::create(TransportFactory::Type::DOIP) == nullptr);
+    REQUIRE(TransportFactory::create(TransportFactory::Type::BLUETOOTH) == nullptr);
+}
+#endif
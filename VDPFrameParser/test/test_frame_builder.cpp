@@ -0,0 +1,56 @@
+//
+// Compile-time frame builder tests: pre-baked bytes must equal runtime serialization
+//
+#include "catch2/catch_all.hpp"
+#include "frame_builder.h"
+#include <vector>
+
+using namespace std;
+using namespace vdp;
+
+// Spec example: 7E 08 01 10 00 01 18 7F
+constexpr auto READ_DATA = make_frame<0x01, CommandType::ReadData, 0x00, 0x01>();
+static_assert(READ_DATA.size() == 8, "LEN covers the whole frame");
+static_assert(READ_DATA[1] == 0x08 && READ_DATA[6] == 0x18 && READ_DATA[7] == 0x7F,
+              "LEN and checksum are computed at compile time");
+
+constexpr auto KEEP_ALIVE = make_frame<0x05, CommandType::KeepAlive>();
+static_assert(KEEP_ALIVE.size() == 6 && KEEP_ALIVE[4] == (0x06 ^ 0x05 ^ 0x50), "Minimum frame");
+
+static vector<uint8_t> serialize(const VdpFrame& frame) {
+    VdpParser codec;
+    vector<uint8_t> bytes;
+    codec.serializeFrame(frame, bytes);
+    return bytes;
+}
+
+template <size_t N>
+static vector<uint8_t> bytesOf(const array<uint8_t, N>& frame) {
+    return vector<uint8_t>(frame.begin(), frame.end());
+}
+
+TEST_CASE("make_frame matches serializeFrame") {
+    REQUIRE(bytesOf(READ_DATA) == serialize({0x01, 0x10, {0x00, 0x01}}));
+    REQUIRE(bytesOf(KEEP_ALIVE) == serialize({0x05, 0x50, {}}));
+    REQUIRE(bytesOf(make_frame<0x7F, CommandType::EcuReset, 0x7E, 0x7F, 0xFF>()) ==
+            serialize({0x7F, 0x40, {0x7E, 0x7F, 0xFF}}));
+}
+
+TEST_CASE("make_ack_frame and make_nak_frame match createAckFrame and createNakFrame") {
+    VdpParser codec;
+    VdpFrame request{0x03, 0x20, {0xAA}};
+
+    REQUIRE(bytesOf(make_ack_frame<0x03, CommandType::WriteData>()) == serialize(codec.createAckFrame(request)));
+    REQUIRE(bytesOf(make_nak_frame<0x03, CommandType::WriteData>()) == serialize(codec.createNakFrame(request)));
+    REQUIRE(bytesOf(make_nak_frame<0x03, CommandType::WriteData, ResponseStatus::EcuBusy>()) ==
+            serialize(codec.createNakFrame(request, 0x03)));
+}
+
+TEST_CASE("Pre-baked frames parse back") {
+    VdpParser parser;
+    parser.feed(READ_DATA.data(), READ_DATA.size());
+    auto results = parser.extractFrames();
+    REQUIRE(results.size() == 1);
+    REQUIRE(results[0].status == ParseStatus::Success);
+    REQUIRE(results[0].frame->data == vector<uint8_t>{0x00, 0x01});
+}
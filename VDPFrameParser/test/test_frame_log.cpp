@@ -0,0 +1,274 @@
+//
+// Frame log tests: writer/reader round trip, compression and corrupt logs
+//
+#include "catch2/catch_all.hpp"
+#include "frame_log.h"
+
+#include <cstdio>
+#include <random>
+
+using namespace std;
+using namespace vdp;
+
+using Clock = chrono::system_clock;
+
+struct Recorded {
+    Clock::time_point timestamp;
+    vector<uint8_t> raw;
+};
+
+// Results of parsing noisy traffic, with timestamps that mostly advance
+static vector<Recorded> makeResults(size_t count) {
+    mt19937 rng(3);
+    uniform_int_distribution<int> byte_dist(0, 255);
+    VdpParser codec;
+    vector<uint8_t> stream;
+    vector<uint8_t> frame_bytes;
+    while (stream.size() < count * 40) {
+        VdpFrame frame{static_cast<uint8_t>(byte_dist(rng)), 0x10, {}};
+        frame.data.resize(static_cast<size_t>(byte_dist(rng)) % 64);
+        for (auto& b : frame.data) {
+            b = static_cast<uint8_t>(byte_dist(rng));
+        }
+        codec.serializeFrame(frame, frame_bytes);
+        if (byte_dist(rng) % 4 == 0) {
+            frame_bytes.back() = 0x00;   // bad end marker
+        }
+        stream.insert(stream.end(), frame_bytes.begin(), frame_bytes.end());
+    }
+
+    VdpParser parser;
+    parser.feed(stream.data(), stream.size());
+    vector<Recorded> results;
+    Clock::time_point timestamp = Clock::now();
+    parser.extractFrameViews([&](const ParseResultView& result) {
+        if (results.size() < count) {
+            // Microsecond resolution, a step back now and then
+            timestamp += chrono::microseconds(byte_dist(rng) % 16 == 0 ? -500 : byte_dist(rng) * 10);
+            timestamp = chrono::time_point_cast<chrono::microseconds>(timestamp);
+            results.push_back({timestamp, vector<uint8_t>(result.raw_bytes.begin(), result.raw_bytes.end())});
+        }
+    });
+    return results;
+}
+
+static vector<uint8_t> readFile(const string& path) {
+    MappedFile file;
+    string error;
+    REQUIRE(file.open(path, error));
+    return vector<uint8_t>(file.bytes().begin(), file.bytes().end());
+}
+
+static void writeLog(const string& path, const vector<Recorded>& results, FrameLogConfig config) {
+    FrameLogWriter writer;
+    string error;
+    REQUIRE(writer.open(path, config, error));
+    for (const auto& result : results) {
+        writer.record({result.raw.data(), result.raw.size()}, result.timestamp);
+    }
+    REQUIRE(writer.recordCount() == results.size());
+    writer.close();
+    REQUIRE(writer.getLastError().empty());
+}
+
+static void requireLog(const vector<uint8_t>& file, const vector<Recorded>& expected) {
+    ByteSpan payload;
+    uint16_t flags = 0;
+    REQUIRE(parseCaptureHeader({file.data(), file.size()}, payload, &flags));
+    REQUIRE((flags & CaptureHeader::FRAME_LOG) != 0);
+
+    FrameLogReader reader(payload, flags);
+    FrameLogRecord record;
+    size_t count = 0;
+    while (reader.next(record)) {
+        REQUIRE(count < expected.size());
+        REQUIRE(record.timestamp == expected[count].timestamp);
+        REQUIRE(vector<uint8_t>(record.raw_bytes.begin(), record.raw_bytes.end()) == expected[count].raw);
+        REQUIRE(record.error == ParseError::None);
+        ++count;
+    }
+    REQUIRE(reader.error().empty());
+    REQUIRE(count == expected.size());
+}
+
+TEST_CASE("Frame log round trip") {
+    const auto results = makeResults(5000);
+    const string path = "vdp_frame_log_test.vdplog";
+
+    SECTION("One buffer") {
+        writeLog(path, results, {});
+        const auto file = readFile(path);
+        requireLog(file, results);
+        // Mostly one or two timestamp bytes plus LEN and the error per record
+        size_t raw_total = 0;
+        for (const auto& result : results) {
+            raw_total += result.raw.size();
+        }
+        REQUIRE(file.size() < CaptureHeader::SIZE + raw_total + 5 * results.size());
+    }
+
+    SECTION("Many small buffers") {
+        FrameLogConfig config;
+        config.buffer_size = 1024;
+        writeLog(path, results, config);
+        requireLog(readFile(path), results);
+    }
+
+    SECTION("LZ4 blocks") {
+        FrameLogConfig config;
+        config.buffer_size = 4096;
+        config.compress = true;
+        if (frameLogCompressionAvailable()) {
+            writeLog(path, results, config);
+            const auto file = readFile(path);
+            REQUIRE((file[10] & CaptureHeader::LZ4) != 0);
+            requireLog(file, results);
+        } else {
+            FrameLogWriter writer;
+            string error;
+            REQUIRE_FALSE(writer.open(path, config, error));
+            REQUIRE_FALSE(error.empty());
+        }
+    }
+
+    remove(path.c_str());
+}
+
+TEST_CASE("Frame log parse results replay as recorded") {
+    auto results = makeResults(100);
+    const string path = "vdp_frame_log_results.vdplog";
+    {
+        FrameLogWriter writer;
+        string error;
+        REQUIRE(writer.open(path, {}, error));
+        for (auto& result : results) {
+            // Parser stamps are monotonic ticks, converted when recorded
+            const RxTimestamp received = RxTimestamp::fromSteady(
+                chrono::steady_clock::time_point(chrono::milliseconds(1000 + &result - results.data())));
+            writer.record(ParseResult(ParseStatus::Success, nullopt, string(), result.raw, received));
+            result.timestamp = chrono::time_point_cast<chrono::microseconds>(received.toSystem());
+        }
+        // Results without raw bytes have nothing to record
+        writer.record(ParseResult());
+        writer.flush();
+        REQUIRE(writer.recordCount() == results.size());
+    }
+    const auto file = readFile(path);
+    requireLog(file, results);
+    remove(path.c_str());
+}
+
+TEST_CASE("Frame log records a coalesced run as its first candidate") {
+    // 40000 false starts (LEN 1) in a row, one Invalid result when coalesced
+    vector<uint8_t> stream(80000, 0x01);
+    for (size_t i = 0; i < stream.size(); i += 2) {
+        stream[i] = 0x7E;
+    }
+    VdpParser parser;
+    parser.setInvalidCoalescing(true);
+    parser.feed(stream.data(), stream.size());
+
+    const string path = "vdp_frame_log_coalesced.vdplog";
+    FrameLogWriter writer;
+    string error;
+    REQUIRE(writer.open(path, {}, error));
+    size_t count = 0;
+    ParseError code = ParseError::None;
+    parser.extractFrameViews([&](const ParseResultView& result) {
+        REQUIRE(result.error.coalesced == 39999);
+        code = result.error.code;
+        REQUIRE(result.error.run_length == stream.size());
+        REQUIRE(result.raw_bytes.size == 2);
+        writer.record(result, Clock::now());
+        ++count;
+    });
+    REQUIRE(count == 1);
+    writer.close();
+    REQUIRE(writer.getLastError().empty());
+
+    const auto file = readFile(path);
+    ByteSpan payload;
+    uint16_t flags = 0;
+    REQUIRE(parseCaptureHeader({file.data(), file.size()}, payload, &flags));
+    FrameLogReader reader(payload, flags);
+    FrameLogRecord record;
+    REQUIRE(reader.next(record));
+    REQUIRE(vector<uint8_t>(record.raw_bytes.begin(), record.raw_bytes.end()) == vector<uint8_t>{0x7E, 0x01});
+    REQUIRE(record.error == code);
+    REQUIRE(record.coalesced == 39999);
+    REQUIRE_FALSE(reader.next(record));
+    REQUIRE(reader.error().empty());
+    remove(path.c_str());
+}
+
+TEST_CASE("Frame log records keep a Stale result's code") {
+    VdpParser parser(chrono::milliseconds(100));
+    VdpParser codec;
+    vector<uint8_t> frame;
+    codec.serializeFrame({0x82, 0x10, {0x01, 0x02}}, frame);
+    const auto t0 = chrono::steady_clock::now();
+    parser.feed(frame.data(), 4, RxTimestamp::fromSteady(t0));
+    parser.extractFrameViews([](const ParseResultView&) { FAIL("still waiting for the frame"); });
+    parser.feed(frame.data(), frame.size(), RxTimestamp::fromSteady(t0 + chrono::milliseconds(300)));
+
+    const string path = "vdp_frame_log_stale.vdplog";
+    FrameLogWriter writer;
+    string error;
+    REQUIRE(writer.open(path, {}, error));
+    parser.extractFrameViews([&](const ParseResultView& result) { writer.record(result); });
+    REQUIRE(writer.recordCount() == 2);
+    writer.close();
+
+    const auto file = readFile(path);
+    ByteSpan payload;
+    uint16_t flags = 0;
+    REQUIRE(parseCaptureHeader({file.data(), file.size()}, payload, &flags));
+    FrameLogReader reader(payload, flags);
+    FrameLogRecord record;
+    // Parsing the partial frame again would only ask for more bytes
+    REQUIRE(reader.next(record));
+    REQUIRE(record.raw_bytes.size == 4);
+    REQUIRE(record.error == ParseError::Stale);
+    REQUIRE(record.coalesced == 0);
+    REQUIRE(reader.next(record));
+    REQUIRE(record.raw_bytes.size == frame.size());
+    REQUIRE(record.error == ParseError::None);
+    REQUIRE_FALSE(reader.next(record));
+    REQUIRE(reader.error().empty());
+    remove(path.c_str());
+}
+
+TEST_CASE("Frame log readers reject corrupt logs") {
+    const auto results = makeResults(10);
+    const string path = "vdp_frame_log_corrupt.vdplog";
+    writeLog(path, results, {});
+    auto file = readFile(path);
+    remove(path.c_str());
+
+    SECTION("Raw capture readers do not take frame logs") {
+        ByteSpan payload;
+        REQUIRE_FALSE(parseCaptureHeader({file.data(), file.size()}, payload));
+    }
+
+    SECTION("Unknown flags") {
+        file[11] = 0x80;
+        ByteSpan payload;
+        uint16_t flags = 0;
+        REQUIRE_FALSE(parseCaptureHeader({file.data(), file.size()}, payload, &flags));
+    }
+
+    SECTION("Truncated record") {
+        file.pop_back();
+        ByteSpan payload;
+        uint16_t flags = 0;
+        REQUIRE(parseCaptureHeader({file.data(), file.size()}, payload, &flags));
+        FrameLogReader reader(payload, flags);
+        FrameLogRecord record;
+        size_t count = 0;
+        while (reader.next(record)) {
+            ++count;
+        }
+        REQUIRE(count == results.size() - 1);
+        REQUIRE_FALSE(reader.error().empty());
+    }
+}
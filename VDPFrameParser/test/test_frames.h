@@ -0,0 +1,17 @@
+//
+// Frame helpers shared by the tests
+//
+#pragma once
+
+#include "vdp_parser.h"
+
+#include <cstdint>
+#include <vector>
+
+// Wire bytes of one frame, as VdpParser::serializeFrame() writes them
+inline std::vector<uint8_t> encodeFrame(uint8_t ecu_id, uint8_t cmd, const std::vector<uint8_t>& data = {}) {
+    vdp::VdpParser codec;
+    std::vector<uint8_t> bytes;
+    codec.serializeFrame({ecu_id, cmd, data}, bytes);
+    return bytes;
+}
@@ -0,0 +1,87 @@
+//
+// InlineFrame tests: inline storage, conversions and flat result arrays
+//
+#include "catch2/catch_all.hpp"
+#include "vdp_parser.h"
+#include "types.h"
+#include "../../mobile_bridge.h"
+
+#include <cstring>
+
+using namespace std;
+using namespace vdp;
+
+TEST_CASE("InlineFrame stores DATA inline") {
+    InlineFrame frame;
+    const vector<uint8_t> data(InlineFrame::CAPACITY, 0x5A);
+    REQUIRE(frame.assign({data.data(), data.size()}));
+    REQUIRE(frame.data().size == InlineFrame::CAPACITY);
+
+    SECTION("Copies are independent memcpys") {
+        InlineFrame copy;
+        std::memcpy(&copy, &frame, sizeof(frame));
+        copy.payload[0] = 0x00;
+        REQUIRE(frame.payload[0] == 0x5A);
+        REQUIRE(copy.data().size == InlineFrame::CAPACITY);
+    }
+
+    SECTION("Oversized DATA is rejected and leaves the frame unchanged") {
+        const vector<uint8_t> too_large(InlineFrame::CAPACITY + 1, 0x01);
+        REQUIRE_FALSE(frame.assign({too_large.data(), too_large.size()}));
+        REQUIRE(frame.length == InlineFrame::CAPACITY);
+        REQUIRE(frame.payload[0] == 0x5A);
+
+        VdpFrame vector_frame{0x01, 0x10, too_large};
+        InlineFrame out;
+        REQUIRE_FALSE(InlineFrame::from(vector_frame, out));
+    }
+}
+
+TEST_CASE("InlineFrame converts to and from the vector-based frame types") {
+    InlineFrame frame;
+    REQUIRE(InlineFrame::from(VdpFrame{0x01, 0x20, {0x01, 0x02, 0x03}}, frame));
+    REQUIRE(frame.ecu_id == 0x01);
+    REQUIRE(frame.command == 0x20);
+    REQUIRE(frame.length == 3);
+
+    auto vdp_frame = frame.to<VdpFrame>();
+    REQUIRE(vdp_frame.data == vector<uint8_t>{0x01, 0x02, 0x03});
+
+    auto pooled = frame.to<PooledVdpFrame>();
+    REQUIRE(pooled.data.size() == 3);
+
+    auto protocol_frame = frame.to<protocol::Frame>();
+    REQUIRE(protocol_frame.ecu_id == 0x01);
+    REQUIRE(protocol_frame.data == vdp_frame.data);
+
+    carly::protocol::Frame bridge_frame(0x02, 0x10);
+    bridge_frame.data = {0xAA};
+    REQUIRE(InlineFrame::from(bridge_frame, frame));
+    auto back = frame.to<carly::protocol::Frame>();
+    REQUIRE(back.ecu_id == 0x02);
+    REQUIRE(back.data == vector<uint8_t>{0xAA});
+}
+
+TEST_CASE("Parser fills a flat array of inline results") {
+    VdpParser parser;
+    vector<uint8_t> stream, frame;
+    for (uint8_t i = 0; i < 3; ++i) {
+        parser.serializeFrame({0x81, 0x10, {i, 0x00}}, frame);
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    stream.insert(stream.end(), {0x7E, 0x02});   // BadLength
+    parser.feed(stream.data(), stream.size());
+
+    InlineParseResult results[2];
+    REQUIRE(parser.extractFrames(results, 2) == 2);
+    REQUIRE(results[0].status == ParseStatus::Success);
+    REQUIRE(results[1].frame.payload[0] == 0x01);
+
+    // Results that did not fit were left buffered
+    REQUIRE(parser.extractFrames(results, 2) == 2);
+    REQUIRE(results[0].frame.to<VdpFrame>().data == vector<uint8_t>{0x02, 0x00});
+    REQUIRE(results[1].status == ParseStatus::Invalid);
+    REQUIRE(results[1].error.code == ParseError::BadLength);
+    REQUIRE(results[1].frame.length == 0);
+    REQUIRE(parser.extractFrames(results, 2) == 0);
+}
@@ -0,0 +1,117 @@
+//
+// LatencyTracker and RetryPolicy tests: smoothing, percentiles, adaptive timeouts and backoff
+//
+#include "catch2/catch_all.hpp"
+#include "latency_stats.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace vdp;
+using namespace vdp::protocol;
+
+TEST_CASE("LatencyTracker smooths response times like RFC 6298") {
+    LatencyTracker tracker;
+    REQUIRE(tracker.ewma() == microseconds(0));
+    REQUIRE(tracker.p99() == microseconds(0));
+
+    tracker.record(microseconds(8000));
+    REQUIRE(tracker.ewma() == microseconds(8000));
+    REQUIRE(tracker.deviation() == microseconds(4000));
+
+    // error 8000: srtt += 1000, rttvar += (8000 - 4000) / 4
+    tracker.record(microseconds(16000));
+    REQUIRE(tracker.ewma() == microseconds(9000));
+    REQUIRE(tracker.deviation() == microseconds(5000));
+    REQUIRE(tracker.responses() == 2);
+
+    // Converges on a steady response time
+    for (int i = 0; i < 200; ++i) {
+        tracker.record(microseconds(2000));
+    }
+    REQUIRE(tracker.ewma() >= microseconds(2000));
+    REQUIRE(tracker.ewma() < microseconds(2100));
+    REQUIRE(tracker.deviation() < microseconds(100));
+}
+
+TEST_CASE("LatencyTracker percentiles are within one bucket of the samples") {
+    LatencyTracker tracker;
+    for (int i = 0; i < 99; ++i) {
+        tracker.record(microseconds(1000));
+    }
+    tracker.record(microseconds(50000));
+
+    // 1000us lies in [960, 1023], 50000us in [49152, 53247]
+    REQUIRE(tracker.percentile(0.5) == microseconds(1023));
+    REQUIRE(tracker.p99() == microseconds(1023));
+    REQUIRE(tracker.percentile(1.0) == microseconds(53247));
+
+    // Small values get a bucket each
+    LatencyTracker small;
+    small.record(microseconds(3));
+    REQUIRE(small.p99() == microseconds(3));
+
+    // Values past the last bucket are clamped into it
+    LatencyTracker huge;
+    huge.record(seconds(100));
+    REQUIRE(huge.p99() >= seconds(16));
+}
+
+TEST_CASE("LatencyTracker percentiles follow recent samples") {
+    LatencyTracker tracker;
+    for (int i = 0; i < 1000; ++i) {
+        tracker.record(microseconds(40000));
+    }
+    // Older samples are halved away, the fast ones take over the p99
+    for (int i = 0; i < 8 * 1024; ++i) {
+        tracker.record(microseconds(1000));
+    }
+    REQUIRE(tracker.p99() == microseconds(1023));
+}
+
+TEST_CASE("RetryPolicy derives the attempt timeout from the statistics") {
+    LatencyTracker tracker;
+    RetryPolicy policy;
+
+    // Not adaptive by default
+    for (int i = 0; i < 20; ++i) {
+        tracker.record(microseconds(i % 2 ? 20000 : 30000));
+    }
+    REQUIRE(policy.attemptTimeout(tracker, milliseconds(500)) == milliseconds(500));
+
+    policy.adaptive_timeout = true;
+    const auto expected = ceil<milliseconds>(max(tracker.ewma() + 4 * tracker.deviation(), tracker.p99()));
+    REQUIRE(policy.attemptTimeout(tracker, milliseconds(500)) == expected);
+    REQUIRE(expected > milliseconds(30));
+    REQUIRE(expected < milliseconds(100));
+
+    SECTION("Clamped to the policy bounds") {
+        policy.max_timeout = milliseconds(25);
+        REQUIRE(policy.attemptTimeout(tracker, milliseconds(500)) == milliseconds(25));
+        LatencyTracker fast;
+        for (int i = 0; i < 20; ++i) {
+            fast.record(microseconds(100));
+        }
+        REQUIRE(policy.attemptTimeout(fast, milliseconds(500)) == policy.min_timeout);
+    }
+
+    SECTION("Too few samples keep the requested timeout") {
+        LatencyTracker fresh;
+        for (uint64_t i = 1; i < RetryPolicy::MIN_SAMPLES; ++i) {
+            fresh.record(microseconds(100));
+        }
+        REQUIRE(policy.attemptTimeout(fresh, milliseconds(500)) == milliseconds(500));
+    }
+}
+
+TEST_CASE("RetryPolicy backoff doubles per attempt up to the maximum timeout") {
+    LatencyTracker tracker;
+    RetryPolicy policy;
+    REQUIRE(policy.backoff(tracker, 1) == milliseconds(5));
+    REQUIRE(policy.backoff(tracker, 2) == milliseconds(10));
+    REQUIRE(policy.backoff(tracker, 3) == milliseconds(20));
+    REQUIRE(policy.backoff(tracker, 20) == policy.max_timeout);
+
+    // A slow ECU backs off by at least its smoothed response time
+    tracker.record(microseconds(12500));
+    REQUIRE(policy.backoff(tracker, 1) == milliseconds(13));
+}
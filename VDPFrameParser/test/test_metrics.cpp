@@ -0,0 +1,142 @@
+//
+// Instrumentation tests: counters, histograms, parser metrics and the Prometheus exporter
+//
+#include "catch2/catch_all.hpp"
+#include "metrics_export.h"
+#include "test_frames.h"
+
+using namespace std;
+using namespace vdp;
+
+static void append(vector<uint8_t>& out, const vector<uint8_t>& bytes) {
+    out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+static bool contains(const string& text, const string& line) {
+    return text.find(line) != string::npos;
+}
+
+TEST_CASE("Histogram percentiles are within one bucket of the samples") {
+    metrics::Histogram histogram;
+    REQUIRE(histogram.snapshot().percentile(0.99) == 0);
+
+    histogram.record(1000, 99);
+    histogram.record(50000);
+    metrics::HistogramSnapshot snapshot = histogram.snapshot();
+    if (!metrics::ENABLED) {
+        REQUIRE(snapshot.count == 0);
+        return;
+    }
+    REQUIRE(snapshot.count == 100);
+    REQUIRE(snapshot.sum == 99 * 1000 + 50000);
+    REQUIRE(snapshot.max == 50000);
+    REQUIRE(snapshot.mean() == Approx(1490.0));
+
+    // 1000 lies in [960, 1023]; the top bucket is capped at the largest sample
+    REQUIRE(snapshot.percentile(0.5) == 1023);
+    REQUIRE(snapshot.percentile(0.99) == 1023);
+    REQUIRE(snapshot.percentile(1.0) == 50000);
+
+    // Small values get a bucket each
+    metrics::Histogram small;
+    small.record(3);
+    small.record(5);
+    REQUIRE(small.snapshot().percentile(0.5) == 3);
+}
+
+TEST_CASE("Parser metrics count frames, rejects and resync discards") {
+    vector<uint8_t> stream = {0x01, 0x02, 0x03};            // garbage
+    const vector<uint8_t> good = encodeFrame(0x01, 0x10, {0x01, 0x02});
+    vector<uint8_t> bad_checksum = encodeFrame(0x02, 0x10, {0x05});
+    bad_checksum[bad_checksum.size() - 2] ^= 0x01;
+    append(stream, good);
+    append(stream, bad_checksum);
+    append(stream, {0x7E, 0x02});                         // LEN below the minimum
+    append(stream, good);
+
+    VdpParser parser;
+    parser.feed(stream.data(), stream.size());
+
+    ParserMetricsSnapshot before = parser.metrics();
+    REQUIRE(before.frames == 0);           // published by the extract call
+
+    REQUIRE(parser.extractFrames().size() == 4);
+    ParserMetricsSnapshot metrics = parser.metrics();
+    if (!metrics::ENABLED) {
+        REQUIRE(metrics.bytes_fed == 0);
+        REQUIRE(metrics.frames == 0);
+        return;
+    }
+    REQUIRE(before.bytes_fed == stream.size());
+    REQUIRE(metrics.bytes_fed == stream.size());
+    REQUIRE(metrics.frames == 2);
+    REQUIRE(metrics.invalid[static_cast<size_t>(ParseError::BadChecksum)] == 1);
+    REQUIRE(metrics.invalid[static_cast<size_t>(ParseError::BadLength)] == 1);
+    REQUIRE(metrics.invalidTotal() == 2);
+    // Everything but the two frames was skipped
+    REQUIRE(metrics.bytes_discarded == stream.size() - 2 * good.size());
+    REQUIRE(metrics.feed_to_frame_ns.count == 2);
+
+    // reset() keeps the counters
+    parser.reset();
+    REQUIRE(parser.metrics().frames == 2);
+}
+
+TEST_CASE("Parser latency is not sampled without timestamps") {
+    VdpParser parser;
+    parser.setTimestampCapture(false);
+    const vector<uint8_t> frame = encodeFrame(0x01, 0x10);
+    parser.feed(frame.data(), frame.size());
+
+    ParseBatch batch;
+    REQUIRE(parser.extractFrames(batch) == 1);
+    ParserMetricsSnapshot metrics = parser.metrics();
+    REQUIRE(metrics.frames == (metrics::ENABLED ? 1u : 0u));
+    REQUIRE(metrics.feed_to_frame_ns.count == 0);
+}
+
+TEST_CASE("Parser metrics can be exported as Prometheus text") {
+    ParserMetricsSnapshot metrics;
+    metrics.bytes_fed = 100;
+    metrics.frames = 2;
+    metrics.invalid[static_cast<size_t>(ParseError::BadChecksum)] = 1;
+    metrics.feed_to_frame_ns.count = 2;
+    metrics.feed_to_frame_ns.sum = 3000;
+    metrics.feed_to_frame_ns.max = 1500;
+    metrics.feed_to_frame_ns.buckets[metrics::HistogramBuckets::bucketOf(1500)] = 2;
+
+    string text;
+    appendPrometheus(text, metrics, "channel=\"0\"");
+    REQUIRE(contains(text, "# TYPE vdp_parser_bytes_fed_total counter\n"));
+    REQUIRE(contains(text, "vdp_parser_bytes_fed_total{channel=\"0\"} 100\n"));
+    REQUIRE(contains(text, "vdp_parser_frames_total{channel=\"0\"} 2\n"));
+    REQUIRE(contains(text, "vdp_parser_invalid_total{channel=\"0\",reason=\"bad_checksum\"} 1\n"));
+    REQUIRE(contains(text, "vdp_parser_invalid_total{channel=\"0\",reason=\"truncated\"} 0\n"));
+    REQUIRE(contains(text, "# TYPE vdp_parser_feed_to_frame_seconds summary\n"));
+    REQUIRE(contains(text, "vdp_parser_feed_to_frame_seconds{channel=\"0\",quantile=\"0.99\"} 1.5e-06\n"));
+    REQUIRE(contains(text, "vdp_parser_feed_to_frame_seconds_sum{channel=\"0\"} 3e-06\n"));
+    REQUIRE(contains(text, "vdp_parser_feed_to_frame_seconds_count{channel=\"0\"} 2\n"));
+
+    // A second instance in the same scrape, without repeating the metadata
+    string more;
+    appendPrometheus(more, metrics, "channel=\"1\"", false);
+    REQUIRE(!contains(more, "#"));
+    REQUIRE(contains(more, "vdp_parser_frames_total{channel=\"1\"} 2\n"));
+}
+
+TEST_CASE("Engine metrics export NAKs by status") {
+    protocol::EngineMetricsSnapshot metrics;
+    metrics.requests = 5;
+    metrics.naks = 3;
+    metrics.naks_by_status[static_cast<size_t>(ResponseStatus::EcuBusy)] = 2;
+    metrics.queue_depth = 4;
+
+    string text;
+    appendPrometheus(text, metrics);
+    REQUIRE(contains(text, "vdp_engine_requests_total 5\n"));
+    REQUIRE(contains(text, "vdp_engine_naks_total{status=\"0x03\"} 2\n"));
+    REQUIRE(contains(text, "vdp_engine_naks_total{status=\"none\"} 1\n"));
+    REQUIRE(!contains(text, "status=\"0x01\""));
+    REQUIRE(contains(text, "# TYPE vdp_engine_queue_depth gauge\nvdp_engine_queue_depth 4\n"));
+    REQUIRE(contains(text, "vdp_engine_round_trip_seconds_count 0\n"));
+}
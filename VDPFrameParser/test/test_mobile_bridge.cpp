@@ -0,0 +1,197 @@
+//
+// MobileBridgeImpl tests: the mobile_bridge.h interface over a MockTransport
+//
+#include "catch2/catch_all.hpp"
+#include "mobile_bridge_impl.h"
+#include "test_frames.h"
+
+#include <condition_variable>
+#include <thread>
+
+using namespace std;
+using namespace vdp;
+using carly::protocol::MobileBridgeImpl;
+using carly::protocol::MockTransport;
+namespace mobile = carly::protocol;
+
+// Bridge over a mock transport that answers every request with response
+static unique_ptr<MobileBridgeImpl> makeBridge(MockTransport*& mock, const vector<uint8_t>& response = {}) {
+    auto owned = make_unique<MockTransport>();
+    mock = owned.get();
+    mock->setAutoResponse(!response.empty(), response);
+    auto bridge = make_unique<MobileBridgeImpl>(std::move(owned));
+    REQUIRE(bridge->initialize("mock"));
+    return bridge;
+}
+
+TEST_CASE("MobileBridgeImpl sends frames and returns responses") {
+    MockTransport* mock = nullptr;
+    auto bridge = makeBridge(mock, encodeFrame(0x81, 0x10, {0x00, 0x12, 0x34}));
+    REQUIRE(bridge->isConnected());
+
+    mobile::Frame request(0x01, 0x10);
+    request.data = {0xF1, 0x90};
+
+    SECTION("Blocking") {
+        auto response = bridge->sendFrame(request, 200);
+        REQUIRE(response.isSuccess());
+        REQUIRE(response.frame.ecu_id == 0x81);
+        REQUIRE(response.frame.data == vector<uint8_t>{0x00, 0x12, 0x34});
+        REQUIRE(mock->getLastSentData() == encodeFrame(0x01, 0x10, {0xF1, 0x90}));
+    }
+
+    SECTION("Asynchronous") {
+        mutex mtx;
+        condition_variable cv;
+        bool done = false;
+        mobile::Response received{};
+        bridge->sendFrameAsync(request, [&](const mobile::Response& response) {
+            lock_guard<mutex> lock(mtx);
+            received = response;
+            done = true;
+            cv.notify_one();
+        }, [&](const string&) {
+            lock_guard<mutex> lock(mtx);
+            done = true;
+            cv.notify_one();
+        });
+        unique_lock<mutex> lock(mtx);
+        REQUIRE(cv.wait_for(lock, chrono::seconds(2), [&] { return done; }));
+        REQUIRE(received.isSuccess());
+        REQUIRE(received.frame.data.size() == 3);
+    }
+}
+
+TEST_CASE("MobileBridgeImpl maps failures to mobile status codes") {
+    MockTransport* mock = nullptr;
+
+    SECTION("ECU status code") {
+        auto bridge = makeBridge(mock, encodeFrame(0x81, 0x20, {0x02}));
+        auto response = bridge->sendFrame(mobile::Frame(0x01, 0x20), 200);
+        REQUIRE(response.status == mobile::Status::INVALID_DATA);
+        REQUIRE(response.frame.data == vector<uint8_t>{0x02});
+        REQUIRE_FALSE(bridge->getLastError().empty());
+    }
+
+    SECTION("NAK error code") {
+        auto bridge = makeBridge(mock, encodeFrame(0x01, 0x15, {0x10, 0x01}));
+        auto response = bridge->sendFrame(mobile::Frame(0x01, 0x10), 200);
+        REQUIRE(response.status == mobile::Status::INVALID_COMMAND);
+    }
+
+    SECTION("Timeout") {
+        auto bridge = makeBridge(mock);
+        auto response = bridge->sendFrame(mobile::Frame(0x01, 0x10), 50);
+        REQUIRE(response.status == mobile::Status::TIMEOUT);
+    }
+}
+
+TEST_CASE("MobileBridgeImpl accepts data received by the host") {
+    MockTransport* mock = nullptr;
+    auto bridge = makeBridge(mock);
+
+    atomic<bool> answered{false};
+    bridge->sendFrameAsync(mobile::Frame(0x02, 0x10), [&](const mobile::Response& response) {
+        answered = response.frame.ecu_id == 0x82;
+    }, nullptr);
+
+    auto bytes = encodeFrame(0x82, 0x10, {0x00, 0x01});
+    bridge->processIncomingData(bytes.data(), bytes.size());
+    REQUIRE(answered);
+}
+
+TEST_CASE("The C interface creates and destroys bridges") {
+    auto* engine = createProtocolEngineWithTransport(static_cast<int>(transport::TransportFactory::Type::MOCK));
+    REQUIRE(engine != nullptr);
+    REQUIRE(engine->initialize("mock"));
+    engine->disconnect();
+    REQUIRE_FALSE(engine->isConnected());
+    destroyProtocolEngine(engine);
+
+    auto* unsupported = createProtocolEngineWithTransport(static_cast<int>(transport::TransportFactory::Type::BLUETOOTH));
+    REQUIRE_FALSE(unsupported->initialize("bt0"));
+    REQUIRE_FALSE(unsupported->getLastError().empty());
+    destroyProtocolEngine(unsupported);
+}
+
+// Caller side of the completion ring: take every published record
+static vector<mobile::CompletionRecord> pollRing(mobile::CompletionRing& ring) {
+    vector<mobile::CompletionRecord> records;
+    const uint32_t head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+    for (uint32_t tail = ring.tail; tail != head; ++tail) {
+        records.push_back(ring.records[tail & (ring.capacity - 1)]);
+    }
+    __atomic_store_n(&ring.tail, head, __ATOMIC_RELEASE);
+    return records;
+}
+
+TEST_CASE("The batched C interface completes requests into a caller-provided ring") {
+    MockTransport* mock = nullptr;
+    auto bridge = makeBridge(mock, encodeFrame(0x81, 0x10, {0x00, 0x12, 0x34}));
+    mobile::IProtocolEngine* engine = bridge.get();
+
+    // Three requests to ECU 0x01: [ECU_ID][CMD][DATA_LEN][DATA...]
+    const vector<uint8_t> batch = {0x01, 0x10, 0x02, 0xF1, 0x90,
+                                   0x01, 0x10, 0x00,
+                                   0x01, 0x10, 0x01, 0x07};
+    uint32_t first_id = 0;
+    REQUIRE(submitFrameBatch(engine, batch.data(), batch.size(), &first_id) == -1);   // no ring yet
+
+    vector<mobile::CompletionRecord> storage(4);
+    mobile::CompletionRing ring{storage.data(), static_cast<uint32_t>(storage.size()), 0, 0};
+    mobile::CompletionRing odd{storage.data(), 3, 0, 0};
+    REQUIRE_FALSE(attachCompletionRing(engine, &odd));
+    REQUIRE(attachCompletionRing(engine, &ring));
+
+    SECTION("Responses are polled without callbacks") {
+        REQUIRE(submitFrameBatch(engine, batch.data(), batch.size(), &first_id) == 3);
+        vector<mobile::CompletionRecord> records;
+        const auto deadline = chrono::steady_clock::now() + chrono::seconds(2);
+        while (records.size() < 3 && chrono::steady_clock::now() < deadline) {
+            auto polled = pollRing(ring);
+            records.insert(records.end(), polled.begin(), polled.end());
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        REQUIRE(records.size() == 3);
+        for (uint32_t i = 0; i < 3; ++i) {
+            // One ECU has one request in flight, so they complete in order
+            REQUIRE(records[i].request_id == first_id + i);
+            REQUIRE(records[i].status == static_cast<uint8_t>(mobile::Status::SUCCESS));
+            REQUIRE(records[i].ecu_id == 0x81);
+            REQUIRE(vector<uint8_t>(records[i].data, records[i].data + records[i].data_length) ==
+                    vector<uint8_t>{0x00, 0x12, 0x34});
+        }
+        REQUIRE(mock->getLastSentData() == encodeFrame(0x01, 0x10, {0x07}));
+    }
+
+    SECTION("Submissions are limited to the free ring records") {
+        const vector<uint8_t> record = {0x01, 0x10, 0x00};
+        vector<uint8_t> six;
+        for (int i = 0; i < 6; ++i) {
+            six.insert(six.end(), record.begin(), record.end());
+        }
+        REQUIRE(submitFrameBatch(engine, six.data(), six.size(), &first_id) == 4);
+        REQUIRE(submitFrameBatch(engine, six.data(), six.size(), nullptr) == 0);
+        REQUIRE_FALSE(attachCompletionRing(engine, nullptr));      // still in flight
+
+        size_t polled = 0;
+        const auto deadline = chrono::steady_clock::now() + chrono::seconds(2);
+        while (polled < 4 && chrono::steady_clock::now() < deadline) {
+            polled += pollRing(ring).size();
+        }
+        REQUIRE(polled == 4);
+        uint32_t next_id = 0;
+        REQUIRE(submitFrameBatch(engine, six.data(), 2 * 3, &next_id) == 2);
+        REQUIRE(next_id == first_id + 4);
+    }
+
+    SECTION("Malformed batches send nothing") {
+        const vector<uint8_t> truncated = {0x01, 0x10, 0x02, 0xF1};
+        REQUIRE(submitFrameBatch(engine, truncated.data(), truncated.size(), &first_id) == -1);
+        REQUIRE(bridge->getLastError().find("Malformed request batch") == 0);
+        REQUIRE(mock->getLastSentData().empty());
+    }
+
+    // The ring must outlive the requests the engine still owns
+    bridge.reset();
+}
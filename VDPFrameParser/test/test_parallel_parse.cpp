@@ -0,0 +1,161 @@
+//
+// parallelParse tests: results must match a single sequential extractFrames()
+//
+#include "catch2/catch_all.hpp"
+#include "parallel_parse.h"
+
+#include <random>
+
+using namespace std;
+using namespace vdp;
+
+// Valid frames, corrupted frames and noise, with plenty of 0x7E inside
+// frames and noise so chunk parses start at false frame starts
+static vector<uint8_t> makeCapture(size_t size, uint32_t seed) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> byte_dist(0, 255);
+    VdpParser codec;
+    vector<uint8_t> capture;
+    vector<uint8_t> frame_bytes;
+    while (capture.size() < size) {
+        switch (byte_dist(rng) % 4) {
+            case 0: {   // noise, sometimes a START byte with a plausible length
+                const int count = byte_dist(rng) % 32;
+                for (int i = 0; i < count; ++i) {
+                    capture.push_back(i % 5 == 0 ? 0x7E : static_cast<uint8_t>(byte_dist(rng)));
+                }
+                break;
+            }
+            default: {  // a frame, with DATA full of START bytes, sometimes corrupted
+                VdpFrame frame{static_cast<uint8_t>(byte_dist(rng)), static_cast<uint8_t>(byte_dist(rng)), {}};
+                frame.data.resize(byte_dist(rng) % 64);
+                for (auto& b : frame.data) {
+                    b = byte_dist(rng) % 3 == 0 ? 0x7E : static_cast<uint8_t>(byte_dist(rng));
+                }
+                codec.serializeFrame(frame, frame_bytes);
+                if (byte_dist(rng) % 8 == 0) {
+                    frame_bytes[static_cast<size_t>(byte_dist(rng)) % frame_bytes.size()] ^= 0x5A;
+                }
+                capture.insert(capture.end(), frame_bytes.begin(), frame_bytes.end());
+                break;
+            }
+        }
+    }
+    return capture;
+}
+
+static vector<ParseResult> parseSequentially(const vector<uint8_t>& capture) {
+    VdpParser parser;
+    parser.feed(capture.data(), capture.size());
+    return parser.extractFrames();
+}
+
+static void requireSame(const vector<ParseResult>& actual, const vector<ParseResult>& expected) {
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        INFO("result " << i);
+        REQUIRE(actual[i].status == expected[i].status);
+        REQUIRE(actual[i].raw_bytes == expected[i].raw_bytes);
+        REQUIRE(actual[i].frame.has_value() == expected[i].frame.has_value());
+        if (expected[i].frame) {
+            REQUIRE(actual[i].frame->ecu_id == expected[i].frame->ecu_id);
+            REQUIRE(actual[i].frame->command == expected[i].frame->command);
+            REQUIRE(actual[i].frame->data == expected[i].frame->data);
+        }
+        REQUIRE(actual[i].error_detail.code == expected[i].error_detail.code);
+        REQUIRE(actual[i].error_detail.length == expected[i].error_detail.length);
+        REQUIRE(actual[i].error_detail.position == expected[i].error_detail.position);
+        REQUIRE(actual[i].error_detail.offset == expected[i].error_detail.offset);
+        REQUIRE(actual[i].message() == expected[i].message());
+    }
+}
+
+TEST_CASE("parallelParse matches sequential parsing") {
+    for (uint32_t seed = 1; seed <= 8; ++seed) {
+        const auto capture = makeCapture(200 * 1024, seed);
+        const auto expected = parseSequentially(capture);
+        REQUIRE(expected.size() > 1000);
+
+        for (size_t threads : {1, 2, 3, 8, 37}) {
+            INFO("seed " << seed << ", threads " << threads);
+            requireSame(parallelParse({capture.data(), capture.size()}, threads, 256), expected);
+        }
+    }
+}
+
+TEST_CASE("parallelParse replays a chunk whose parse started at a false frame") {
+    // A frame straddles the boundary of two 1000-byte chunks. Its DATA holds
+    // the start of a well-formed false frame that ends past the next real
+    // frame, so the second chunk's own parse skips the real frame.
+    VdpParser codec;
+    vector<uint8_t> real_frame;
+    codec.serializeFrame(VdpFrame{0x81, 0x10, {0x01, 0x02, 0x03}}, real_frame);
+
+    VdpFrame outer{0x01, 0x10, {}};
+    outer.data.assign(30, 0x00);
+    const size_t false_start = 20;   // in DATA
+    vector<uint8_t> outer_bytes;
+    codec.serializeFrame(outer, outer_bytes);
+    const size_t false_length = outer_bytes.size() - (4 + false_start) + real_frame.size() + 2;
+    outer.data[false_start] = 0x7E;
+    outer.data[false_start + 1] = static_cast<uint8_t>(false_length);
+    codec.serializeFrame(outer, outer_bytes);
+
+    vector<uint8_t> capture(990, 0x00);
+    capture.insert(capture.end(), outer_bytes.begin(), outer_bytes.end());
+    capture.insert(capture.end(), real_frame.begin(), real_frame.end());
+    // Checksum and end marker of the false frame
+    uint8_t checksum = 0;
+    for (size_t i = 990 + 4 + false_start + 1; i < capture.size(); ++i) {
+        checksum ^= capture[i];
+    }
+    capture.push_back(checksum);
+    capture.push_back(0x7F);
+    capture.resize(2000, 0x00);
+
+    const auto expected = parseSequentially(capture);
+    REQUIRE(expected.size() == 2);
+    REQUIRE(expected[1].raw_bytes == real_frame);
+    {
+        // Parsed on its own, the second chunk does see the false frame
+        VdpParser parser;
+        parser.feed(capture.data() + 1000, capture.size() - 1000);
+        const auto alone = parser.extractFrames();
+        REQUIRE(alone.size() == 1);
+        REQUIRE(alone[0].status == ParseStatus::Success);
+        REQUIRE(alone[0].raw_bytes.size() == false_length);
+    }
+    requireSame(parallelParse({capture.data(), capture.size()}, 2, 1), expected);
+}
+
+TEST_CASE("parallelParse stops at a frame cut off by the end of input") {
+    auto capture = makeCapture(64 * 1024, 99);
+    // START, LEN 40, then far fewer bytes: sequential parsing waits for the rest
+    capture.insert(capture.end(), {0x7E, 40, 0x01, 0x02, 0x7E, 0x06, 0x01, 0x02, 0x07, 0x7F});
+    const auto expected = parseSequentially(capture);
+
+    for (size_t threads : {1, 4, 16}) {
+        requireSame(parallelParse({capture.data(), capture.size()}, threads, 256), expected);
+    }
+}
+
+TEST_CASE("parallelParseViews borrow from the input") {
+    const auto capture = makeCapture(32 * 1024, 7);
+    const auto expected = parseSequentially(capture);
+    const auto views = parallelParseViews({capture.data(), capture.size()}, 4, 1024);
+
+    REQUIRE(views.size() == expected.size());
+    for (size_t i = 0; i < views.size(); ++i) {
+        REQUIRE(views[i].raw_bytes.data >= capture.data());
+        REQUIRE(views[i].raw_bytes.data + views[i].raw_bytes.size <= capture.data() + capture.size());
+        REQUIRE(vector<uint8_t>(views[i].raw_bytes.begin(), views[i].raw_bytes.end()) == expected[i].raw_bytes);
+    }
+}
+
+TEST_CASE("parallelParse handles inputs without frames") {
+    const vector<uint8_t> empty;
+    REQUIRE(parallelParse({empty.data(), empty.size()}, 4).empty());
+
+    const vector<uint8_t> noise(10000, 0x55);
+    REQUIRE(parallelParse({noise.data(), noise.size()}, 4, 100).empty());
+}
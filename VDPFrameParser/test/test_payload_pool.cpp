@@ -0,0 +1,125 @@
+//
+// PayloadPool, PoolAllocator and ObjectPool tests: size classes, reuse and pooled frames
+//
+#include "catch2/catch_all.hpp"
+#include "object_pool.h"
+#include "vdp_parser.h"
+
+#include <functional>
+
+using namespace std;
+using namespace vdp;
+
+TEST_CASE("PayloadPool serves requests from size classes and reuses chunks") {
+    REQUIRE(PayloadPool::classSize(1) == 16);
+    REQUIRE(PayloadPool::classSize(17) == 32);
+    REQUIRE(PayloadPool::classSize(247) == 256);
+
+    PayloadPool pool;
+    void* a = pool.allocate(200);
+    void* b = pool.allocate(247);
+    REQUIRE(a != b);
+    REQUIRE(pool.inUse() == 2);
+    REQUIRE(pool.blockCount() == 1);
+
+    pool.deallocate(a, 200);
+    // Same class, the freed chunk comes straight back
+    REQUIRE(pool.allocate(130) == a);
+
+    // One block holds BLOCK_SIZE / 16 of the smallest chunks
+    vector<void*> small;
+    for (size_t i = 0; i < PayloadPool::BLOCK_SIZE / 16; ++i) {
+        small.push_back(pool.allocate(8));
+    }
+    REQUIRE(pool.blockCount() == 2);
+    for (void* p : small) {
+        pool.deallocate(p, 8);
+    }
+
+    // Larger requests bypass the pool
+    void* large = pool.allocate(1024);
+    REQUIRE(pool.inUse() == 2);
+    pool.deallocate(large, 1024);
+    pool.deallocate(b, 247);
+    pool.deallocate(a, 130);
+    REQUIRE(pool.inUse() == 0);
+}
+
+TEST_CASE("Pooled frames keep their DATA in the pool") {
+    PayloadPool pool;
+    PoolAllocator<uint8_t> allocator(pool);
+    REQUIRE(allocator == PoolAllocator<uint8_t>(pool));
+    REQUIRE(allocator != PoolAllocator<uint8_t>());
+
+    VdpParser parser;
+    vector<uint8_t> bytes;
+    parser.serializeFrame({0x81, 0x10, {0x00, 0x12, 0x34}}, bytes);
+    parser.feed(bytes.data(), bytes.size());
+
+    vector<PooledVdpFrame> frames;
+    parser.extractFrameViews([&](const ParseResultView& view) {
+        frames.push_back(view.frame.toFrame(allocator));
+    });
+    REQUIRE(frames.size() == 1);
+    REQUIRE(frames[0].ecu_id == 0x81);
+    REQUIRE(frames[0].data == vector<uint8_t, PoolAllocator<uint8_t>>({0x00, 0x12, 0x34}, allocator));
+    REQUIRE(pool.inUse() == 1);
+
+    // Copies draw from the same pool, freeing returns the chunks
+    PooledVdpFrame copy = frames[0];
+    REQUIRE(copy.data.get_allocator().pool() == &pool);
+    REQUIRE(pool.inUse() == 2);
+    frames.clear();
+    copy.data = {};
+    copy.data.shrink_to_fit();
+    REQUIRE(pool.inUse() == 0);
+}
+
+TEST_CASE("ObjectPool hands out a fixed number of objects") {
+    ObjectPool<function<int()>> pool(3);
+    REQUIRE(pool.capacity() == 3);
+
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    auto c = pool.acquire();
+    REQUIRE(pool.full());
+    REQUIRE(pool.acquire() == ObjectPool<function<int()>>::NONE);
+
+    pool[b] = [] { return 42; };
+    REQUIRE(pool[b]() == 42);
+
+    // Released objects hold no state and are handed out again
+    pool.release(b);
+    REQUIRE(pool.size() == 2);
+    auto d = pool.acquire();
+    REQUIRE(d == b);
+    REQUIRE_FALSE(pool[d]);
+    pool.release(a);
+    pool.release(c);
+    pool.release(d);
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("IndexFifo chains pool objects in order") {
+    ObjectPool<int> pool(4);
+    IndexFifo fifo;
+    REQUIRE(fifo.empty());
+
+    for (int value : {1, 2, 3}) {
+        auto index = pool.acquire();
+        pool[index] = value;
+        fifo.pushBack(pool, index);
+    }
+    auto front = pool.acquire();
+    pool[front] = 0;
+    fifo.pushFront(pool, front);
+
+    vector<int> order;
+    while (!fifo.empty()) {
+        auto index = fifo.popFront(pool);
+        order.push_back(pool[index]);
+        pool.release(index);
+    }
+    REQUIRE(order == vector<int>{0, 1, 2, 3});
+    REQUIRE(pool.size() == 0);
+}
@@ -0,0 +1,95 @@
+//
+// PendingRequestTable tests: per-key FIFO order, handle removal and growth
+//
+#include "catch2/catch_all.hpp"
+#include "pending_request_table.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace vdp;
+
+using Table = PendingRequestTable<string>;
+
+TEST_CASE("Entries are matched oldest first per (ECU, command)") {
+    Table table;
+    table.insert(0x01, 0x10, "a");
+    table.insert(0x02, 0x10, "b");
+    table.insert(0x01, 0x10, "c");
+    table.insert(0x01, 0x20, "d");
+    REQUIRE(table.size() == 4);
+
+    string out;
+    // The response bit of the ECU id is ignored
+    REQUIRE(table.takeOldest(0x81, 0x10, out));
+    REQUIRE(out == "a");
+    REQUIRE(table.takeOldest(0x01, 0x10, out));
+    REQUIRE(out == "c");
+    REQUIRE_FALSE(table.takeOldest(0x01, 0x10, out));
+    REQUIRE(table.takeOldest(0x02, 0x10, out));
+    REQUIRE(out == "b");
+    REQUIRE(table.takeOldest(0x01, 0x20, out));
+    REQUIRE(out == "d");
+    REQUIRE(table.empty());
+}
+
+TEST_CASE("Commands outside the protocol share a bucket but still match exactly") {
+    Table table;
+    table.insert(0x05, 0x99, "x");
+    table.insert(0x05, 0x98, "y");
+
+    string out;
+    REQUIRE(table.takeOldest(0x05, 0x98, out));
+    REQUIRE(out == "y");
+    REQUIRE_FALSE(table.takeOldest(0x05, 0x97, out));
+    REQUIRE(table.takeOldest(0x05, 0x99, out));
+    REQUIRE(out == "x");
+}
+
+TEST_CASE("Handles remove entries from the middle of a FIFO and go stale") {
+    Table table;
+    table.insert(0x01, 0x10, "a");
+    auto middle = table.insert(0x01, 0x10, "b");
+    table.insert(0x01, 0x10, "c");
+
+    string out;
+    REQUIRE(table.take(middle, out));
+    REQUIRE(out == "b");
+    REQUIRE_FALSE(table.take(middle, out));
+    REQUIRE_FALSE(table.take(Table::INVALID_HANDLE, out));
+
+    // The freed slot is reused under a new generation
+    auto reused = table.insert(0x01, 0x10, "d");
+    REQUIRE(reused != middle);
+    REQUIRE_FALSE(table.take(middle, out));
+
+    vector<string> order;
+    while (table.takeOldest(0x01, 0x10, out)) {
+        order.push_back(out);
+    }
+    REQUIRE(order == vector<string>{"a", "c", "d"});
+}
+
+TEST_CASE("Table grows past its initial capacity without losing entries") {
+    Table table(2);
+    vector<Table::Handle> handles;
+    for (int i = 0; i < 100; ++i) {
+        handles.push_back(table.insert(static_cast<uint8_t>(i % 4), 0x10, to_string(i)));
+    }
+    REQUIRE(table.size() == 100);
+    REQUIRE(table.capacity() >= 100);
+
+    size_t visited = 0;
+    table.forEach([&](Table::Handle, const string&) { ++visited; });
+    REQUIRE(visited == 100);
+
+    string out;
+    REQUIRE(table.take(handles[42], out));
+    REQUIRE(out == "42");
+
+    vector<string> drained;
+    table.drain(drained);
+    REQUIRE(drained.size() == 99);
+    REQUIRE(table.empty());
+    REQUIRE_FALSE(table.takeOldest(0x00, 0x10, out));
+}
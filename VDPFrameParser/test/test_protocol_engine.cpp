@@ -0,0 +1,508 @@
+//
+// VDPEngine tests: request tracking, response matching and timeouts
+//
+#include "catch2/catch_all.hpp"
+#include "protocol_engine.h"
+#include "test_frames.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+using namespace vdp;
+using namespace vdp::protocol;
+
+// In-memory transport: records what the engine sends and lets the test inject replies
+class LoopbackTransport : public transport::ITransport {
+public:
+    using Responder = function<vector<uint8_t>(const vector<uint8_t>& sent)>;
+
+    bool initialize(const string&) override { connected_ = true; return true; }
+    bool send(const uint8_t* data, size_t length) override {
+        vector<uint8_t> bytes(data, data + length);
+        Responder responder;
+        {
+            lock_guard<mutex> lock(mutex_);
+            sent_.push_back(bytes);
+            responder = responder_;
+        }
+        if (responder) {
+            inject(responder(bytes));
+        }
+        return connected_;
+    }
+    void setDataCallback(DataCallback callback) override { data_callback_ = std::move(callback); }
+    void setErrorCallback(ErrorCallback callback) override { error_callback_ = std::move(callback); }
+    bool isConnected() const override { return connected_; }
+    void disconnect() override { connected_ = false; }
+    string getLastError() const override { return ""; }
+
+    void inject(const vector<uint8_t>& bytes) {
+        if (!bytes.empty() && data_callback_) {
+            data_callback_(bytes.data(), bytes.size());
+        }
+    }
+    void setResponder(Responder responder) {
+        lock_guard<mutex> lock(mutex_);
+        responder_ = std::move(responder);
+    }
+    vector<vector<uint8_t>> sent() const {
+        lock_guard<mutex> lock(mutex_);
+        return sent_;
+    }
+
+private:
+    DataCallback data_callback_;
+    ErrorCallback error_callback_;
+    atomic<bool> connected_{false};
+    mutable mutex mutex_;
+    vector<vector<uint8_t>> sent_;
+    Responder responder_;
+};
+
+// Requests are paced by the inter-frame delay, wait until count of them went out
+static bool waitForSent(const LoopbackTransport& transport, size_t count) {
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(2);
+    while (transport.sent().size() < count) {
+        if (chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return true;
+}
+
+struct EngineFixture {
+    LoopbackTransport* transport;
+    unique_ptr<VDPEngine> engine;
+
+    EngineFixture() {
+        auto owned = make_unique<LoopbackTransport>();
+        transport = owned.get();
+        engine = make_unique<VDPEngine>(std::move(owned));
+        REQUIRE(engine->initialize("loopback"));
+    }
+};
+
+TEST_CASE("VDPEngine matches responses to pending requests") {
+    EngineFixture f;
+    f.transport->setResponder([](const vector<uint8_t>& sent) {
+        // Echo back a success response from the addressed ECU
+        return encodeFrame(sent[2] | 0x80, sent[3], {0x00, 0x12, 0x34});
+    });
+
+    Response response = f.engine->sendFrame({0x01, 0x10, {0x00, 0x01}}, 500);
+    REQUIRE(response.status == Status::Success);
+    REQUIRE(response.frame.ecu_id == 0x81);
+    REQUIRE(response.frame.data == vector<uint8_t>{0x00, 0x12, 0x34});
+    REQUIRE(f.engine->pendingRequestCount() == 0);
+
+    // The request went out serialized
+    REQUIRE(f.transport->sent().front() == encodeFrame(0x01, 0x10, {0x00, 0x01}));
+}
+
+TEST_CASE("VDPEngine reports timeouts and NAKs") {
+    EngineFixture f;
+
+    SECTION("No response times out") {
+        auto start = chrono::steady_clock::now();
+        Response response = f.engine->sendFrame({0x02, 0x10, {}}, 50);
+        REQUIRE(response.status == Status::Timeout);
+        REQUIRE(chrono::steady_clock::now() - start >= chrono::milliseconds(50));
+        REQUIRE(f.engine->pendingRequestCount() == 0);
+    }
+
+    SECTION("NAK completes the request with an error") {
+        f.transport->setResponder([](const vector<uint8_t>& sent) {
+            return encodeFrame(sent[2] | 0x80, 0x15, {sent[3], 0x03});
+        });
+        Response response = f.engine->sendFrame({0x02, 0x20, {0x01}}, 500);
+        REQUIRE(response.status == Status::Error);
+        REQUIRE(response.error_message == "NAK received: ECU Busy (0x03)");
+    }
+}
+
+TEST_CASE("VDPEngine async requests complete from the receive path") {
+    EngineFixture f;
+    f.engine->setDefaultTimeout(chrono::milliseconds(1000));
+
+    mutex mtx;
+    vector<string> events;
+    f.engine->sendFrameAsync({0x03, 0x30, {}},
+        [&](const Response& r) { lock_guard<mutex> lock(mtx); events.push_back("ok " + to_string(r.frame.ecu_id)); },
+        [&](const string& e) { lock_guard<mutex> lock(mtx); events.push_back("error " + e); });
+    f.engine->sendFrameAsync({0x04, 0x30, {}},
+        [&](const Response&) { lock_guard<mutex> lock(mtx); events.push_back("ok 4"); },
+        [&](const string& e) { lock_guard<mutex> lock(mtx); events.push_back("error " + e); });
+    REQUIRE(f.engine->pendingRequestCount() == 2);
+    REQUIRE(waitForSent(*f.transport, 2));
+
+    // Second ECU answers first, in a single chunk with an unrelated keep-alive
+    vector<uint8_t> rx = encodeFrame(0x84, 0x30, {0x00});
+    auto keep_alive = encodeFrame(0x85, 0x50, {0x00});
+    rx.insert(rx.end(), keep_alive.begin(), keep_alive.end());
+    f.transport->inject(rx);
+    f.transport->inject(encodeFrame(0x83, 0x30, {0x00}));
+
+    REQUIRE(events == vector<string>{"ok 4", "ok 131"});
+    REQUIRE(f.engine->pendingRequestCount() == 0);
+}
+
+TEST_CASE("VDPEngine NAKs responses with invalid commands or status codes") {
+    EngineFixture f;
+
+    f.transport->inject(encodeFrame(0x81, 0x99, {0x00}));
+    REQUIRE(f.transport->sent().size() == 1);
+    REQUIRE(f.transport->sent().back() == encodeFrame(0x01, 0x15, {0x99, 0x01}));
+
+    f.transport->setResponder([](const vector<uint8_t>& sent) {
+        return sent[3] == 0x15 ? vector<uint8_t>{} : encodeFrame(sent[2] | 0x80, sent[3], {0x80});
+    });
+    Response response = f.engine->sendFrame({0x01, 0x10, {}}, 500);
+    REQUIRE(response.status == Status::Error);
+    REQUIRE(f.transport->sent().back() == encodeFrame(0x01, 0x15, {0x10, 0x80}));
+}
+
+// Transport with a native vectored send, records how requests are handed over
+class VectoredTransport : public LoopbackTransport {
+public:
+    bool sendv(const transport::IoSlice* slices, size_t count) override {
+        slice_counts_.push_back(count);
+        return transport::ITransport::sendv(slices, count);
+    }
+    vector<size_t> slice_counts_;
+};
+
+TEST_CASE("VDPEngine sends requests as header/payload/footer slices") {
+    auto owned = make_unique<VectoredTransport>();
+    VectoredTransport* transport = owned.get();
+    VDPEngine engine(std::move(owned));
+    REQUIRE(engine.initialize("loopback"));
+    transport->setResponder([](const vector<uint8_t>& sent) {
+        return encodeFrame(sent[2] | 0x80, sent[3], {0x00});
+    });
+
+    Response response = engine.sendFrame({0x01, 0x10, {0x00, 0x01}}, 500);
+    REQUIRE(response.status == Status::Success);
+    REQUIRE(transport->slice_counts_ == vector<size_t>{3});
+    // The default sendv() gathers slices into the exact serialized frame
+    REQUIRE(transport->sent().front() == encodeFrame(0x01, 0x10, {0x00, 0x01}));
+}
+
+TEST_CASE("VDPEngine keeps one request in flight per ECU") {
+    EngineFixture f;
+    f.engine->setInterFrameDelay(chrono::microseconds(0));
+
+    mutex mtx;
+    vector<Response> responses;
+    bool done = false;
+    f.engine->submitBatch({{0x01, 0x10, {0x01}}, {0x01, 0x10, {0x02}}, {0x02, 0x10, {0x03}}},
+                          [&](const vector<Response>& all) {
+        lock_guard<mutex> lock(mtx);
+        responses = all;
+        done = true;
+    });
+
+    // Both ECUs are addressed at once, the second request to ECU 1 waits
+    REQUIRE(waitForSent(*f.transport, 2));
+    this_thread::sleep_for(chrono::milliseconds(20));
+    REQUIRE(f.transport->sent().size() == 2);
+    REQUIRE(f.engine->pendingRequestCount() == 3);
+
+    f.transport->inject(encodeFrame(0x81, 0x10, {0x00, 0xA1}));
+    REQUIRE(waitForSent(*f.transport, 3));
+    REQUIRE(f.transport->sent()[2] == encodeFrame(0x01, 0x10, {0x02}));
+
+    f.transport->inject(encodeFrame(0x82, 0x10, {0x00, 0xB1}));
+    f.transport->inject(encodeFrame(0x81, 0x10, {0x00, 0xA2}));
+
+    lock_guard<mutex> lock(mtx);
+    REQUIRE(done);
+    REQUIRE(responses.size() == 3);
+    // Responses are reported in submission order, not arrival order
+    REQUIRE(responses[0].frame.data == vector<uint8_t>{0x00, 0xA1});
+    REQUIRE(responses[1].frame.data == vector<uint8_t>{0x00, 0xA2});
+    REQUIRE(responses[2].frame.data == vector<uint8_t>{0x00, 0xB1});
+}
+
+TEST_CASE("VDPEngine batches are paced by the inter-frame delay") {
+    EngineFixture f;
+    mutex mtx;
+    vector<chrono::steady_clock::time_point> send_times;
+    f.transport->setResponder([&](const vector<uint8_t>& sent) {
+        {
+            lock_guard<mutex> lock(mtx);
+            send_times.push_back(chrono::steady_clock::now());
+        }
+        return encodeFrame(sent[2] | 0x80, sent[3], {0x00});
+    });
+
+    vector<Frame> frames;
+    for (uint8_t ecu = 1; ecu <= 6; ++ecu) {
+        frames.push_back({ecu, 0x10, {}});
+    }
+
+    mutex done_mtx;
+    condition_variable done_cv;
+    vector<Response> responses;
+    bool done = false;
+    f.engine->submitBatch(frames, [&](const vector<Response>& all) {
+        lock_guard<mutex> lock(done_mtx);
+        responses = all;
+        done = true;
+        done_cv.notify_one();
+    });
+
+    unique_lock<mutex> done_lock(done_mtx);
+    REQUIRE(done_cv.wait_for(done_lock, chrono::seconds(2), [&] { return done; }));
+    REQUIRE(responses.size() == 6);
+    for (size_t i = 0; i < responses.size(); ++i) {
+        REQUIRE(responses[i].status == Status::Success);
+        REQUIRE(responses[i].frame.ecu_id == (0x80 | (i + 1)));
+    }
+
+    lock_guard<mutex> lock(mtx);
+    REQUIRE(send_times.size() == 6);
+    for (size_t i = 1; i < send_times.size(); ++i) {
+        // Dispatch is spaced by 5ms; allow for scheduling jitter between dispatch and send()
+        REQUIRE(send_times[i] - send_times[i - 1] >= chrono::microseconds(4000));
+    }
+}
+
+TEST_CASE("VDPEngine fails oversized requests without sending anything") {
+    EngineFixture f;
+
+    // A batch holding one oversized frame is refused whole
+    vector<Response> responses;
+    f.engine->submitBatch({{0x01, 0x10, {0x01}}, {0x02, 0x10, vector<uint8_t>(MAX_DATA_SIZE + 1)}},
+                          [&](const vector<Response>& all) { responses = all; });
+    REQUIRE(responses.size() == 2);
+    REQUIRE(responses[0].status == Status::Error);
+    REQUIRE(responses[1].status == Status::Error);
+    REQUIRE(responses[1].error_message == "Frame data too large");
+
+    string error;
+    f.engine->sendFrameAsync({0x01, 0x10, vector<uint8_t>(MAX_DATA_SIZE + 1)}, nullptr,
+                             [&](const string& e) { error = e; });
+    REQUIRE(error == "Frame data too large");
+    REQUIRE(f.engine->pendingRequestCount() == 0);
+    REQUIRE(f.transport->sent().empty());
+}
+
+TEST_CASE("VDPEngine completes an empty batch immediately") {
+    EngineFixture f;
+    bool called = false;
+    f.engine->submitBatch({}, [&](const vector<Response>& all) { called = all.empty(); });
+    REQUIRE(called);
+}
+
+TEST_CASE("VDPEngine retries timed out and busy requests per command policy") {
+    EngineFixture f;
+    f.engine->setInterFrameDelay(chrono::microseconds(0));
+
+    RetryPolicy policy;
+    policy.max_retries = 2;
+    policy.base_backoff = chrono::milliseconds(5);
+    f.engine->setRetryPolicy(CommandType::ReadData, policy);
+    REQUIRE(f.engine->retryPolicy(CommandType::ReadData).max_retries == 2);
+    REQUIRE(f.engine->retryPolicy(CommandType::WriteData).max_retries == 0);
+
+    SECTION("Timeouts are retried, the last attempt completes the request") {
+        Response response = f.engine->sendFrame({0x02, 0x10, {}}, 20);
+        REQUIRE(response.status == Status::Timeout);
+        REQUIRE(f.transport->sent().size() == 3);
+        EcuStats stats = f.engine->ecuStats(0x02);
+        REQUIRE(stats.timeouts == 3);
+        REQUIRE(stats.retries == 2);
+    }
+
+    SECTION("A busy ECU is asked again") {
+        atomic<int> calls{0};
+        f.transport->setResponder([&](const vector<uint8_t>& sent) {
+            // First answer is a busy NAK, then a busy response, then success
+            switch (calls++) {
+                case 0: return encodeFrame(sent[2] | 0x80, 0x15, {sent[3], 0x03});
+                case 1: return encodeFrame(sent[2] | 0x80, sent[3], {0x03});
+                default: return encodeFrame(sent[2] | 0x80, sent[3], {0x00, 0x42});
+            }
+        });
+        Response response = f.engine->sendFrame({0x03, 0x10, {}}, 500);
+        REQUIRE(response.status == Status::Success);
+        REQUIRE(response.frame.data == vector<uint8_t>{0x00, 0x42});
+        EcuStats stats = f.engine->ecuStats(0x83);
+        REQUIRE(stats.ecu_id == 0x03);
+        REQUIRE(stats.responses == 3);
+        REQUIRE(stats.retries == 2);
+        REQUIRE(stats.timeouts == 0);
+    }
+
+    SECTION("Commands without retries fail on the first timeout") {
+        Response response = f.engine->sendFrame({0x04, 0x20, {}}, 20);
+        REQUIRE(response.status == Status::Timeout);
+        REQUIRE(f.transport->sent().size() == 1);
+    }
+}
+
+TEST_CASE("VDPEngine tracks per-ECU latency and adapts timeouts") {
+    EngineFixture f;
+    f.engine->setInterFrameDelay(chrono::microseconds(0));
+    f.transport->setResponder([](const vector<uint8_t>& sent) {
+        return encodeFrame(sent[2] | 0x80, sent[3], {0x00});
+    });
+
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(f.engine->sendFrame({0x05, 0x10, {}}, 500).status == Status::Success);
+    }
+    REQUIRE(f.engine->sendFrame({0x06, 0x10, {}}, 500).status == Status::Success);
+
+    auto snapshot = f.engine->ecuStatsSnapshot();
+    REQUIRE(snapshot.size() == 2);
+    REQUIRE(snapshot[0].ecu_id == 0x05);
+    REQUIRE(snapshot[0].responses == 10);
+    REQUIRE(snapshot[1].ecu_id == 0x06);
+    // Loopback answers immediately, the estimate sits at the lower bound
+    REQUIRE(snapshot[0].adaptive_timeout == RetryPolicy{}.min_timeout);
+    REQUIRE(snapshot[1].adaptive_timeout == chrono::milliseconds(1000)); // too few samples
+
+    // The ECU has gone quiet: an adaptive policy gives up well before the requested timeout
+    RetryPolicy policy;
+    policy.adaptive_timeout = true;
+    f.engine->setRetryPolicy(CommandType::ReadData, policy);
+    f.transport->setResponder(nullptr);
+    auto start = chrono::steady_clock::now();
+    Response response = f.engine->sendFrame({0x05, 0x10, {}}, 2000);
+    REQUIRE(response.status == Status::Timeout);
+    REQUIRE(chrono::steady_clock::now() - start < chrono::milliseconds(1000));
+    REQUIRE(f.engine->ecuStats(0x05).timeouts == 1);
+}
+
+TEST_CASE("VDPEngine counts requests, replies, NAKs and timeouts") {
+    EngineFixture f;
+    f.engine->setInterFrameDelay(chrono::microseconds(0));
+    f.transport->setResponder([](const vector<uint8_t>& sent) {
+        switch (sent[3]) {
+            case 0x10:
+                return encodeFrame(sent[2] | 0x80, sent[3], {0x00});
+            case 0x20:
+                return encodeFrame(sent[2] | 0x80, 0x15, {sent[3], 0x03});
+            default:
+                return vector<uint8_t>{};
+        }
+    });
+
+    REQUIRE(f.engine->sendFrame({0x01, 0x10, {}}, 500).status == Status::Success);
+    REQUIRE(f.engine->sendFrame({0x01, 0x10, {}}, 500).status == Status::Success);
+    REQUIRE(f.engine->sendFrame({0x02, 0x20, {}}, 500).status == Status::Error);
+    REQUIRE(f.engine->sendFrame({0x03, 0x30, {}}, 20).status == Status::Timeout);
+
+    EngineMetricsSnapshot metrics = f.engine->metrics();
+    REQUIRE(metrics.queue_depth == 0);
+    if (!metrics::ENABLED) {
+        REQUIRE(metrics.requests == 0);
+        return;
+    }
+    REQUIRE(metrics.requests == 4);
+    REQUIRE(metrics.rejected == 0);
+    REQUIRE(metrics.responses == 3);
+    REQUIRE(metrics.timeouts == 1);
+    REQUIRE(metrics.naks == 1);
+    REQUIRE(metrics.naks_by_status[0x03] == 1);
+    REQUIRE(metrics.max_queue_depth == 1);
+    REQUIRE(metrics.round_trip_ns.count == 3);
+
+    // The engine's parser saw the three replies
+    REQUIRE(f.engine->parserMetrics().frames == 3);
+}
+
+TEST_CASE("VDPEngine rejects requests beyond its request capacity") {
+    // Declared before the engine: its destructor fails the requests still pending
+    mutex mtx;
+    vector<string> errors;
+
+    auto owned = make_unique<LoopbackTransport>();
+    VDPEngine engine(std::move(owned), 4);
+    REQUIRE(engine.initialize("loopback"));
+    engine.setDefaultTimeout(chrono::milliseconds(200));
+
+    for (int i = 0; i < 6; ++i) {
+        engine.sendFrameAsync({0x01, 0x10, {}}, nullptr, [&](const string& e) {
+            lock_guard<mutex> lock(mtx);
+            errors.push_back(e);
+        });
+    }
+    // The records are taken by the four accepted requests, the rest fail at once
+    REQUIRE(engine.pendingRequestCount() == 4);
+    {
+        lock_guard<mutex> lock(mtx);
+        REQUIRE(errors == vector<string>{"Too many pending requests", "Too many pending requests"});
+    }
+}
+
+#if defined(VDP_HAS_COROUTINES)
+// Fire-and-forget coroutine, runs until its first suspension when called
+struct DetachedSession {
+    struct promise_type {
+        DetachedSession get_return_object() { return {}; }
+        suspend_never initial_suspend() noexcept { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+};
+
+// Reads from the ECU until it stops answering with data, then records how many reads succeeded
+static DetachedSession readSession(VDPEngine& engine, uint8_t ecu_id, atomic<int>& finished, vector<int>& reads) {
+    int count = 0;
+    for (;;) {
+        Frame frame{ecu_id, 0x10, {}};
+        frame.data.push_back(static_cast<uint8_t>(count));
+        Response response = co_await engine.request(frame, chrono::milliseconds(500));
+        if (response.status != Status::Success || response.frame.data.size() < 2) {
+            break;
+        }
+        ++count;
+    }
+    reads[ecu_id] = count;
+    ++finished;
+}
+
+TEST_CASE("VDPEngine requests can be awaited from coroutines") {
+    EngineFixture f;
+    f.engine->setInterFrameDelay(chrono::microseconds(0));
+
+    SECTION("Dependent requests resume on the receive path") {
+        // Each answer carries the request's sequence byte, the third read returns no data
+        f.transport->setResponder([](const vector<uint8_t>& sent) {
+            return sent[4] < 2 ? encodeFrame(sent[2] | 0x80, sent[3], {0x00, sent[4]})
+                               : encodeFrame(sent[2] | 0x80, sent[3], {0x00});
+        });
+        atomic<int> finished{0};
+        vector<int> reads(128, -1);
+        for (uint8_t ecu = 1; ecu <= 50; ++ecu) {
+            readSession(*f.engine, ecu, finished, reads);
+        }
+
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(2);
+        while (finished < 50 && chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        REQUIRE(finished == 50);
+        for (uint8_t ecu = 1; ecu <= 50; ++ecu) {
+            REQUIRE(reads[ecu] == 2);
+        }
+        REQUIRE(f.transport->sent().size() == 150);
+        REQUIRE(f.engine->pendingRequestCount() == 0);
+    }
+
+    SECTION("A request completed during submission does not suspend") {
+        f.engine->disconnect();
+        atomic<int> finished{0};
+        vector<int> reads(128, -1);
+        readSession(*f.engine, 0x07, finished, reads);
+        // The send failed synchronously, the session ran to completion inside the call
+        REQUIRE(finished == 1);
+        REQUIRE(reads[0x07] == 0);
+    }
+}
+#endif
@@ -0,0 +1,115 @@
+//
+// TimerWheel tests: firing order, cancellation, cascading and next-deadline reporting
+//
+#include "catch2/catch_all.hpp"
+#include "timer_wheel.h"
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+using namespace vdp;
+
+using Clock = TimerWheel::Clock;
+
+static const Clock::time_point ORIGIN{};
+
+static vector<uint64_t> advanceTo(TimerWheel& wheel, Clock::time_point now) {
+    vector<uint64_t> fired;
+    wheel.advance(now, [&](uint64_t payload) { fired.push_back(payload); });
+    return fired;
+}
+
+TEST_CASE("Timers fire at their deadline, never before") {
+    TimerWheel wheel(ORIGIN);
+    wheel.arm(ORIGIN + milliseconds(10), 1);
+    wheel.arm(ORIGIN + microseconds(10500), 2); // rounds up to 11ms
+    REQUIRE(wheel.size() == 2);
+    REQUIRE(wheel.nextDeadline() == ORIGIN + milliseconds(10));
+
+    REQUIRE(advanceTo(wheel, ORIGIN + microseconds(9999)).empty());
+    REQUIRE(advanceTo(wheel, ORIGIN + milliseconds(10)) == vector<uint64_t>{1});
+    REQUIRE(advanceTo(wheel, ORIGIN + microseconds(10900)).empty());
+    REQUIRE(advanceTo(wheel, ORIGIN + milliseconds(11)) == vector<uint64_t>{2});
+    REQUIRE(wheel.empty());
+    REQUIRE(wheel.nextDeadline() == Clock::time_point::max());
+}
+
+TEST_CASE("Cancelled timers never fire and their ids go stale") {
+    TimerWheel wheel(ORIGIN);
+    auto a = wheel.arm(ORIGIN + milliseconds(100), 1);
+    auto b = wheel.arm(ORIGIN + milliseconds(100), 2);
+    REQUIRE(wheel.cancel(a));
+    REQUIRE_FALSE(wheel.cancel(a));
+    REQUIRE_FALSE(wheel.cancel(TimerWheel::INVALID_TIMER));
+
+    REQUIRE(advanceTo(wheel, ORIGIN + milliseconds(200)) == vector<uint64_t>{2});
+    REQUIRE_FALSE(wheel.cancel(b)); // already fired
+}
+
+TEST_CASE("Deadlines in the past fire on the next advance") {
+    TimerWheel wheel(ORIGIN);
+    advanceTo(wheel, ORIGIN + milliseconds(50));
+    wheel.arm(ORIGIN + milliseconds(10), 7);
+    REQUIRE(advanceTo(wheel, ORIGIN + milliseconds(50)).empty());
+    REQUIRE(advanceTo(wheel, ORIGIN + milliseconds(51)) == vector<uint64_t>{7});
+}
+
+TEST_CASE("Long timers cascade through every level and beyond the wheel's range") {
+    TimerWheel wheel(ORIGIN);
+    const vector<milliseconds> delays{milliseconds(63), milliseconds(64), milliseconds(4095), milliseconds(4097),
+                                      milliseconds(300000), hours(5), hours(30)};
+    for (size_t i = 0; i < delays.size(); ++i) {
+        wheel.arm(ORIGIN + delays[i], i);
+    }
+
+    // Walk the wheel by following nextDeadline(), as the engine's worker does
+    vector<pair<uint64_t, Clock::time_point>> fired;
+    int wakeups = 0;
+    while (!wheel.empty()) {
+        auto next = wheel.nextDeadline();
+        REQUIRE(next != Clock::time_point::max());
+        wheel.advance(next, [&](uint64_t payload) { fired.emplace_back(payload, next); });
+        REQUIRE(++wakeups < 1000);
+    }
+
+    REQUIRE(fired.size() == delays.size());
+    for (size_t i = 0; i < fired.size(); ++i) {
+        INFO("timer " << fired[i].first);
+        REQUIRE(fired[i].first == i);
+        REQUIRE(fired[i].second == ORIGIN + delays[i]);
+    }
+}
+
+TEST_CASE("Randomized timers fire exactly once, in deadline order") {
+    TimerWheel wheel(ORIGIN, 4);
+    mt19937 rng(7);
+    uniform_int_distribution<int> delay_ms(0, 20000);
+
+    vector<Clock::time_point> deadlines;
+    vector<TimerWheel::TimerId> ids;
+    for (int i = 0; i < 2000; ++i) {
+        deadlines.push_back(ORIGIN + milliseconds(delay_ms(rng)));
+        ids.push_back(wheel.arm(deadlines.back(), static_cast<uint64_t>(i)));
+    }
+    // Cancel every third timer
+    for (size_t i = 0; i < ids.size(); i += 3) {
+        REQUIRE(wheel.cancel(ids[i]));
+    }
+
+    vector<int> fire_count(deadlines.size(), 0);
+    Clock::time_point last = ORIGIN;
+    for (auto now = ORIGIN; now <= ORIGIN + milliseconds(20010); now += microseconds(7300)) {
+        wheel.advance(now, [&](uint64_t payload) {
+            ++fire_count[payload];
+            REQUIRE(deadlines[payload] <= now);
+            REQUIRE(deadlines[payload] > now - microseconds(7300) - milliseconds(1));
+            REQUIRE(deadlines[payload] >= last - microseconds(7300) - milliseconds(1));
+        });
+        last = now;
+    }
+    for (size_t i = 0; i < fire_count.size(); ++i) {
+        REQUIRE(fire_count[i] == (i % 3 == 0 ? 0 : 1));
+    }
+    REQUIRE(wheel.empty());
+}
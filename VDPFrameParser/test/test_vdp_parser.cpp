@@ -6,6 +6,7 @@
 #include "catch2/catch_all.hpp"
 #include "vdp_parser.h"
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <thread>
@@ -93,7 +94,7 @@ TEST_CASE("Error handling") {
         auto results = feedAll(p, frame);
         REQUIRE(results.size() == 1);
         REQUIRE(results[0].status == ParseStatus::Invalid);
-        REQUIRE(results[0].error.find("Checksum verification failed") != string::npos);
+        REQUIRE(results[0].message().find("Checksum verification failed") != string::npos);
     }
 
     // Test 2: Incomplete frame - should produce no results
@@ -124,7 +125,7 @@ TEST_CASE("Error handling") {
         auto results = feedAll(p, frame);
         REQUIRE(results.size() == 1);
         REQUIRE(results[0].status == ParseStatus::Invalid);
-        REQUIRE(results[0].error.find("End marker not found") != string::npos);
+        REQUIRE(results[0].message().find("End marker not found") != string::npos);
     }
 
     // Test 5: Invalid length (too short)
@@ -134,7 +135,7 @@ TEST_CASE("Error handling") {
         auto results = feedAll(p, frame);
         REQUIRE(results.size() == 1);
         REQUIRE(results[0].status == ParseStatus::Invalid);
-        REQUIRE(results[0].error.find("Invalid frame length") != string::npos);
+        REQUIRE(results[0].message().find("Invalid frame length") != string::npos);
     }
 }
 
@@ -163,7 +164,7 @@ TEST_CASE("Resynchronization after garbage") {
         auto results = feedAll(p, input);
         REQUIRE(results.size() == 2);
         REQUIRE(results[0].status == ParseStatus::Invalid);
-        REQUIRE(results[0].error == "Invalid frame length: 3");
+        REQUIRE(results[0].message() == "Invalid frame length: 3");
         REQUIRE(results[1].status == ParseStatus::Success);
         REQUIRE(results[1].frame->ecu_id == 0x01);
     }
@@ -178,7 +179,7 @@ TEST_CASE("Resynchronization after garbage") {
         auto results = feedAll(p, input);
         REQUIRE(results.size() == 2);
         REQUIRE(results[0].status == ParseStatus::Invalid);
-        REQUIRE(results[0].error.find("Checksum verification failed") != string::npos);
+        REQUIRE(results[0].message().find("Checksum verification failed") != string::npos);
         REQUIRE(results[1].status == ParseStatus::Success);
         REQUIRE(results[1].frame->ecu_id == 0x01);
     }
@@ -241,6 +242,81 @@ TEST_CASE("Partial frame across buffer boundaries") {
     }
 }
 
+TEST_CASE("Stale partial frames are dropped") {
+    VdpParser p(chrono::milliseconds(100));
+    auto frame = makeFrame(0x82, 0x10, {0x01, 0x02});
+    const auto t0 = chrono::steady_clock::now();
+
+    SECTION("A frame resumed before the timeout completes") {
+        p.feed(frame.data(), 4, RxTimestamp::fromSteady(t0));
+        REQUIRE(p.extractFrames().empty());
+        REQUIRE(p.extractFrames().empty());     // nothing new, still waiting
+        p.feed(frame.data() + 4, frame.size() - 4, RxTimestamp::fromSteady(t0 + chrono::milliseconds(150)));
+        auto results = p.extractFrames();
+        REQUIRE(results.size() == 1);
+        REQUIRE(results[0].status == ParseStatus::Success);
+    }
+
+    SECTION("Bytes after a gap restart the parse") {
+        // The remains of an earlier frame, then a whole frame after the line went quiet
+        p.feed(frame.data(), 4, RxTimestamp::fromSteady(t0));
+        REQUIRE(p.extractFrames().empty());
+        p.feed(frame.data(), frame.size(), RxTimestamp::fromSteady(t0 + chrono::milliseconds(300)));
+        auto results = p.extractFrames();
+        REQUIRE(results.size() == 2);
+        REQUIRE(results[0].status == ParseStatus::Invalid);
+        REQUIRE(results[0].error_detail.code == ParseError::Stale);
+        REQUIRE(results[0].message() == "Partial frame timed out after 4 bytes");
+        REQUIRE(results[0].raw_bytes == vector<uint8_t>(frame.begin(), frame.begin() + 4));
+        REQUIRE(results[1].status == ParseStatus::Success);
+        REQUIRE(results[1].raw_bytes == frame);
+    }
+
+    SECTION("A stale candidate's bytes do not overlap the frames after it") {
+        // A long LEN that covers the frames arriving after the gap
+        const vector<uint8_t> header = {0x7E, 0xC8, 0x82, 0x10};
+        p.feed(header.data(), header.size(), RxTimestamp::fromSteady(t0));
+        REQUIRE(p.extractFrames().empty());
+        vector<uint8_t> stream;
+        for (int i = 0; i < 40; ++i) {
+            stream.insert(stream.end(), frame.begin(), frame.end());
+        }
+        p.feed(stream.data(), stream.size(), RxTimestamp::fromSteady(t0 + chrono::milliseconds(300)));
+        auto results = p.extractFrames();
+        REQUIRE(results.size() == 41);
+        REQUIRE(results[0].error_detail.code == ParseError::Stale);
+        REQUIRE(results[0].raw_bytes == header);
+        REQUIRE(results[0].message() == "Partial frame timed out after 4 bytes");
+        size_t reported = 0;
+        for (const auto& result : results) {
+            reported += result.raw_bytes.size();
+        }
+        REQUIRE(reported == header.size() + stream.size());
+    }
+
+    SECTION("Waiting for LEN counts too") {
+        p.feed(frame.data(), 1, RxTimestamp::fromSteady(t0));
+        REQUIRE(p.extractFrames().empty());
+        p.feed(frame.data(), frame.size(), RxTimestamp::fromSteady(t0 + chrono::milliseconds(300)));
+        auto results = p.extractFrames();
+        REQUIRE(results.size() == 2);
+        REQUIRE(results[0].error_detail.code == ParseError::Stale);
+        REQUIRE(results[1].status == ParseStatus::Success);
+    }
+
+    SECTION("Never without timestamps") {
+        p.setTimestampCapture(false);
+        p.feed(frame.data(), 4);
+        REQUIRE(p.extractFrames().empty());
+        this_thread::sleep_for(chrono::milliseconds(250));
+        p.feed(frame.data(), frame.size());
+        auto results = p.extractFrames();
+        REQUIRE(results.size() == 2);
+        REQUIRE(results[0].error_detail.code == ParseError::BadEndMarker);
+        REQUIRE(results[1].status == ParseStatus::Success);
+    }
+}
+
 TEST_CASE("Frame with incorrect end marker") {
     VdpParser p;
     auto frame = makeFrame(0x01, 0x10, {});
@@ -254,7 +330,7 @@ TEST_CASE("Frame with incorrect end marker") {
     auto results = feedAll(p, input);
     REQUIRE(results.size() == 2);
     REQUIRE(results[0].status == ParseStatus::Invalid);
-    REQUIRE(results[0].error.find("End marker not found") != string::npos);
+    REQUIRE(results[0].message().find("End marker not found") != string::npos);
     REQUIRE(results[1].status == ParseStatus::Success);
     REQUIRE(results[1].frame->ecu_id == 0x02);
 }
@@ -359,3 +435,413 @@ TEST_CASE("Thread safety with concurrent feed and extract") {
         REQUIRE(consumed_frames[i].data == produced_frames[i].data);
     }
 }
+
+TEST_CASE("Buffer compaction and growth keep frames intact") {
+    VdpParser p;
+    vector<uint8_t> stream;
+    const int num_frames = 100;
+    for (int i = 0; i < num_frames; ++i) {
+        vector<uint8_t> payload(200, static_cast<uint8_t>(i));
+        auto frame = makeFrame(0x81, 0x10, payload);
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    // Odd chunk sizes force partial frames to be slid forward on each feed,
+    // and the oversized chunk forces the buffer to grow.
+    const size_t chunk_sizes[] = {3, 517, 9000, 61};
+    int parsed = 0;
+    size_t offset = 0;
+    for (size_t k = 0; offset < stream.size(); ++k) {
+        size_t n = std::min(chunk_sizes[k % 4], stream.size() - offset);
+        p.feed(stream.data() + offset, n);
+        offset += n;
+        for (const auto& res : p.extractFrames()) {
+            REQUIRE(res.status == ParseStatus::Success);
+            REQUIRE(res.frame->data == vector<uint8_t>(200, static_cast<uint8_t>(parsed)));
+            ++parsed;
+        }
+    }
+    REQUIRE(parsed == num_frames);
+}
+
+TEST_CASE("Bytes can be received in place with prepareWrite") {
+    const auto frame = makeFrame(0x81, 0x10, {0x01, 0x02, 0x03});
+    vector<uint8_t> stream;
+    for (int i = 0; i < 4; ++i) {
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    SECTION("Locked mode") {
+        VdpParser p;
+        // Fill less than was lent, including an empty commit
+        auto lease = p.prepareWrite(4096);
+        REQUIRE(lease.size() >= 4096);
+        std::memcpy(lease.data(), stream.data(), 5);
+        lease.commit(5);
+        REQUIRE_FALSE(lease);
+        p.prepareWrite(4096).commit(0);
+        REQUIRE(p.extractFrames().empty());
+
+        lease = p.prepareWrite(stream.size());
+        std::memcpy(lease.data(), stream.data() + 5, stream.size() - 5);
+        lease.commit(stream.size() - 5, RxTimestamp{42});
+        auto results = p.extractFrames();
+        REQUIRE(results.size() == 4);
+        REQUIRE(results[3].raw_bytes == frame);
+        REQUIRE(results[3].timestamp.ticks == 42);
+    }
+
+    SECTION("A lease does not block the consumer") {
+        VdpParser p;
+        p.feed(frame.data(), frame.size());
+        auto lease = p.prepareWrite(frame.size());
+        std::memcpy(lease.data(), frame.data(), frame.size());
+        // Draining the buffer and a reset leave the lent bytes in place
+        REQUIRE(p.extractFrames().size() == 1);
+        p.reset();
+        lease.commit(frame.size());
+        auto results = p.extractFrames();
+        REQUIRE(results.size() == 1);
+        REQUIRE(results[0].raw_bytes == frame);
+    }
+
+    SECTION("A dropped lease feeds nothing and frees the producer side") {
+        VdpParser p;
+        {
+            auto lease = p.prepareWrite(16);
+            std::memcpy(lease.data(), frame.data(), frame.size());
+        }
+        VdpParser::WriteLease moved = p.prepareWrite(16);
+        VdpParser::WriteLease lease = std::move(moved);
+        moved.commit(16);   // empty, does nothing
+        lease.release();
+        REQUIRE(p.extractFrames().empty());
+
+        p.feed(frame.data(), frame.size());
+        auto results = p.extractFrames();
+        REQUIRE(results.size() == 1);
+        REQUIRE(results[0].status == ParseStatus::Success);
+    }
+
+    SECTION("Spsc mode across the feed ring's wrap point") {
+        VdpParser p(std::chrono::seconds(1), ConcurrencyMode::Spsc);
+        const auto large = makeFrame(0x81, 0x10, vector<uint8_t>(200, 0x55));
+        // Partly filled 4096-byte regions walk the ring's write index through
+        // several wraps (~160KB in total), so some requests have to be staged
+        size_t parsed = 0;
+        for (int round = 0; round < 800; ++round) {
+            auto lease = p.prepareWrite(4096);
+            std::memcpy(lease.data(), large.data(), large.size());
+            lease.commit(large.size());
+            for (const auto& res : p.extractFrames()) {
+                REQUIRE(res.status == ParseStatus::Success);
+                REQUIRE(res.raw_bytes == large);
+                ++parsed;
+            }
+        }
+        REQUIRE(parsed == 800);
+    }
+}
+
+TEST_CASE("Zero-copy frame views borrow from the parser buffer") {
+    VdpParser p;
+    auto valid = makeFrame(0x81, 0x10, {0x00, 0x7E, 0x7F});
+    vector<uint8_t> bad_checksum = makeFrame(0x82, 0x20, {0x01});
+    bad_checksum[bad_checksum.size() - 2] ^= 0xFF;
+
+    vector<uint8_t> input = {0xDE, 0xAD};
+    input.insert(input.end(), bad_checksum.begin(), bad_checksum.end());
+    input.insert(input.end(), valid.begin(), valid.end());
+    p.feed(input.data(), input.size());
+
+    vector<ParseStatus> statuses;
+    vector<VdpFrame> frames;
+    vector<vector<uint8_t>> raws;
+    size_t count = p.extractFrameViews([&](const ParseResultView& view) {
+        statuses.push_back(view.status);
+        raws.emplace_back(view.raw_bytes.begin(), view.raw_bytes.end());
+        if (view.status == ParseStatus::Success) {
+            frames.push_back(view.frame.toFrame());
+        }
+    });
+
+    REQUIRE(count == 2);
+    REQUIRE(statuses == vector<ParseStatus>{ParseStatus::Invalid, ParseStatus::Success});
+    REQUIRE(raws[0] == bad_checksum);
+    REQUIRE(raws[1] == valid);
+    REQUIRE(frames.size() == 1);
+    REQUIRE(frames[0].ecu_id == 0x81);
+    REQUIRE(frames[0].command == 0x10);
+    REQUIRE(frames[0].data == vector<uint8_t>{0x00, 0x7E, 0x7F});
+
+    // Everything was consumed
+    REQUIRE(p.extractFrameViews([](const ParseResultView&) {}) == 0);
+    REQUIRE(p.extractFrames().empty());
+}
+
+TEST_CASE("Parse errors carry fixed-size details") {
+    VdpParser p;
+    vector<uint8_t> bad_length = {0x7E, 0x03};
+    auto bad_checksum = makeFrame(0x84, 0x10, {0x11, 0x22});
+    bad_checksum[bad_checksum.size() - 2] = 0x00;
+    auto bad_end = makeFrame(0x01, 0x10, {});
+    bad_end.back() = 0x7D;
+
+    vector<uint8_t> input = {0xAA};
+    input.insert(input.end(), bad_length.begin(), bad_length.end());
+    input.insert(input.end(), bad_checksum.begin(), bad_checksum.end());
+    input.insert(input.end(), bad_end.begin(), bad_end.end());
+    auto results = feedAll(p, input);
+
+    REQUIRE(results.size() == 3);
+    REQUIRE(results[0].error_detail.code == ParseError::BadLength);
+    REQUIRE(results[0].error_detail.length == 0x03);
+    REQUIRE(results[0].error_detail.offset == 1);
+    REQUIRE(results[0].error.empty()); // formatted lazily
+    REQUIRE(results[0].message() == "Invalid frame length: 3");
+
+    REQUIRE(results[1].error_detail.code == ParseError::BadChecksum);
+    REQUIRE(results[1].error_detail.calculated == 0xAF);
+    REQUIRE(results[1].error_detail.expected == 0x00);
+    REQUIRE(results[1].error_detail.offset == 3);
+    REQUIRE(results[1].message() == "Checksum verification failed: calculated=0xaf, expected=0x0");
+
+    REQUIRE(results[2].error_detail.code == ParseError::BadEndMarker);
+    REQUIRE(results[2].error_detail.position == 5);
+    REQUIRE(results[2].message() == "End marker not found at position: 5");
+}
+
+TEST_CASE("Error detail capture can be disabled") {
+    VdpParser p;
+    p.setErrorDetailCapture(false);
+    auto frame = makeFrame(0x84, 0x10, {0x11, 0x22});
+    frame[frame.size() - 2] ^= 0xFF;
+
+    auto results = feedAll(p, frame);
+    REQUIRE(results.size() == 1);
+    REQUIRE(results[0].status == ParseStatus::Invalid);
+    REQUIRE(results[0].error_detail.code == ParseError::BadChecksum);
+    REQUIRE(results[0].error_detail.calculated == 0);
+    REQUIRE(results[0].error_detail.expected == 0);
+    REQUIRE(results[0].raw_bytes.empty());
+    // The zeroed fields are not printed as if they had been read
+    REQUIRE(results[0].message() == "Checksum verification failed");
+}
+
+TEST_CASE("Runs of rejected candidates can be coalesced and capped") {
+    // A corrupted frame whose DATA holds three more false starts (LEN 1)
+    auto bad = makeFrame(0x82, 0x10, {0x7E, 0x01, 0x7E, 0x01, 0x7E, 0x01});
+    bad[bad.size() - 2] ^= 0xFF;
+    auto good = makeFrame(0x81, 0x10, {0x05});
+    vector<uint8_t> stream = {0xAA};
+    stream.insert(stream.end(), bad.begin(), bad.end());
+    stream.insert(stream.end(), good.begin(), good.end());
+    stream.insert(stream.end(), bad.begin(), bad.end());
+
+    VdpParser p;
+    SECTION("Every candidate is reported by default") {
+        auto results = feedAll(p, stream);
+        REQUIRE(results.size() == 9);
+        REQUIRE(results[0].error_detail.code == ParseError::BadChecksum);
+        REQUIRE(results[1].error_detail.code == ParseError::BadLength);
+        REQUIRE(results[4].status == ParseStatus::Success);
+    }
+
+    SECTION("Coalesced into one result per run") {
+        p.setInvalidCoalescing(true);
+        auto results = feedAll(p, stream);
+        REQUIRE(results.size() == 3);
+        REQUIRE(results[0].status == ParseStatus::Invalid);
+        REQUIRE(results[0].error_detail.code == ParseError::BadChecksum);
+        REQUIRE(results[0].error_detail.coalesced == 3);
+        REQUIRE(results[0].error_detail.offset == 1);
+        REQUIRE(results[0].error_detail.run_length == bad.size());
+        REQUIRE(results[0].raw_bytes == bad);
+        REQUIRE(results[0].message().find("(and 3 more invalid candidates)") != string::npos);
+        REQUIRE(results[1].status == ParseStatus::Success);
+        REQUIRE(results[2].error_detail.coalesced == 3);
+        REQUIRE(results[2].raw_bytes == bad);
+        if (metrics::ENABLED) {
+            REQUIRE(p.metrics().invalidTotal() == 8);
+        }
+    }
+
+    SECTION("Capped per extract call") {
+        p.setInvalidResultLimit(1);
+        auto results = feedAll(p, stream);
+        REQUIRE(results.size() == 2);
+        REQUIRE(results[0].error_detail.code == ParseError::BadChecksum);
+        REQUIRE(results[1].status == ParseStatus::Success);
+        if (metrics::ENABLED) {
+            REQUIRE(p.metrics().invalidTotal() == 8);
+        }
+
+        // The count restarts with the next call
+        auto more = feedAll(p, bad);
+        REQUIRE(more.size() == 1);
+    }
+}
+
+TEST_CASE("Results are stamped once per feed") {
+    VdpParser p;
+    auto frame1 = makeFrame(0x81, 0x10, {0x01});
+    auto frame2 = makeFrame(0x82, 0x10, {0x02});
+    vector<uint8_t> both = frame1;
+    both.insert(both.end(), frame2.begin(), frame2.end());
+
+    SECTION("Taken by feed()") {
+        const RxTimestamp before = RxTimestamp::now();
+        auto results = feedAll(p, both);
+        REQUIRE(results.size() == 2);
+        REQUIRE(results[0].timestamp.valid());
+        REQUIRE(results[0].timestamp == results[1].timestamp);
+        REQUIRE(results[0].timestamp.ticks >= before.ticks);
+        REQUIRE(results[0].timestamp.toSystem() <= chrono::system_clock::now());
+    }
+
+    SECTION("Supplied by the transport") {
+        const RxTimestamp received = RxTimestamp::fromSteady(chrono::steady_clock::now() - chrono::seconds(5));
+        p.feed(both.data(), both.size(), received);
+        InlineParseResult inline_results[2];
+        REQUIRE(p.extractFrames(inline_results, 2) == 2);
+        REQUIRE(inline_results[0].timestamp == received);
+        REQUIRE(inline_results[1].timestamp == received);
+    }
+
+    SECTION("A partial frame is stamped by the feed that completes it") {
+        p.feed(frame1.data(), 3, RxTimestamp{100});
+        REQUIRE(p.extractFrames().empty());
+        p.feed(frame1.data() + 3, frame1.size() - 3, RxTimestamp{200});
+        auto results = p.extractFrames();
+        REQUIRE(results.size() == 1);
+        REQUIRE(results[0].timestamp.ticks == 200);
+    }
+
+    SECTION("Disabled") {
+        p.setTimestampCapture(false);
+        p.feed(both.data(), both.size(), RxTimestamp::now());
+        size_t count = p.extractFrameViews([](const ParseResultView& view) {
+            REQUIRE_FALSE(view.timestamp.valid());
+        });
+        REQUIRE(count == 2);
+    }
+}
+
+TEST_CASE("Batched extraction reuses caller-provided storage") {
+    VdpParser p;
+    ParseBatch batch(4, 64);
+
+    auto frame1 = makeFrame(0x81, 0x10, {0x00, 0x12});
+    auto frame2 = makeFrame(0x82, 0x20, vector<uint8_t>(100, 0x55));
+    vector<uint8_t> bad = {0x7E, 0x02};
+
+    vector<uint8_t> input = frame1;
+    input.insert(input.end(), bad.begin(), bad.end());
+    input.insert(input.end(), frame2.begin(), frame2.end());
+    p.feed(input.data(), input.size());
+
+    REQUIRE(p.extractFrames(batch) == 3);
+    REQUIRE(batch[0].status == ParseStatus::Success);
+    REQUIRE(batch[0].frame.toFrame().data == vector<uint8_t>{0x00, 0x12});
+    REQUIRE(vector<uint8_t>(batch[0].raw_bytes.begin(), batch[0].raw_bytes.end()) == frame1);
+    REQUIRE(batch[1].status == ParseStatus::Invalid);
+    REQUIRE(batch[1].error.code == ParseError::BadLength);
+    REQUIRE(batch[2].frame.ecu_id == 0x82);
+    REQUIRE(batch[2].frame.toFrame().data == vector<uint8_t>(100, 0x55));
+
+    // Refilling clears previous results but keeps the storage
+    p.feed(frame1.data(), frame1.size());
+    REQUIRE(p.extractFrames(batch) == 1);
+    REQUIRE(batch.size() == 1);
+    REQUIRE(batch.descriptor(0).ecu_id == 0x81);
+    REQUIRE(batch.descriptor(0).raw_offset == 0);
+
+    REQUIRE(p.extractFrames(batch) == 0);
+    REQUIRE(batch.empty());
+}
+
+TEST_CASE("serializeFrame output round-trips through the parser") {
+    VdpParser p;
+    VdpFrame frame{0x01, 0x10, {0x00, 0x01}};
+    vector<uint8_t> bytes;
+    p.serializeFrame(frame, bytes);
+
+    // Spec example: 7E 08 01 10 00 01 18 7F
+    REQUIRE(bytes == vector<uint8_t>{0x7E, 0x08, 0x01, 0x10, 0x00, 0x01, 0x18, 0x7F});
+    auto res = feedAll(p, bytes);
+    REQUIRE(res.size() == 1);
+    REQUIRE(res[0].status == ParseStatus::Success);
+    REQUIRE(res[0].frame->data == frame.data);
+}
+
+TEST_CASE("serializeInto and serializeSlices match serializeFrame") {
+    VdpParser p;
+    for (size_t data_len : {size_t(0), size_t(2), size_t(31), size_t(247)}) {
+        INFO("data length: " << data_len);
+        VdpFrame frame{0x01, 0x10, vector<uint8_t>(data_len)};
+        for (size_t i = 0; i < data_len; ++i) {
+            frame.data[i] = static_cast<uint8_t>(i * 7 + 3);
+        }
+        vector<uint8_t> expected;
+        p.serializeFrame(frame, expected);
+
+        uint8_t out[MAX_SERIALIZED_FRAME_SIZE];
+        size_t n = p.serializeInto(frame, out, sizeof(out));
+        REQUIRE(n == expected.size());
+        REQUIRE(vector<uint8_t>(out, out + n) == expected);
+
+        // One byte short of the frame writes nothing
+        REQUIRE(p.serializeInto(frame, out, n - 1) == 0);
+
+        FrameSlices slices;
+        REQUIRE(p.serializeSlices(frame, slices));
+        REQUIRE(slices.size() == expected.size());
+        REQUIRE(slices.payload.data == frame.data.data());
+        vector<uint8_t> joined(slices.header, slices.header + sizeof(slices.header));
+        joined.insert(joined.end(), slices.payload.begin(), slices.payload.end());
+        joined.insert(joined.end(), slices.footer, slices.footer + sizeof(slices.footer));
+        REQUIRE(joined == expected);
+    }
+
+    // Data beyond the protocol maximum is rejected by every variant
+    VdpFrame too_large{0x01, 0x10, vector<uint8_t>(248)};
+    uint8_t big[512];
+    FrameSlices slices;
+    REQUIRE(p.serializeInto(too_large, big, sizeof(big)) == 0);
+    REQUIRE_FALSE(p.serializeSlices(too_large, slices));
+    vector<uint8_t> bytes;
+    REQUIRE_THROWS_AS(p.serializeFrame(too_large, bytes), runtime_error);
+}
+
+TEST_CASE("Lock-free SPSC mode with concurrent feed and extract") {
+    VdpParser parser(std::chrono::seconds(1), ConcurrencyMode::Spsc);
+    const int num_frames = 3000; // ~100KB, more than the feed ring holds
+
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < num_frames; ++i) {
+        frames.push_back(makeFrame(static_cast<uint8_t>(i), 0x10, vector<uint8_t>(i % 50, static_cast<uint8_t>(i))));
+    }
+
+    std::thread producer([&]() {
+        // Feed in uneven slices so frames straddle ring wrap-around points
+        for (const auto& frame : frames) {
+            size_t split = frame.size() / 3;
+            parser.feed(frame.data(), split);
+            parser.feed(frame.data() + split, frame.size() - split);
+        }
+    });
+
+    int frames_found = 0;
+    bool intact = true;
+    while (frames_found < num_frames) {
+        for (const auto& res : parser.extractFrames()) {
+            intact = intact && res.status == ParseStatus::Success && res.raw_bytes == frames[frames_found];
+            frames_found++;
+        }
+    }
+    producer.join();
+
+    REQUIRE(intact);
+    REQUIRE(frames_found == num_frames);
+    REQUIRE(parser.extractFrames().empty());
+}
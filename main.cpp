@@ -1,5 +1,12 @@
+#include "capture_file.h"
+#include "frame_log.h"
+#include "parallel_parse.h"
 #include "vdp_parser.h"
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -37,8 +44,8 @@ std::vector<uint8_t> hexLineToBytes(const std::string& line_in) {
     return bytes;
 }
 
-int main(int argc, char* argv[]) {
-    std::string path = (argc >= 2) ? argv[1] : "sample_frames.hex";
+// Line-by-line mode for small hand-written .hex files
+int printHexFile(const std::string& path) {
     std::ifstream in(path);
     if (!in) {
         std::cerr << "Failed to open file: " << path << "\n";
@@ -64,16 +71,16 @@ int main(int argc, char* argv[]) {
                     std::cout << std::hex << std::uppercase << std::setw(2) << std::setfill('0')
                               << (int)b << " ";
                 }
-                std::cout << std::dec << std::endl;
+                std::cout << std::dec << '\n';
 
                 std::cout << "Status: ";
                 switch (r.status) {
                 case vdp::ParseStatus::Success: {
-                    std::cout << "Valid frame" << std::endl;
+                    std::cout << "Valid frame" << '\n';
                     break;
                 }
                 case vdp::ParseStatus::Invalid: {
-                    std::cout << "ERROR. Reason: " << r.error << std::endl;
+                    std::cout << "ERROR. Reason: " << r.message() << '\n';
                     break;
                 }
                 default: {
@@ -81,10 +88,259 @@ int main(int argc, char* argv[]) {
                     break;
                 }
                 }
-                std::cout << std::endl; // Add a blank line for readability
+                std::cout << '\n'; // Add a blank line for readability
+            }
+        }
+    }
+
+    return 0;
+}
+
+// stdout writer that flushes in large blocks
+class OutputBuffer {
+public:
+    explicit OutputBuffer(size_t capacity = 1 << 16) { buffer_.reserve(capacity); }
+    ~OutputBuffer() { flush(); }
+
+    void append(const char* text, size_t length) {
+        if (buffer_.size() + length > buffer_.capacity()) {
+            flush();
+        }
+        buffer_.append(text, length);
+    }
+    void append(const std::string& text) { append(text.data(), text.size()); }
+    void append(const char* text) { append(text, std::strlen(text)); }
+
+    // Formatted through a fixed stack buffer in 256-byte slices, any span length fits
+    void appendHex(vdp::ByteSpan bytes) {
+        static const char DIGITS[] = "0123456789ABCDEF";
+        constexpr size_t SLICE = 256;
+        char text[3 * SLICE];
+        for (size_t offset = 0; offset < bytes.size; offset += SLICE) {
+            const vdp::ByteSpan slice = bytes.subspan(offset, std::min(SLICE, bytes.size - offset));
+            size_t length = 0;
+            for (uint8_t b : slice) {
+                text[length++] = DIGITS[b >> 4];
+                text[length++] = DIGITS[b & 0x0F];
+                text[length++] = ' ';
+            }
+            append(text, length);
+        }
+    }
+
+    void flush() {
+        std::fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+        buffer_.clear();
+    }
+
+private:
+    std::string buffer_;
+};
+
+struct ReplayOptions {
+    std::string path;
+    bool summary_only = false;    // counts and throughput only, no per-frame output
+    size_t chunk = 1 << 20;       // bytes passed to feed() at once
+    size_t threads = 1;           // >1 or 0 (all cores): parallelParseViews() over the whole capture
+    std::string record_path;      // write every result to this frame log
+    bool compress = false;        // LZ4 frame log
+};
+
+/**
+ * Replay a capture: a binary capture (see capture_file.h) is mapped and fed
+ * to the parser straight from the mapping; anything else is decoded as
+ * legacy .hex text first. The results recorded in a frame log are reported
+ * as recorded. Prints the same per-frame report as the line mode, or only a
+ * summary, and the throughput on stderr.
+ */
+int replay(const ReplayOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+
+    vdp::MappedFile file;
+    std::string error;
+    if (!file.open(options.path, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    vdp::ByteSpan payload;
+    uint16_t flags = 0;
+    std::vector<uint8_t> decoded;
+    const bool binary = vdp::parseCaptureHeader(file.bytes(), payload, &flags);
+    if (!binary) {
+        vdp::decodeHex(file.bytes(), decoded);
+        payload = {decoded.data(), decoded.size()};
+    }
+
+    vdp::FrameLogWriter recorder;
+    if (!options.record_path.empty()) {
+        vdp::FrameLogConfig config;
+        config.compress = options.compress;
+        if (!recorder.open(options.record_path, config, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+    bool failed = false;
+    // Taken once per chunk fed, frame logs carry their own
+    auto timestamp = std::chrono::system_clock::now();
+
+    vdp::VdpParser parser;
+    parser.setErrorDetailCapture(!options.summary_only || !options.record_path.empty());
+    // Offline: wall-clock gaps between chunks (e.g. a blocked stdout) must not make frames Stale
+    parser.setTimestampCapture(false);
+    OutputBuffer out;
+    uint64_t valid = 0;
+    uint64_t invalid = 0;
+    uint64_t errors[vdp::PARSE_ERROR_COUNT] = {};   // by ParseError
+
+    auto report = [&](const vdp::ParseResultView& result) {
+        if (result.status == vdp::ParseStatus::Success) {
+            ++valid;
+        } else if (result.status == vdp::ParseStatus::Invalid) {
+            ++invalid;
+            ++errors[static_cast<size_t>(result.error.code)];
+        }
+        recorder.record(result, timestamp);
+        if (options.summary_only) {
+            return;
+        }
+        out.append("Raw bytes: ");
+        out.appendHex(result.raw_bytes);
+        if (result.status == vdp::ParseStatus::Success) {
+            out.append("\nStatus: Valid frame\n\n");
+        } else if (result.status == vdp::ParseStatus::Invalid) {
+            out.append("\nStatus: ERROR. Reason: ");
+            out.append(vdp::describeParseError(result.error));
+            out.append("\n\n");
+        } else {
+            out.append("\n\n");
+        }
+    };
+
+    if (flags & vdp::CaptureHeader::FRAME_LOG) {
+        // Parsing a record's raw bytes again restores the details of its result. The
+        // recorded error covers what the bytes do not show: a Stale candidate is only
+        // a partial frame, and a coalesced run only its first candidate.
+        vdp::FrameLogReader reader(payload, flags);
+        vdp::FrameLogRecord record;
+        vdp::ParseResultView result;
+        while (reader.next(record)) {
+            timestamp = record.timestamp;
+            const vdp::ParseStatus status = vdp::VdpParser::parseCandidate(record.raw_bytes, result);
+            if (record.error != vdp::ParseError::None) {
+                if (status != vdp::ParseStatus::Invalid || result.error.code != record.error) {
+                    result = {};
+                    result.error.code = record.error;
+                    result.error.length = static_cast<uint8_t>(record.raw_bytes.size);
+                    result.raw_bytes = record.raw_bytes;
+                }
+                result.error.coalesced = record.coalesced;
+            } else if (status == vdp::ParseStatus::Incomplete) {
+                continue;
             }
+            report(result);
+        }
+        if (!reader.error().empty()) {
+            std::cerr << options.path << ": " << reader.error() << "\n";
+            failed = true;
+        }
+    } else if (options.threads != 1) {
+        // Identical results, the views borrow from the mapping
+        for (const auto& result : vdp::parallelParseViews(payload, options.threads)) {
+            report(result);
         }
+    } else {
+        for (size_t offset = 0; offset < payload.size; offset += options.chunk) {
+            const vdp::ByteSpan chunk = payload.subspan(offset, std::min(options.chunk, payload.size - offset));
+            timestamp = std::chrono::system_clock::now();
+            parser.feed(chunk.data, chunk.size);
+            parser.extractFrameViews(report);
+        }
+    }
+    out.flush();
+    recorder.close();
+    if (!recorder.getLastError().empty()) {
+        std::cerr << recorder.getLastError() << "\n";
+        failed = true;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double megabytes = static_cast<double>(file.bytes().size) / (1024.0 * 1024.0);
+    std::fprintf(stderr, "%s: %.1f MB %s, %llu valid frames, %llu invalid "
+                         "(length %llu, end marker %llu, checksum %llu, truncated %llu, stale %llu)\n",
+                 options.path.c_str(), megabytes,
+                 !binary ? "hex" : (flags & vdp::CaptureHeader::FRAME_LOG) ? "frame log" : "binary",
+                 static_cast<unsigned long long>(valid), static_cast<unsigned long long>(invalid),
+                 static_cast<unsigned long long>(errors[static_cast<size_t>(vdp::ParseError::BadLength)]),
+                 static_cast<unsigned long long>(errors[static_cast<size_t>(vdp::ParseError::BadEndMarker)]),
+                 static_cast<unsigned long long>(errors[static_cast<size_t>(vdp::ParseError::BadChecksum)]),
+                 static_cast<unsigned long long>(errors[static_cast<size_t>(vdp::ParseError::Truncated)]),
+                 static_cast<unsigned long long>(errors[static_cast<size_t>(vdp::ParseError::Stale)]));
+    std::fprintf(stderr, "%.3f s, %.1f MB/s\n", seconds, seconds > 0 ? megabytes / seconds : 0.0);
+    return failed ? 1 : 0;
+}
+
+// Convert a legacy .hex file into a binary capture
+int convert(const std::string& in_path, const std::string& out_path) {
+    vdp::MappedFile file;
+    std::string error;
+    if (!file.open(in_path, error)) {
+        std::cerr << error << "\n";
+        return 1;
     }
+    std::vector<uint8_t> bytes = vdp::makeCaptureHeader();
+    vdp::decodeHex(file.bytes(), bytes);
 
+    std::ofstream out(out_path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+        std::cerr << "Failed to write file: " << out_path << "\n";
+        return 1;
+    }
     return 0;
 }
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [file.hex]\n"
+              << "       " << program << " --replay [--summary] [--chunk BYTES] [--threads N] [--record LOG [--lz4]] <capture>\n"
+              << "       " << program << " --convert <in.hex> <out.vdpcap>\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::strcmp(argv[1], "--replay") == 0) {
+        ReplayOptions options;
+        for (int i = 2; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--summary") == 0) {
+                options.summary_only = true;
+            } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+                options.record_path = argv[++i];
+            } else if (std::strcmp(argv[i], "--lz4") == 0) {
+                options.compress = true;
+            } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                options.threads = std::strtoull(argv[++i], nullptr, 10);
+            } else if (std::strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) {
+                options.chunk = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+            } else {
+                options.path = argv[i];
+            }
+        }
+        if (options.path.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return replay(options);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--convert") == 0) {
+        if (argc != 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return convert(argv[2], argv[3]);
+    }
+    if (argc >= 2 && argv[1][0] == '-') {
+        printUsage(argv[0]);
+        return 1;
+    }
+    return printHexFile((argc >= 2) ? argv[1] : "sample_frames.hex");
+}
@@ -77,5 +77,47 @@ public:
 extern "C" IProtocolEngine* createProtocolEngine();
 extern "C" void destroyProtocolEngine(IProtocolEngine* engine);
 
+// Batched interface: one call per batch instead of one per frame, for
+// bindings (JNI, Swift) where crossing the boundary dominates the cost.
+//
+// Requests are submitted as back-to-back [ECU_ID][CMD][DATA_LEN][DATA...]
+// records in one flat buffer. Each response is written, as it completes,
+// into a ring of fixed-size records in caller memory, which the caller polls
+// without further calls: load head with acquire semantics (e.g.
+// __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)), read the records from
+// tail up to head at index & (capacity - 1), then store the new tail with
+// release semantics.
+
+// One completed request, 256 bytes
+struct CompletionRecord {
+    uint32_t request_id;    // submitFrameBatch()'s first_request_id + index in the batch
+    uint8_t status;         // Status
+    uint8_t ecu_id;
+    uint8_t command;
+    uint8_t data_length;
+    uint8_t data[248];
+};
+
+// Completion ring in caller memory: zero-initialize, then attach it
+struct CompletionRing {
+    CompletionRecord* records;  // capacity records
+    uint32_t capacity;          // power of two
+    uint32_t head;              // written by the engine: records published, wraps around
+    uint32_t tail;              // written by the caller: records consumed, wraps around
+};
+
+// Attach the ring completions are written to (nullptr detaches). Fails while
+// batch requests are in flight. The ring must outlive the engine or the
+// next attachCompletionRing() call.
+extern "C" bool attachCompletionRing(IProtocolEngine* engine, CompletionRing* ring);
+
+// Queue the requests in the buffer, with the engine's default timeout.
+// Only as many requests are accepted as the ring has room for, counting
+// those still in flight, so no completion is ever dropped; resubmit the rest
+// after polling. Returns the number accepted, or -1 if no ring is attached
+// or the buffer is malformed (nothing is sent then, see getLastError()).
+extern "C" int32_t submitFrameBatch(IProtocolEngine* engine, const uint8_t* requests, size_t length,
+                                    uint32_t* first_request_id);
+
 } // namespace protocol
 } // namespace carly
\ No newline at end of file